@@ -94,6 +94,20 @@ static uint8_t *stringprint(uint8_t *p, const char *s, uint16_t maxlen=0) {
 }
 
 
+// FNV-1a, case folded because topics are matched case insensitively
+static uint32_t topicHash(const char *topic, uint16_t len) {
+  uint32_t hash = 2166136261UL;
+  for (uint16_t i=0; i<len; i++) {
+    // ASCII only, like strncasecmp() in the C locale, without a call per byte
+    uint8_t c = topic[i];
+    if (c >= 'A' && c <= 'Z')
+      c += 'a' - 'A';
+    hash ^= c;
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
 // Adafruit_MQTT Definition ////////////////////////////////////////////////////
 
 Adafruit_MQTT::Adafruit_MQTT(const char *server,
@@ -111,6 +125,7 @@ Adafruit_MQTT::Adafruit_MQTT(const char *server,
   for (uint8_t i=0; i<MAXSUBSCRIPTIONS; i++) {
     subscriptions[i] = 0;
   }
+  rebuildSubTable();
 
   will_topic = 0;
   will_payload = 0;
@@ -119,6 +134,16 @@ Adafruit_MQTT::Adafruit_MQTT(const char *server,
 
   packet_id_counter = 0;
 
+  for (uint8_t i=0; i<MQTT_INFLIGHT_MAX; i++) {
+    inflight_packets[i].used = false;
+  }
+  publish_window = 0;
+  acked_count = 0;
+  batching = false;
+  batch_len = 0;
+  held_count = 0;
+  ping_pending = false;
+
 }
 
 
@@ -136,6 +161,7 @@ Adafruit_MQTT::Adafruit_MQTT(const char *server,
   for (uint8_t i=0; i<MAXSUBSCRIPTIONS; i++) {
     subscriptions[i] = 0;
   }
+  rebuildSubTable();
 
   will_topic = 0;
   will_payload = 0;
@@ -144,6 +170,16 @@ Adafruit_MQTT::Adafruit_MQTT(const char *server,
 
   packet_id_counter = 0;
 
+  for (uint8_t i=0; i<MQTT_INFLIGHT_MAX; i++) {
+    inflight_packets[i].used = false;
+  }
+  publish_window = 0;
+  acked_count = 0;
+  batching = false;
+  batch_len = 0;
+  held_count = 0;
+  ping_pending = false;
+
 }
 
 int8_t Adafruit_MQTT::connect() {
@@ -152,18 +188,13 @@ int8_t Adafruit_MQTT::connect() {
     return -1;
 
   // Construct and send connect packet.
-  uint8_t len = connectPacket(buffer);
-  if (!sendPacket(buffer, len))
+  if (!sendConnectPacket())
     return -1;
 
   // Read connect response packet and verify it
-  len = readFullPacket(buffer, MAXBUFFERSIZE, CONNECT_TIMEOUT_MS);
-  if (len != 4)
-    return -1;
-  if ((buffer[0] != (MQTT_CTRL_CONNECTACK << 4)) || (buffer[1] != 2))
-    return -1;
-  if (buffer[3] != 0)
-    return buffer[3];
+  int8_t ret = connackResult(readFullPacket(buffer, MAXBUFFERSIZE, CONNECT_TIMEOUT_MS));
+  if (ret != 0)
+    return ret;
 
   // Setup subscriptions once connected.
   for (uint8_t i=0; i<MAXSUBSCRIPTIONS; i++) {
@@ -194,9 +225,42 @@ int8_t Adafruit_MQTT::connect() {
     if (! success) return -2; // failed to sub for some reason
   }
 
+  // Anything published before the connection dropped goes out again.
+  if (!resendInflight())
+    return -1;
+
   return 0;
 }
 
+bool Adafruit_MQTT::sendConnectPacket() {
+  // a ping left unanswered by the last connection doesn't carry over
+  ping_pending = false;
+  uint8_t len = connectPacket(buffer);
+  return sendPacket(buffer, len);
+}
+
+int8_t Adafruit_MQTT::connackResult(uint16_t len) {
+  if (len != 4)
+    return -1;
+  if ((buffer[0] != (MQTT_CTRL_CONNECTACK << 4)) || (buffer[1] != 2))
+    return -1;
+  return buffer[3];
+}
+
+int8_t Adafruit_MQTT::sendSubscriptions() {
+  int8_t sent = 0;
+
+  for (uint8_t i=0; i<MAXSUBSCRIPTIONS; i++) {
+    if (subscriptions[i] == 0) continue;
+
+    uint8_t len = subscribePacket(buffer, subscriptions[i]->topic, subscriptions[i]->qos);
+    if (!sendPacket(buffer, len))
+      return -1;
+    sent++;
+  }
+  return sent;
+}
+
 int8_t Adafruit_MQTT::connect(const char *user, const char *pass)
 {
   username = user;
@@ -211,10 +275,14 @@ uint16_t Adafruit_MQTT::processPacketsUntil(uint8_t *buffer, uint8_t waitforpack
     //DEBUG_PRINT("Packet read size: "); DEBUG_PRINTLN(len);
     // TODO: add subscription reading & call back processing here
 
+    // PUBACKs for windowed publishes can turn up while waiting for anything
+    if ((buffer[0] >> 4) == MQTT_CTRL_PUBACK)
+      handleAck(buffer, len);
+
     if ((buffer[0] >> 4) == waitforpackettype) {
       //DEBUG_PRINTLN(F("Found right packet")); 
       return len;
-    } else {
+    } else if ((buffer[0] >> 4) != MQTT_CTRL_PUBACK) {
       ERROR_PRINTLN(F("Dropped a packet"));
     }
   }
@@ -225,7 +293,7 @@ uint16_t Adafruit_MQTT::readFullPacket(uint8_t *buffer, uint16_t maxsize, uint16
   // will read a packet and Do The Right Thing with length
   uint8_t *pbuff = buffer;
 
-  uint8_t rlen;
+  uint16_t rlen;
 
   // read the packet type:
   rlen = readPacket(pbuff, 1, timeout);
@@ -234,38 +302,61 @@ uint16_t Adafruit_MQTT::readFullPacket(uint8_t *buffer, uint16_t maxsize, uint16
   DEBUG_PRINT(F("Packet Type:\t")); DEBUG_PRINTBUFFER(pbuff, rlen);
   pbuff++;
 
+  // the rest is already on its way, don't give up on it half read
+  if (timeout < PACKET_REST_TIMEOUT_MS)
+    timeout = PACKET_REST_TIMEOUT_MS;
+
+  // remaining length, 1 to 4 bytes of 7 bits each, least significant first
   uint32_t value = 0;
-  uint32_t multiplier = 1;
+  uint8_t shift = 0;
   uint8_t encodedByte;
 
   do {
+    if (shift > 21) {
+      DEBUG_PRINT(F("Malformed packet len\n"));
+      return packetCutShort();
+    }
     rlen = readPacket(pbuff, 1, timeout);
-    if (rlen != 1) return 0;
+    if (rlen != 1) return packetCutShort();
     encodedByte = pbuff[0]; // save the last read val
     pbuff++; // get ready for reading the next byte
-    uint32_t intermediate = encodedByte & 0x7F;
-    intermediate *= multiplier;
-    value += intermediate;
-    multiplier *= 128;
-    if (multiplier > (128UL*128UL*128UL)) {
-      DEBUG_PRINT(F("Malformed packet len\n"));
-      return 0;
-    }
+    value |= (uint32_t)(encodedByte & 0x7F) << shift;
+    shift += 7;
   } while (encodedByte & 0x80);
 
   DEBUG_PRINT(F("Packet Length:\t")); DEBUG_PRINTLN(value);
-  
-  if (value > (unsigned)(maxsize - (pbuff-buffer) - 1)) {
-      DEBUG_PRINTLN(F("Packet too big for buffer"));
-      rlen = readPacket(pbuff, (maxsize - (pbuff-buffer) - 1), timeout);
+
+  // keep a spare byte so the payload can be nul terminated in place
+  uint16_t room = maxsize - (pbuff - buffer) - 1;
+  if (value > room) {
+    DEBUG_PRINTLN(F("Packet too big for buffer"));
+    rlen = readPacket(pbuff, room, timeout);
+    if (rlen != room) return packetCutShort();
+    // throw away the rest so the next read starts on a packet boundary
+    uint8_t scratch[32];
+    uint32_t skip = value - rlen;
+    while (skip > 0) {
+      uint16_t n = readPacket(scratch, (skip < sizeof(scratch)) ? skip : sizeof(scratch), timeout);
+      if (n == 0) return packetCutShort();
+      skip -= n;
+    }
   } else {
     rlen = readPacket(pbuff, value, timeout);
+    if (rlen != value) return packetCutShort();
   }
   //DEBUG_PRINT(F("Remaining packet:\t")); DEBUG_PRINTBUFFER(pbuff, rlen);
 
   return ((pbuff - buffer)+rlen);
 }
 
+uint16_t Adafruit_MQTT::packetCutShort() {
+  // Whatever comes next would be read from the middle of this packet, and
+  // there's no finding the next packet boundary from there.
+  ERROR_PRINTLN(F("Packet cut short, dropping the connection"));
+  disconnectServer();
+  return 0;
+}
+
 const FLASH_STRING* Adafruit_MQTT::connectErrorString(int8_t code)
 {
    switch (code) {
@@ -299,6 +390,56 @@ bool Adafruit_MQTT::publish(const char *topic, const char *data, uint8_t qos) {
 }
 
 bool Adafruit_MQTT::publish(const char *topic, uint8_t *data, uint16_t bLen, uint8_t qos) {
+  // fixed header (up to 3 bytes at this size), topic, packet id, payload
+  if (3 + 2 + strlen(topic) + 2 + bLen > MAXBUFFERSIZE) {
+    ERROR_PRINTLN(F("Publish too big for buffer"));
+    return false;
+  }
+
+  // Windowed QoS 1, keep the packet for a retransmit and match its PUBACK later.
+  // One too big to keep is refused rather than sent the blocking way, which
+  // would stall the caller (and a whole batch) for up to PUBLISH_TIMEOUT_MS.
+  uint16_t needed = 3 + 2 + strlen(topic) + 2 + bLen;
+  if (qos > 0 && publish_window > 0 && needed > MQTT_INFLIGHT_PACKETSIZE) {
+    ERROR_PRINTLN(F("Publish too big for the publish window"));
+    return false;
+  }
+  if (qos > 0 && publish_window > 0) {
+    int8_t slot = freeInflightSlot();
+    if (slot < 0)
+      return false;
+
+    uint16_t len = publishPacket(inflight_packets[slot].packet, topic, data, bLen, qos);
+    inflight_packets[slot].packetid = packet_id_counter - 1;
+    inflight_packets[slot].len = len;
+    inflight_packets[slot].used = true;
+
+    // A failed write gives the slot back and the caller keeps the message, so
+    // it isn't sent twice by the caller and by resendInflight().
+    bool sent;
+    if (batching)
+      sent = queueBatch(inflight_packets[slot].packet, len);
+    else
+      sent = sendPacket(inflight_packets[slot].packet, len);
+    if (!sent) {
+      inflight_packets[slot].used = false;
+      return false;
+    }
+    return true;
+  }
+
+  // Fire and forget can ride along in the batch too.
+  if (batching && qos == 0) {
+    if (batch_len + needed > MAXBUFFERSIZE && !flushBatch())
+      return false;
+    batch_len += publishPacket(buffer + batch_len, topic, data, bLen, qos);
+    return true;
+  }
+
+  // Everything else waits for a reply in buffer, so send what's batched first.
+  if (batching && !flushBatch())
+    return false;
+
   // Construct and send publish packet.
   uint16_t len = publishPacket(buffer, topic, data, bLen, qos);
   if (!sendPacket(buffer, len))
@@ -326,6 +467,81 @@ bool Adafruit_MQTT::publish(const char *topic, uint8_t *data, uint16_t bLen, uin
   return true;
 }
 
+void Adafruit_MQTT::setPublishWindow(uint8_t n) {
+  publish_window = (n > MQTT_INFLIGHT_MAX) ? MQTT_INFLIGHT_MAX : n;
+}
+
+uint8_t Adafruit_MQTT::inflight() {
+  uint8_t count = 0;
+
+  for (uint8_t i=0; i<MQTT_INFLIGHT_MAX; i++) {
+    if (inflight_packets[i].used) count++;
+  }
+  return count;
+}
+
+int8_t Adafruit_MQTT::freeInflightSlot() {
+  int8_t slot = -1;
+
+  // Reading here could swallow a subscription message, so a full window just
+  // fails the publish until readSubscription() has picked up some PUBACKs.
+  if (inflight() >= publish_window)
+    return -1;
+  for (uint8_t i=0; i<MQTT_INFLIGHT_MAX && slot < 0; i++) {
+    if (!inflight_packets[i].used) slot = i;
+  }
+  return slot;
+}
+
+void Adafruit_MQTT::handleAck(uint8_t *packet, uint16_t len) {
+  if (len != 4)
+    return;
+  uint16_t packetid = (packet[2] << 8) | packet[3];
+  for (uint8_t i=0; i<MQTT_INFLIGHT_MAX; i++) {
+    if (inflight_packets[i].used && inflight_packets[i].packetid == packetid) {
+      inflight_packets[i].used = false;
+      acked_count++;
+      return;
+    }
+  }
+}
+
+bool Adafruit_MQTT::resendInflight() {
+  for (uint8_t i=0; i<MQTT_INFLIGHT_MAX; i++) {
+    if (!inflight_packets[i].used) continue;
+    inflight_packets[i].packet[0] |= 0x08;  // DUP
+    if (!queueBatch(inflight_packets[i].packet, inflight_packets[i].len))
+      return false;
+  }
+  return flushBatch();
+}
+
+void Adafruit_MQTT::beginBatch() {
+  batching = true;
+  batch_len = 0;
+}
+
+bool Adafruit_MQTT::endBatch() {
+  batching = false;
+  return flushBatch();
+}
+
+bool Adafruit_MQTT::queueBatch(uint8_t *packet, uint16_t len) {
+  if (batch_len + len > MAXBUFFERSIZE && !flushBatch())
+    return false;
+  memcpy(buffer + batch_len, packet, len);
+  batch_len += len;
+  return true;
+}
+
+bool Adafruit_MQTT::flushBatch() {
+  if (batch_len == 0)
+    return true;
+  uint16_t len = batch_len;
+  batch_len = 0;
+  return sendPacket(buffer, len);
+}
+
 bool Adafruit_MQTT::will(const char *topic, const char *payload, uint8_t qos, uint8_t retain) {
 
   if (connected()) {
@@ -356,6 +572,7 @@ bool Adafruit_MQTT::subscribe(Adafruit_MQTT_Subscribe *sub) {
       if (subscriptions[i] == 0) {
         DEBUG_PRINT(F("Added sub ")); DEBUG_PRINTLN(i);
         subscriptions[i] = sub;
+        rebuildSubTable();
         return true;
       }
     }
@@ -397,6 +614,7 @@ bool Adafruit_MQTT::unsubscribe(Adafruit_MQTT_Subscribe *sub) {
       }
 
       subscriptions[i] = 0;
+      rebuildSubTable();
       return true;
     }
 
@@ -413,33 +631,8 @@ void Adafruit_MQTT::processPackets(int16_t timeout) {
 
   while (elapsed < (uint32_t)timeout) {
     Adafruit_MQTT_Subscribe *sub = readSubscription(timeout - elapsed);
-    if (sub) {
-      //Serial.println("**** sub packet received");
-      if (sub->callback_uint32t != NULL) {
-	// huh lets do the callback in integer mode
-	uint32_t data = 0;
-	data = atoi((char *)sub->lastread);
-	//Serial.print("*** calling int callback with : "); Serial.println(data);
-	sub->callback_uint32t(data);
-      } 
-      else if (sub->callback_double != NULL) {
-	// huh lets do the callback in doublefloat mode
-	double data = 0;
-	data = atof((char *)sub->lastread);
-	//Serial.print("*** calling double callback with : "); Serial.println(data);
-	sub->callback_double(data);
-      }
-      else if (sub->callback_buffer != NULL) {
-	// huh lets do the callback in buffer mode
-	//Serial.print("*** calling buffer callback with : "); Serial.println((char *)sub->lastread);
-	sub->callback_buffer((char *)sub->lastread, sub->datalen);
-      }
-      else if (sub->callback_io != NULL) {
-        // huh lets do the callback in io mode
-        //Serial.print("*** calling io instance callback with : "); Serial.println((char *)sub->lastread);
-        ((sub->io_feed)->*(sub->callback_io))((char *)sub->lastread, sub->datalen);
-      }
-    }
+    if (sub)
+      dispatch(sub);
 
     // keep track over elapsed time
     endtime = millis();
@@ -450,56 +643,143 @@ void Adafruit_MQTT::processPackets(int16_t timeout) {
   }
 }
 
-Adafruit_MQTT_Subscribe *Adafruit_MQTT::readSubscription(int16_t timeout) {
-  uint16_t i, topiclen, datalen;
+uint8_t Adafruit_MQTT::dispatchPackets() {
+  uint8_t dispatched = 0;
+  uint16_t len;
+
+  // Messages held back during the handshake go first, in the order they came.
+  // PUBACKs and other replies are consumed on the way, only messages reach a callback
+  while ((len = takeHeldPacket()) > 0 || (len = readFullPacket(buffer, MAXBUFFERSIZE, 0)) > 0) {
+    Adafruit_MQTT_Subscribe *sub = parseSubscription(len);
+    if (sub) {
+      dispatch(sub);
+      dispatched++;
+    }
+  }
+  return dispatched;
+}
+
+void Adafruit_MQTT::dispatch(Adafruit_MQTT_Subscribe *sub) {
+  if (sub->callback_uint32t != NULL) {
+    // huh lets do the callback in integer mode
+    sub->callback_uint32t(atoi((const char *)sub->payload));
+  }
+  else if (sub->callback_double != NULL) {
+    // huh lets do the callback in doublefloat mode
+    sub->callback_double(atof((const char *)sub->payload));
+  }
+  else if (sub->callback_buffer != NULL) {
+    // huh lets do the callback in buffer mode
+    sub->callback_buffer((char *)sub->payload, sub->payloadlen);
+  }
+  else if (sub->callback_io != NULL) {
+    // huh lets do the callback in io mode
+    ((sub->io_feed)->*(sub->callback_io))((char *)sub->payload, sub->payloadlen);
+  }
+}
 
-  // Check if data is available to read.
-  uint16_t len = readFullPacket(buffer, MAXBUFFERSIZE, timeout); // return one full packet
+void Adafruit_MQTT::rebuildSubTable() {
+  for (uint8_t i=0; i<MQTT_SUBHASHSIZE; i++) {
+    sub_table[i] = -1;
+  }
+  for (uint8_t i=0; i<MAXSUBSCRIPTIONS; i++) {
+    if (subscriptions[i] == 0) continue;
+    sub_topiclen[i] = strlen(subscriptions[i]->topic);
+    sub_hash[i] = topicHash(subscriptions[i]->topic, sub_topiclen[i]);
+    // linear probing, the table is never more than half full
+    uint8_t slot = sub_hash[i] % MQTT_SUBHASHSIZE;
+    while (sub_table[slot] >= 0)
+      slot = (slot + 1) % MQTT_SUBHASHSIZE;
+    sub_table[slot] = i;
+  }
+}
+
+int8_t Adafruit_MQTT::findSubscription(const char *topic, uint16_t topiclen) {
+  uint32_t hash = topicHash(topic, topiclen);
+  uint8_t slot = hash % MQTT_SUBHASHSIZE;
+
+  while (sub_table[slot] >= 0) {
+    int8_t i = sub_table[slot];
+    // Be careful to make comparison case insensitive.
+    if (sub_hash[i] == hash && sub_topiclen[i] == topiclen &&
+        strncasecmp(topic, subscriptions[i]->topic, topiclen) == 0)
+      return i;
+    slot = (slot + 1) % MQTT_SUBHASHSIZE;
+  }
+  return -1;
+}
+
+Adafruit_MQTT_Subscribe *Adafruit_MQTT::readSubscription(int16_t timeout) {
+  // Anything held back during the handshake first, then check if data is available to read.
+  uint16_t len = takeHeldPacket();
+  if (!len)
+    len = readFullPacket(buffer, MAXBUFFERSIZE, timeout); // return one full packet
   if (!len)
     return NULL;  // No data available, just quit.
+  return parseSubscription(len);
+}
+
+Adafruit_MQTT_Subscribe *Adafruit_MQTT::parseSubscription(uint16_t len) {
+  uint16_t topiclen, datalen, offset;
+  uint8_t hdrlen;
+  int8_t i;
+
   DEBUG_PRINT("Packet len: "); DEBUG_PRINTLN(len); 
   DEBUG_PRINTBUFFER(buffer, len);
 
+  if ((buffer[0] >> 4) == MQTT_CTRL_PUBACK)
+    handleAck(buffer, len);
+  if ((buffer[0] >> 4) == MQTT_CTRL_PINGRESP)
+    ping_pending = false;
+  if ((buffer[0] >> 4) != MQTT_CTRL_PUBLISH)
+    return NULL;
+
+  // Skip the fixed header, the remaining length takes 1 to 4 bytes.
+  hdrlen = 2;
+  while ((buffer[hdrlen-1] & 0x80) && hdrlen < 5)
+    hdrlen++;
+  if (len < hdrlen + 2)
+    return NULL;
+
   // Parse out length of packet.
-  topiclen = buffer[3];
+  topiclen = (buffer[hdrlen] << 8) | buffer[hdrlen+1];
+  char *topicstart = (char *)buffer + hdrlen + 2;
+  if (hdrlen + 2 + topiclen > len)
+    return NULL;
   DEBUG_PRINT(F("Looking for subscription len ")); DEBUG_PRINTLN(topiclen);
 
   // Find subscription associated with this packet.
-  for (i=0; i<MAXSUBSCRIPTIONS; i++) {
-    if (subscriptions[i]) {
-      // Skip this subscription if its name length isn't the same as the
-      // received topic name.
-      if (strlen(subscriptions[i]->topic) != topiclen)
-        continue;
-      // Stop if the subscription topic matches the received topic. Be careful
-      // to make comparison case insensitive.
-      if (strncasecmp((char*)buffer+4, subscriptions[i]->topic, topiclen) == 0) {
-        DEBUG_PRINT(F("Found sub #")); DEBUG_PRINTLN(i);
-        break;
-      }
-    }
-  }
-  if (i==MAXSUBSCRIPTIONS) return NULL; // matching sub not found ???
+  i = findSubscription(topicstart, topiclen);
+  if (i < 0) return NULL; // matching sub not found ???
+  DEBUG_PRINT(F("Found sub #")); DEBUG_PRINTLN(i);
 
   uint8_t packet_id_len = 0;
   uint16_t packetid=0;
   // Check if it is QoS 1, TODO: we dont support QoS 2
   if ((buffer[0] & 0x6) == 0x2) {
+    // cut off before its packet id, there's nothing to acknowledge
+    if (hdrlen + 2 + topiclen + 2 > len)
+      return NULL;
     packet_id_len = 2;
-    packetid = buffer[topiclen+4];
+    packetid = buffer[hdrlen+2+topiclen];
     packetid <<= 8;
-    packetid |= buffer[topiclen+5];
+    packetid |= buffer[hdrlen+2+topiclen+1];
   }
 
-  // zero out the old data
-  memset(subscriptions[i]->lastread, 0, SUBSCRIPTIONDATALEN);
+  offset = hdrlen + 2 + topiclen + packet_id_len;
+  datalen = (len > offset) ? len - offset : 0;
+
+  // hand out the payload where it lies, readFullPacket left room to terminate it
+  buffer[offset + datalen] = 0;
+  subscriptions[i]->payload = buffer + offset;
+  subscriptions[i]->payloadlen = datalen;
 
-  datalen = len - topiclen - packet_id_len - 4;
-  if (datalen > SUBSCRIPTIONDATALEN) {
+  // and keep the old short copy for sketches that read lastread
+  if (datalen >= SUBSCRIPTIONDATALEN) {
     datalen = SUBSCRIPTIONDATALEN-1; // cut it off
   }
-  // extract out just the data, into the subscription object itself
-  memmove(subscriptions[i]->lastread, buffer+4+topiclen+packet_id_len, datalen);
+  memcpy(subscriptions[i]->lastread, buffer+offset, datalen);
+  subscriptions[i]->lastread[datalen] = 0;
   subscriptions[i]->datalen = datalen;
   DEBUG_PRINT(F("Data len: ")); DEBUG_PRINTLN(datalen);
   DEBUG_PRINT(F("Data: ")); DEBUG_PRINTLN((char *)subscriptions[i]->lastread);
@@ -523,6 +803,37 @@ void Adafruit_MQTT::flushIncoming(uint16_t timeout) {
   while (readPacket(buffer, MAXBUFFERSIZE, timeout));
 }
 
+bool Adafruit_MQTT::sendPing() {
+  uint8_t packet[2];
+
+  uint8_t len = pingPacket(packet);
+  if (!sendPacket(packet, len))
+    return false;
+  ping_pending = true;
+  return true;
+}
+
+bool Adafruit_MQTT::holdPacket(uint16_t len) {
+  if ((buffer[0] >> 4) != MQTT_CTRL_PUBLISH)
+    return false;
+  if (held_count >= MQTT_HELD_MAX || len > MQTT_HELD_PACKETSIZE)
+    return false;
+  memcpy(held_packets[held_count].packet, buffer, len);
+  held_packets[held_count].len = len;
+  held_count++;
+  return true;
+}
+
+uint16_t Adafruit_MQTT::takeHeldPacket() {
+  if (held_count == 0)
+    return 0;
+  uint16_t len = held_packets[0].len;
+  memcpy(buffer, held_packets[0].packet, len);
+  held_count--;
+  memmove(held_packets, held_packets + 1, held_count * sizeof(held_packets[0]));
+  return len;
+}
+
 bool Adafruit_MQTT::ping(uint8_t num) {
   //flushIncoming(100);
 
@@ -782,14 +1093,14 @@ bool Adafruit_MQTT_Publish::publish(int i) {
   return mqtt->publish(topic, payload, qos);
 }
 
-bool Adafruit_MQTT_Publish::publish(int32_t i) {
-  char payload[12];
+bool Adafruit_MQTT_Publish::publish(long i) {
+  char payload[21];
   ltoa(i, payload, 10);
   return mqtt->publish(topic, payload, qos);
 }
 
-bool Adafruit_MQTT_Publish::publish(uint32_t i) {
-  char payload[11];
+bool Adafruit_MQTT_Publish::publish(unsigned long i) {
+  char payload[21];
   ultoa(i, payload, 10);
   return mqtt->publish(topic, payload, qos);
 }
@@ -819,6 +1130,8 @@ Adafruit_MQTT_Subscribe::Adafruit_MQTT_Subscribe(Adafruit_MQTT *mqttserver,
   topic = feed;
   qos = q;
   datalen = 0;
+  payload = lastread;
+  payloadlen = 0;
   callback_uint32t = 0;
   callback_buffer = 0;
   callback_double = 0;
@@ -96,14 +96,19 @@
 #define PUBLISH_TIMEOUT_MS 500
 #define PING_TIMEOUT_MS    500
 #define SUBACK_TIMEOUT_MS  500
+// Once the first byte of a packet is in, how long to wait for the rest of it
+// even when polling with a zero timeout, so a packet is never split in two.
+#define PACKET_REST_TIMEOUT_MS 100
 
 // Adjust as necessary, in seconds.  Default to 5 minutes.
 #define MQTT_CONN_KEEPALIVE 300
 
-// Largest full packet we're able to send.
-// Need to be able to store at least ~90 chars for a connect packet with full
-// 23 char client ID.
-#define MAXBUFFERSIZE (150)
+// Largest full packet we're able to send or receive, bigger incoming packets
+// are truncated and the rest skipped.  Need to be able to store at least ~90
+// chars for a connect packet with full 23 char client ID.
+#ifndef MAXBUFFERSIZE
+#define MAXBUFFERSIZE (512)
+#endif
 
 #define MQTT_CONN_USERNAMEFLAG    0x80
 #define MQTT_CONN_PASSWORDFLAG    0x40
@@ -113,8 +118,26 @@
 #define MQTT_CONN_WILLFLAG        0x04
 #define MQTT_CONN_CLEANSESSION    0x02
 
+// QoS 1 publishes that can be waiting for their PUBACK at once when a publish
+// window is set, and the largest packet that can be kept for retransmission.
+#define MQTT_INFLIGHT_MAX 8
+#ifndef MQTT_INFLIGHT_PACKETSIZE
+#define MQTT_INFLIGHT_PACKETSIZE 192
+#endif
+
+// PUBLISHes that can arrive ahead of the SUBACKs while a subclass drives the
+// handshake, kept until the next dispatchPackets() or readSubscription().
+#define MQTT_HELD_MAX 4
+#ifndef MQTT_HELD_PACKETSIZE
+#define MQTT_HELD_PACKETSIZE 128
+#endif
+
 // how many subscriptions we want to be able to track
-#define MAXSUBSCRIPTIONS 5
+#ifndef MAXSUBSCRIPTIONS
+#define MAXSUBSCRIPTIONS 16
+#endif
+// slots in the topic hash table, kept at most half full so probes stay short
+#define MQTT_SUBHASHSIZE (2 * MAXSUBSCRIPTIONS)
 
 // how much data we save in a subscription object
 // eg max-subscription-payload-size
@@ -202,9 +225,29 @@ class Adafruit_MQTT {
 
   void processPackets(int16_t timeout);
 
+  // Handle every packet that has already arrived without waiting for more,
+  // calling the callback set on each matching subscription with its payload
+  // already parsed.  Returns the number of messages dispatched.
+  uint8_t dispatchPackets();
+
   // Ping the server to ensure the connection is still alive.
   bool ping(uint8_t n = 1);
 
+  // Let up to n QoS 1 publishes wait for their PUBACK at once instead of
+  // blocking on each one, 0 turns the window off.  A windowed publish returns
+  // true once it is sent and kept, false if the window is full, the packet is
+  // bigger than MQTT_INFLIGHT_PACKETSIZE or the write failed.  PUBACKs are
+  // picked up by readSubscription() and anything still unacknowledged is sent
+  // again after a reconnect.
+  void setPublishWindow(uint8_t n);
+  uint8_t inflight();
+  uint32_t acked() { return acked_count; }
+
+  // Publishes between beginBatch() and endBatch() that don't need to wait for
+  // a reply are collected and sent in as few TCP writes as possible.
+  void beginBatch();
+  bool endBatch();
+
  protected:
   // Interface that subclasses need to implement:
 
@@ -222,11 +265,39 @@ class Adafruit_MQTT {
   // milliseconds) for data to be available. 
   virtual uint16_t readPacket(uint8_t *buffer, uint16_t maxlen, int16_t timeout) = 0;
 
-  // Read a full packet, keeping note of the correct length
+  // Read a full packet, keeping note of the correct length.  A packet whose
+  // rest doesn't follow within PACKET_REST_TIMEOUT_MS (or the timeout given,
+  // if longer) returns 0 and drops the connection.
   uint16_t readFullPacket(uint8_t *buffer, uint16_t maxsize, uint16_t timeout);
   // Properly process packets until you get to one you want
   uint16_t processPacketsUntil(uint8_t *buffer, uint8_t waitforpackettype, uint16_t timeout);
 
+  // Pieces of connect() for subclasses that drive the handshake themselves.
+  // Send the CONNECT packet, check a CONNACK read into buffer (same codes as
+  // connect()), and send SUBSCRIBE for every subscription without waiting for
+  // the SUBACKs.  sendSubscriptions() returns how many were sent, -1 on error.
+  bool sendConnectPacket();
+  int8_t connackResult(uint16_t len);
+  int8_t sendSubscriptions();
+
+  // Sends every unacknowledged windowed publish again with the DUP flag set,
+  // call once connected.
+  bool resendInflight();
+
+  // Keepalive without waiting for the reply.  sendPing() sends a PINGREQ and
+  // pingPending() stays true until dispatchPackets() or readSubscription() has
+  // picked up the PINGRESP.
+  bool sendPing();
+  bool pingPending() { return ping_pending; }
+
+  // Keep a PUBLISH that was read into buffer while waiting for some other
+  // reply, false if it isn't a PUBLISH or there is no room for it.
+  bool holdPacket(uint16_t len);
+
+  // Index of the subscription to topic (topiclen bytes, not terminated), -1 if
+  // there is none.  One hash table probe, usually.
+  int8_t findSubscription(const char *topic, uint16_t topiclen);
+
   // Shared state that subclasses can use:
   const char *servername;
   int16_t portnum;
@@ -243,6 +314,41 @@ class Adafruit_MQTT {
  private:
   Adafruit_MQTT_Subscribe *subscriptions[MAXSUBSCRIPTIONS];
 
+  // topic hash -> subscription index, rebuilt whenever the subscriptions change
+  int8_t sub_table[MQTT_SUBHASHSIZE];
+  uint32_t sub_hash[MAXSUBSCRIPTIONS];
+  uint16_t sub_topiclen[MAXSUBSCRIPTIONS];
+
+  void rebuildSubTable();
+  Adafruit_MQTT_Subscribe *parseSubscription(uint16_t len);
+  void dispatch(Adafruit_MQTT_Subscribe *sub);
+
+  struct {
+    bool used;
+    uint16_t packetid;
+    uint16_t len;
+    uint8_t packet[MQTT_INFLIGHT_PACKETSIZE];
+  } inflight_packets[MQTT_INFLIGHT_MAX];
+  uint8_t publish_window;
+  uint32_t acked_count;
+  bool batching;
+  uint16_t batch_len;
+
+  struct {
+    uint16_t len;
+    uint8_t packet[MQTT_HELD_PACKETSIZE];
+  } held_packets[MQTT_HELD_MAX];
+  uint8_t held_count;
+  bool ping_pending;
+
+  uint16_t takeHeldPacket();
+  uint16_t packetCutShort();
+
+  int8_t freeInflightSlot();
+  void handleAck(uint8_t *packet, uint16_t len);
+  bool queueBatch(uint8_t *packet, uint16_t len);
+  bool flushBatch();
+
   void    flushIncoming(uint16_t timeout);
 
   // Functions to generate MQTT packets.
@@ -264,8 +370,8 @@ class Adafruit_MQTT_Publish {
   bool publish(double f, uint8_t precision=2);  // Precision controls the minimum number of digits after decimal.
                                                 // This might be ignored and a higher precision value sent.
   bool publish(int i);
-  bool publish(int32_t i);
-  bool publish(uint32_t i);
+  bool publish(long i);           // int32_t and uint32_t on the device, spelled out so int32_t
+  bool publish(unsigned long i);  // doesn't clash with int where it is one (x86 host builds)
   bool publish(uint8_t *b, uint16_t bLen);
 
 
@@ -293,6 +399,12 @@ class Adafruit_MQTT_Subscribe {
   // ensure nul terminating lastread.
   uint16_t datalen;
 
+  // The whole payload of the last message, in place in the client's buffer
+  // and nul terminated there.  Only valid until the client reads or sends the
+  // next packet, copy anything that needs to live longer.
+  const uint8_t *payload;
+  uint16_t payloadlen;
+
   SubscribeCallbackUInt32Type callback_uint32t;
   SubscribeCallbackDoubleType callback_double;
   SubscribeCallbackBufferType callback_buffer;
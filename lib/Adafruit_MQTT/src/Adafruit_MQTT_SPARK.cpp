@@ -23,31 +23,184 @@
 
 bool Adafruit_MQTT_SPARK::Update()
 {
-    // Stop if already connected.
-    if (!connected())
-    {
+    uint32_t now = millis();
+    int8_t ret;
+
+    switch (conn_state) {
+    case MQTT_STATE_BACKOFF:
+        if (!WiFi.ready() || (now - state_since) < backoff)
+            break;
         DEBUG_PRINT(F("Connecting to MQTT... "));
-        
-        uint8_t retries = 0;
-        for(int8_t ret = connect() ; ret != 0 && retries < 3 ; ret = connect() , retries++)
-        { // connect will return 0 for connected
-            DEBUG_PRINT(connectErrorString(ret));
-            DEBUG_PRINT(F("Retrying MQTT connection in 5 seconds..."));
-            disconnect();
-            delay(5000);  // wait 5 seconds
+        setState(MQTT_STATE_RESOLVE, now);
+        break;
+
+    case MQTT_STATE_RESOLVE:
+        // the lookup is kept for reconnects, only a failed connect throws it away
+        if (worker != NULL || !server_ip) {
+            ret = runWorker([this]() {
+                server_ip = WiFi.resolve(servername);
+                return (bool)server_ip;
+            });
+            if (ret == 0)
+                break;
+        }
+        if (!server_ip) {
+            ERROR_PRINTLN(F("MQTT broker lookup failed"));
+            connectFailed(now);
+            break;
+        }
+        setState(MQTT_STATE_TCPCONNECT, now);
+        break;
+
+    case MQTT_STATE_TCPCONNECT:
+        if ((ret = runWorker([this]() { return client->connect(server_ip, portnum) != 0; })) == 0)
+            break;
+        if (ret < 0 || !sendConnectPacket()) {
+            ERROR_PRINTLN(F("MQTT socket connect failed"));
+            // the broker may have moved, look it up again next time
+            server_ip = IPAddress();
+            connectFailed(now);
+            break;
+        }
+        setState(MQTT_STATE_CONNACK, now);
+        break;
+
+    case MQTT_STATE_CONNACK:
+        // CONNACK is always 4 bytes, don't start reading until it is all here
+        if (client->available() >= 4) {
+            ret = connackResult(readFullPacket(buffer, MAXBUFFERSIZE, 0));
+            if (ret != 0) {
+                ERROR_PRINTLN(connectErrorString(ret));
+                connectFailed(now);
+                break;
+            }
+            subacks_pending = sendSubscriptions();
+            if (subacks_pending < 0) {
+                ERROR_PRINTLN(connectErrorString(-2));
+                connectFailed(now);
+                break;
+            }
+            setState(MQTT_STATE_SUBACK, now);
+        }
+        else if (!connected() || (now - state_since) > CONNECT_TIMEOUT_MS) {
+            connectFailed(now);
+        }
+        break;
+
+    case MQTT_STATE_SUBACK:
+        while (subacks_pending > 0 && client->available()) {
+            uint16_t len = readFullPacket(buffer, MAXBUFFERSIZE, 0);
+            if (len == 0)
+                break;
+            // the broker may start publishing before the last SUBACK
+            if ((buffer[0] >> 4) == MQTT_CTRL_SUBACK)
+                subacks_pending--;
+            else if (!holdPacket(len))
+                ERROR_PRINTLN(F("Dropped a packet"));
         }
-      
-        if( connected() )
-        {
+        if (subacks_pending == 0) {
             DEBUG_PRINT(F("MQTT Connected"));
+            // publishes that never got their PUBACK before the drop go out again
+            if (!resendInflight()) {
+                connectFailed(now);
+                break;
+            }
+            conn_attempts = 0;
+            ping_sent = now;
+            setState(MQTT_STATE_CONNECTED, now);
         }
-        else
-        {
-            DEBUG_PRINT(F("Failed to connect"));
-            return false;
+        else if (!connected() || (now - state_since) > CONNECT_TIMEOUT_MS) {
+            ERROR_PRINTLN(connectErrorString(-2));
+            connectFailed(now);
         }
+        break;
+
+    case MQTT_STATE_CONNECTED:
+        if (!connected()) {
+            ERROR_PRINTLN(F("MQTT connection lost"));
+            connectFailed(now);
+            break;
+        }
+        // the PINGRESP is picked up by dispatchPackets() or readSubscription()
+        if (pingPending()) {
+            if ((now - ping_sent) > MQTT_PINGRESP_TIMEOUT_MS) {
+                ERROR_PRINTLN(F("MQTT ping timed out"));
+                connectFailed(now);
+            }
+        }
+        else if ((now - ping_sent) >= MQTT_PING_INTERVAL_MS) {
+            ping_sent = now;
+            if (!sendPing()) {
+                ERROR_PRINTLN(F("MQTT ping failed"));
+                connectFailed(now);
+            }
+        }
+        break;
+
+    default:
+        break;
+    }
+    return conn_state == MQTT_STATE_CONNECTED;
+}
+
+int8_t Adafruit_MQTT_SPARK::runWorker(std::function<bool()> job)
+{
+    if (worker == NULL) {
+        worker_result = 0;
+        worker = new Thread("mqtt", [this, job]() {
+            worker_result = job() ? 1 : -1;
+        });
+        return 0;
+    }
+    if (worker_result == 0)
+        return 0;
+    // the job is done, joining doesn't wait
+    delete worker;
+    worker = NULL;
+    return worker_result;
+}
+
+void Adafruit_MQTT_SPARK::setState(mqttState_t state, uint32_t now)
+{
+    state_time[conn_state] += now - state_since;
+    conn_state = state;
+    state_since = now;
+}
+
+void Adafruit_MQTT_SPARK::connectFailed(uint32_t now)
+{
+    disconnectServer();
+    conn_failures++;
+
+    // Equal jitter, wait between half and all of the exponential window
+    uint32_t window = MQTT_BACKOFF_MIN_MS << min(conn_attempts, (uint8_t)6);
+    window = min(window, (uint32_t)MQTT_BACKOFF_MAX_MS);
+    backoff = window / 2 + random(window / 2 + 1);
+    if (conn_attempts < 255)
+        conn_attempts++;
+
+    DEBUG_PRINT(F("Retrying MQTT connection in ")); DEBUG_PRINT(backoff); DEBUG_PRINTLN(F(" ms"));
+    setState(MQTT_STATE_BACKOFF, now);
+}
+
+uint32_t Adafruit_MQTT_SPARK::getStateTime(mqttState_t state)
+{
+    if (state >= MQTT_STATE_COUNT)
+        return 0;
+    return state_time[state] + ((state == conn_state) ? millis() - state_since : 0);
+}
+
+const char *Adafruit_MQTT_SPARK::stateString(mqttState_t state)
+{
+    switch (state) {
+    case MQTT_STATE_BACKOFF: return "backoff";
+    case MQTT_STATE_RESOLVE: return "resolving";
+    case MQTT_STATE_TCPCONNECT: return "connecting";
+    case MQTT_STATE_CONNACK: return "waiting for CONNACK";
+    case MQTT_STATE_SUBACK: return "subscribing";
+    case MQTT_STATE_CONNECTED: return "connected";
+    default: return "unknown";
     }
-    return true;
 }
 
 bool Adafruit_MQTT_SPARK::connectServer(){
@@ -81,21 +234,28 @@ uint16_t Adafruit_MQTT_SPARK::readPacket(uint8_t *buffer, uint16_t maxlen,
   uint16_t len = 0;
   int16_t t = timeout;
 
+  if (maxlen == 0)
+    return 0;
+
   while (client->connected() && (timeout >= 0)) {
-    //DEBUG_PRINT('.');
-    while (client->available()) {
-      //DEBUG_PRINT('!');
-      char c = client->read();
+    // take whatever has arrived in one go rather than a byte at a time
+    int avail = client->available();
+    if (avail > 0) {
+      int got = client->read(buffer + len, min((uint16_t)avail, (uint16_t)(maxlen - len)));
+      if (got <= 0)
+        break;
+      len += got;
       timeout = t;  // reset the timeout
-      buffer[len] = c;
-      //DEBUG_PRINTLN((uint8_t)c, HEX);
-      len++;
       if (len == maxlen) {  // we read all we want, bail
         DEBUG_PRINT(F("Read data:\t"));
         DEBUG_PRINTBUFFER(buffer, len);
         return len;
       }
+      continue;
     }
+    // nothing waiting, a zero timeout is just a poll so don't sleep on it
+    if (timeout == 0)
+      break;
     timeout -= MQTT_CLIENT_READINTERVAL_MS;
     delay(MQTT_CLIENT_READINTERVAL_MS);
   }
@@ -107,20 +267,22 @@ bool Adafruit_MQTT_SPARK::sendPacket(uint8_t *buffer, uint16_t len) {
 
   while (len > 0) {
     if (client->connected()) {
-      // send 250 bytes at most at a time, can adjust this later based on Client
+      // a whole buffer (usually several batched packets) per write
 
-      uint16_t sendlen = min(len, 250);
+      uint16_t sendlen = min(len, (uint16_t)MAXBUFFERSIZE);
       //Serial.print("Sending: "); Serial.println(sendlen);
       ret = client->write(buffer, sendlen);
       DEBUG_PRINT(F("Client sendPacket returned: ")); DEBUG_PRINTLN(ret);
-      len -= ret;
-
       if (ret != sendlen) {
 	DEBUG_PRINTLN("Failed to send packet.");
+	write_failures++;
 	return false;
       }
+      buffer += ret;
+      len -= ret;
     } else {
       DEBUG_PRINTLN(F("Connection failed!"));
+      write_failures++;
       return false;
     }
   }
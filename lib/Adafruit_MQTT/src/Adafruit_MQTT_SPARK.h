@@ -25,12 +25,36 @@
 #include "spark_wiring_string.h"
 #include "spark_wiring_tcpclient.h"
 #include "spark_wiring_usbserial.h"
+#include "spark_wiring_thread.h"
+#include <atomic>
+#include <functional>
 #include "Adafruit_MQTT.h"
 
 
 // How long to delay waiting for new data to be available in readPacket.
 #define MQTT_CLIENT_READINTERVAL_MS 10
 
+// Reconnect backoff, doubles after every failed attempt up to the max and is
+// randomized over the upper half of the window so devices don't retry in step.
+#define MQTT_BACKOFF_MIN_MS 1000
+#define MQTT_BACKOFF_MAX_MS 60000
+
+// Keepalive, a PINGREQ goes out this often once connected and the connection
+// is dropped if the PINGRESP hasn't come back in time.
+#define MQTT_PING_INTERVAL_MS 120000
+#define MQTT_PINGRESP_TIMEOUT_MS 10000
+
+// Connection manager states, Update() does at most one step per call.
+typedef enum {
+  MQTT_STATE_BACKOFF,     // waiting for Wi-Fi and the retry time
+  MQTT_STATE_RESOLVE,     // looking up the broker address on a worker thread
+  MQTT_STATE_TCPCONNECT,  // opening the socket on a worker thread, then CONNECT
+  MQTT_STATE_CONNACK,     // waiting for CONNACK
+  MQTT_STATE_SUBACK,      // SUBSCRIBEs sent, waiting for the SUBACKs
+  MQTT_STATE_CONNECTED,
+  MQTT_STATE_COUNT
+} mqttState_t;
+
 
 // MQTT client implementation for a generic Arduino Client interface.  Can work
 // with almost all Arduino network hardware like ethernet shield, wifi shield,
@@ -48,9 +72,22 @@ class Adafruit_MQTT_SPARK : public Adafruit_MQTT {
     Adafruit_MQTT(server, port, user, pass),
     client(client)
   {}
-  
+
+  // Advance the connection manager one step without waiting on the network.
+  // Call it often, it returns true once connected and subscribed.  Once
+  // connected it also keeps the connection alive with pings, so call it
+  // outside beginBatch()/endBatch() and follow it with dispatchPackets().
   bool Update();
 
+  mqttState_t getState() { return conn_state; }
+  const char *stateString(mqttState_t state);
+  // ms spent in the current state, and in total in a state since boot
+  uint32_t getTimeInState() { return millis() - state_since; }
+  uint32_t getStateTime(mqttState_t state);
+  // Failed connection attempts and dropped connections, plus failed writes
+  uint16_t getFailures() { return conn_failures + write_failures; }
+  uint16_t getWriteFailures() { return write_failures; }
+
   bool connectServer();
   bool disconnectServer();
   bool connected();
@@ -59,6 +96,29 @@ class Adafruit_MQTT_SPARK : public Adafruit_MQTT {
 
  private:
   TCPClient* client;
+
+  mqttState_t conn_state = MQTT_STATE_BACKOFF;
+  uint32_t state_since = 0;
+  uint32_t state_time[MQTT_STATE_COUNT] = {};
+  uint32_t backoff = 0;
+  uint8_t conn_attempts = 0;
+  uint16_t conn_failures = 0;
+  uint16_t write_failures = 0;
+  int8_t subacks_pending = 0;
+  uint32_t ping_sent = 0;
+  // Looked up once and kept until a connect to it fails
+  IPAddress server_ip;
+  // WiFi.resolve() and TCPClient::connect() block until the network answers
+  // or gives up, so they run on a thread of their own.  The result is 0 while
+  // the job runs, then 1 if it succeeded and -1 if it failed.
+  Thread *worker = NULL;
+  std::atomic<int8_t> worker_result{0};
+
+  void setState(mqttState_t state, uint32_t now);
+  void connectFailed(uint32_t now);
+  // Starts job on the worker the first time, then returns 0 until it is done
+  // and its result once, the next call starts it again.
+  int8_t runWorker(std::function<bool()> job);
 };
 
 
@@ -671,6 +671,10 @@ void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c,
   }
 }
 
+const unsigned char *Adafruit_GFX::glyph(unsigned char c) {
+  return font + (c * 5);
+}
+
 void Adafruit_GFX::setCursor(int16_t x, int16_t y) {
   cursor_x = x;
   cursor_y = y;
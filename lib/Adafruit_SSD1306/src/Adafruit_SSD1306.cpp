@@ -90,6 +90,10 @@ static uint8_t buffer[SSD1306_LCDHEIGHT * SSD1306_LCDWIDTH / 8] = {
 #endif
 };
 
+// front buffer, the latched frame: what the panel shows once flush() has sent the waiting
+// windows. Drawing only touches the back buffer above, so clearDisplay() and a redraw never
+// reach the panel as a blank frame, and the next frame can be drawn while this one goes out.
+static uint8_t panel[SSD1306_LCDHEIGHT * SSD1306_LCDWIDTH / 8];
 
 
 // the most basic function, set a single pixel
@@ -113,6 +117,8 @@ void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
     break;
   }  
 
+  markDirty(x, x, y/8, y/8);
+
   // x is which column
   if (color == WHITE) 
     buffer[x+ (y/8)*SSD1306_LCDWIDTH] |= (1 << (y&7));  
@@ -120,6 +126,47 @@ void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
     buffer[x+ (y/8)*SSD1306_LCDWIDTH] &= ~(1 << (y&7)); 
 }
 
+// size 1 text on an unrotated panel is written a font column at a time straight into the
+// page buffer, everything else goes pixel by pixel through Adafruit_GFX
+void Adafruit_SSD1306::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size) {
+  if (size != 1 || getRotation() != 0) {
+    Adafruit_GFX::drawChar(x, y, c, color, bg, size);
+    return;
+  }
+
+  if ((x >= WIDTH) || (y >= HEIGHT) || (x + 5 < 0) || (y + 7 < 0))
+    return;
+
+  // the glyph straddles two pages unless y is page aligned
+  uint8_t shift = y & 7;
+  int16_t page = (y - shift) / 8;
+  boolean top = (page >= 0), bottom = (shift != 0) && (page + 1 < SSD1306_LCDPAGES);
+  const unsigned char *bits = glyph(c);
+
+  int16_t col0 = max(x, (int16_t)0), col1 = min((int16_t)(x + 5), (int16_t)(WIDTH - 1));
+  if (top) markDirty(col0, col1, page, page);
+  if (bottom) markDirty(col0, col1, page + 1, page + 1);
+
+  for (int16_t col = col0; col <= col1; col++) {
+    uint8_t line = (col - x == 5) ? 0 : bits[col - x];
+
+    // pixels to set and clear across both pages, bg == color means a transparent background
+    uint16_t fg = (uint16_t)line << shift;
+    uint16_t back = (bg != color) ? (uint16_t)(~line & 0xFF) << shift : 0;
+    uint16_t set = ((color == WHITE) ? fg : 0) | ((bg == WHITE) ? back : 0);
+    uint16_t clear = ((color == WHITE) ? 0 : fg) | ((bg == WHITE) ? 0 : back);
+
+    if (top) {
+      uint8_t *b = &buffer[col + page * SSD1306_LCDWIDTH];
+      *b = (*b & ~(uint8_t)clear) | (uint8_t)set;
+    }
+    if (bottom) {
+      uint8_t *b = &buffer[col + (page + 1) * SSD1306_LCDWIDTH];
+      *b = (*b & ~(uint8_t)(clear >> 8)) | (uint8_t)(set >> 8);
+    }
+  }
+}
+
 // constructor for software SPI - we indicate DataCommand, ChipSelect, Reset 
 Adafruit_SSD1306::Adafruit_SSD1306(int8_t SID, int8_t SCLK, int8_t DC, int8_t RST, int8_t CS) : Adafruit_GFX(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT) {
   cs = CS;
@@ -149,6 +196,19 @@ Adafruit_GFX(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT) {
 void Adafruit_SSD1306::begin(uint8_t vccstate, uint8_t i2caddr) {
   _vccstate = vccstate;
   _i2caddr = i2caddr;
+  _frameBytes = 0;
+  _frameTime = 0;
+  _busBytes = 0;
+  _flushTime = 0;
+  // we don't know what the panel shows yet, the first display() sends everything
+  _panelValid = false;
+  _fullFrame = false;
+  _flushPage = SSD1306_LCDPAGES;
+  for (uint8_t page = 0; page < SSD1306_LCDPAGES; page++) {
+    _sendStart[page] = 0xFF;
+    _sendEnd[page] = 0;
+  }
+  markAllDirty();
 
   // set pin directions
   if (sid != -1){
@@ -287,7 +347,9 @@ void Adafruit_SSD1306::ssd1306_command(uint8_t c) {
     Wire.write(control);
     Wire.write(c);
     Wire.endTransmission();
+    _busBytes++;
   }
+  _busBytes++;
 }
 
 // startscrollright
@@ -400,15 +462,114 @@ void Adafruit_SSD1306::ssd1306_data(uint8_t c) {
   }
 }
 
+// latch the frame and send it all before returning
 void Adafruit_SSD1306::display(void) {
-  ssd1306_command(SSD1306_COLUMNADDR);
-  ssd1306_command(0);   // Column start address (0 = reset)
-  ssd1306_command(127); // Column end address (127 = reset)
+  displayAsync();
+  while (!flush())
+    ;
+}
+
+// copy the changed column window of each page from the back buffer into the front buffer, flush()
+// then sends those windows. Drawing can carry on in the back buffer while the frame goes out.
+void Adafruit_SSD1306::displayAsync(void) {
+  if (!isFlushing()) {
+    _frameStartBytes = _busBytes;
+    _flushTime = 0;
+  }
+
+  // nothing on the panel we can trust yet, send the whole frame as one window
+  if (!_panelValid) {
+    memcpy(panel, buffer, SSD1306_LCDBYTES);
+    for (uint8_t page = 0; page < SSD1306_LCDPAGES; page++) {
+      _dirtyStart[page] = 0xFF;
+      _dirtyEnd[page] = 0;
+    }
+    _panelValid = true;
+    _fullFrame = true;
+    _flushPage = 0;
+    return;
+  }
+
+  for (uint8_t page = 0; page < SSD1306_LCDPAGES; page++) {
+    if (_dirtyStart[page] > _dirtyEnd[page])
+      continue;
+
+    uint8_t *row = buffer + page * SSD1306_LCDWIDTH;
+    uint8_t *shown = panel + page * SSD1306_LCDWIDTH;
+    int16_t col0 = _dirtyStart[page];
+    int16_t col1 = _dirtyEnd[page];
+    _dirtyStart[page] = 0xFF;
+    _dirtyEnd[page] = 0;
+
+    // redrawing the same pixels marks them dirty too, trim the columns the front buffer already has
+    while (col0 <= col1 && row[col0] == shown[col0]) col0++;
+    while (col1 >= col0 && row[col1] == shown[col1]) col1--;
+    if (col0 > col1)
+      continue;
+
+    // a page still waiting from the last frame goes out with the union of both windows
+    memcpy(shown + col0, row + col0, col1 - col0 + 1);
+    if (col0 < _sendStart[page]) _sendStart[page] = col0;
+    if (col1 > _sendEnd[page]) _sendEnd[page] = col1;
+  }
+  _flushPage = 0;
+  skipSentPages();
+}
+
+// move _flushPage on to the next page with a window waiting, or past the last page
+void Adafruit_SSD1306::skipSentPages(void) {
+  while (_flushPage < SSD1306_LCDPAGES && _sendStart[_flushPage] > _sendEnd[_flushPage])
+    _flushPage++;
+}
+
+// send the next page of the front buffer that has a window waiting, true once the frame is all out
+bool Adafruit_SSD1306::flush(void) {
+  uint32_t start;
+
+  if (!isFlushing())
+    return true;
+
+  start = micros();
+  if (_fullFrame) {
+    sendWindow(0, SSD1306_LCDWIDTH - 1, 0, SSD1306_LCDPAGES - 1, panel, SSD1306_LCDBYTES);
+    _fullFrame = false;
+    for (uint8_t page = 0; page < SSD1306_LCDPAGES; page++) {
+      _sendStart[page] = 0xFF;
+      _sendEnd[page] = 0;
+    }
+    _flushPage = SSD1306_LCDPAGES;
+  }
+  else {
+    skipSentPages();
+    if (_flushPage < SSD1306_LCDPAGES) {
+      uint8_t page = _flushPage;
+      uint8_t col0 = _sendStart[page], col1 = _sendEnd[page];
+      _sendStart[page] = 0xFF;
+      _sendEnd[page] = 0;
+      sendWindow(col0, col1, page, page, panel + page * SSD1306_LCDWIDTH + col0, col1 - col0 + 1);
+    }
+    skipSentPages();
+  }
+  _flushTime += micros() - start;
+
+  if (isFlushing())
+    return false;
+  _frameBytes = _busBytes - _frameStartBytes;
+  _frameTime = _flushTime;
+  return true;
+}
 
+void Adafruit_SSD1306::sendWindow(uint8_t col0, uint8_t col1, uint8_t page0, uint8_t page1, const uint8_t *data, uint16_t len) {
+  ssd1306_command(SSD1306_COLUMNADDR);
+  ssd1306_command(col0);
+  ssd1306_command(col1);
   ssd1306_command(SSD1306_PAGEADDR);
-  ssd1306_command(0); // Page start address (0 = reset)
-  ssd1306_command((SSD1306_LCDHEIGHT == 64) ? 7 : 3); // Page end address
+  ssd1306_command(page0);
+  ssd1306_command(page1);
+  sendData(data, len);
+}
 
+void Adafruit_SSD1306::sendData(const uint8_t *data, uint16_t len) {
   if (sid != -1)
   {
     // SPI
@@ -417,33 +578,45 @@ void Adafruit_SSD1306::display(void) {
     digitalWrite(cs, LOW);
 	delayMicroseconds(1);		// May not be necessary - needs testing
 
-    for (uint16_t i=0; i<(SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8); i++) {
-      fastSPIwrite(buffer[i]);
-      //ssd1306_data(buffer[i]);
+    for (uint16_t i=0; i<len; i++) {
+      fastSPIwrite(data[i]);
     }
 	delayMicroseconds(1);		// May not be necessary - needs testing
     digitalWrite(cs, HIGH);
+    _busBytes += len;
   }
   else
   {
-    // I2C
-    for (uint16_t i=0; i<(SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8); i++) {
-      // send a bunch of data in one xmission
+    // I2C, send a burst of data in each xmission
+    for (uint16_t i=0; i<len; i+=_burst) {
       Wire.beginTransmission(_i2caddr);
       Wire.write(0x40);
-      for (uint8_t x=0; x<16; x++) {
-		Wire.write(buffer[i]);
-		i++;
-		}
-	i--;
-	Wire.endTransmission();
-	}
+      Wire.write(data + i, min(_burst, (uint16_t)(len - i)));
+      Wire.endTransmission();
+      _busBytes++;
+    }
+    _busBytes += len;
+  }
+}
+
+inline void Adafruit_SSD1306::markDirty(int16_t x0, int16_t x1, uint8_t page0, uint8_t page1) {
+  for (uint8_t page = page0; page <= page1; page++) {
+    if (x0 < _dirtyStart[page]) _dirtyStart[page] = x0;
+    if (x1 > _dirtyEnd[page]) _dirtyEnd[page] = x1;
+  }
+}
+
+void Adafruit_SSD1306::markAllDirty(void) {
+  for (uint8_t page = 0; page < SSD1306_LCDPAGES; page++) {
+    _dirtyStart[page] = 0;
+    _dirtyEnd[page] = SSD1306_LCDWIDTH - 1;
   }
 }
 
 // clear everything
 void Adafruit_SSD1306::clearDisplay(void) {
   memset(buffer, 0, (SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8));
+  markAllDirty();
 }
 
 
@@ -502,12 +675,14 @@ void Adafruit_SSD1306::drawFastHLineInternal(int16_t x, int16_t y, int16_t w, ui
 
   // make sure we don't go off the edge of the display
   if( (x + w) > WIDTH) { 
-    w = (HEIGHT- x);
+    w = (WIDTH - x);
   }
 
   // if our width is now negative, punt
   if(w <= 0) { return; }
 
+  markDirty(x, x + w - 1, y/8, y/8);
+
   // set up the pointer for  movement through the buffer
   register uint8_t *pBuf = buffer;
   // adjust the buffer pointer for the current row
@@ -582,6 +757,8 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y, int16_t __h
     return;
   }
 
+  markDirty(x, x, __y/8, (__y + __h - 1)/8);
+
   // this display doesn't need ints for coordinates, use local byte registers for faster juggling
   register uint8_t y = __y;
   register uint8_t h = __h;
@@ -60,6 +60,13 @@ All text above, and the splash screen must be included in any redistribution
   #define SSD1306_LCDHEIGHT                 32
 #endif
 
+#define SSD1306_LCDPAGES (SSD1306_LCDHEIGHT / 8)
+#define SSD1306_LCDBYTES (SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8)
+
+// data bytes per I2C transaction, the Wire buffer must hold one more for the control byte.
+// The default Wire buffer is 32 bytes, define acquireWireBuffer() in the app for bigger bursts.
+#define SSD1306_I2C_BURST 16
+
 #define SSD1306_SETCONTRAST 0x81
 #define SSD1306_DISPLAYALLON_RESUME 0xA4
 #define SSD1306_DISPLAYALLON 0xA5
@@ -119,6 +126,9 @@ class Adafruit_SSD1306 : public Adafruit_GFX {
   void clearDisplay(void);
   void invertDisplay(uint8_t i);
   void display();
+  void displayAsync(void);
+  bool flush(void);
+  bool isFlushing(void) { return _flushPage < SSD1306_LCDPAGES; }
 
   void startscrollright(uint8_t start, uint8_t stop);
   void startscrollleft(uint8_t start, uint8_t stop);
@@ -133,10 +143,38 @@ class Adafruit_SSD1306 : public Adafruit_GFX {
 
   virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
   virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  virtual void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size);
+
+  // bytes put on the bus (commands and data) and time spent sending the last complete frame
+  uint16_t getFrameBytes(void) { return _frameBytes; }
+  uint32_t getFrameTime(void) { return _frameTime; }
+
+  // data bytes per I2C transaction, one less than the Wire buffer (acquireWireBuffer() size, 32
+  // by default) since the control byte goes in the same transaction
+  void setBurstSize(uint16_t burst, uint16_t wireBuffer = 32) { _burst = (burst == 0) ? 1 : (burst < wireBuffer) ? burst : wireBuffer - 1; }
+  uint16_t getBurstSize(void) { return _burst; }
 
  private:
   int8_t _i2caddr, _vccstate, sid, sclk, dc, rst, cs;
   void fastSPIwrite(uint8_t c);
+  void sendData(const uint8_t *data, uint16_t len);
+
+  // columns changed since the last display(), per page; start > end means the page is clean
+  uint8_t _dirtyStart[SSD1306_LCDPAGES], _dirtyEnd[SSD1306_LCDPAGES];
+  // columns of the front buffer still to send, per page, and the next page flush() looks at
+  uint8_t _sendStart[SSD1306_LCDPAGES], _sendEnd[SSD1306_LCDPAGES];
+  uint8_t _flushPage;
+  boolean _fullFrame;
+  boolean _panelValid;
+  uint16_t _frameBytes;
+  uint32_t _frameTime;
+  uint32_t _busBytes, _frameStartBytes;
+  uint32_t _flushTime;
+  uint16_t _burst = SSD1306_I2C_BURST;
+  void skipSentPages(void);
+  void sendWindow(uint8_t col0, uint8_t col1, uint8_t page0, uint8_t page1, const uint8_t *data, uint16_t len);
+  inline void markDirty(int16_t x0, int16_t x1, uint8_t page0, uint8_t page1) __attribute__((always_inline));
+  void markAllDirty(void);
 
   boolean hwSPI;
 
@@ -24,7 +24,7 @@ uint8_t DFRobot_PN532::getUltraversion(uint8_t block){
         cmdRead[3] = block; 
     
     writeCommand(cmdRead,4);
-    if(!readAck(32))
+    if(!readAck(PN532_READ_FRAME))
         return -1;
     if(receiveACK[12] == 0x41 && receiveACK[13] == 0x00){
     }
@@ -46,7 +46,7 @@ uint8_t DFRobot_PN532::readNTAG(uint8_t *buffer,uint8_t block){
         cmdRead[3] = block; 
     
     writeCommand(cmdRead,4);
-    if(!readAck(32))
+    if(!readAck(PN532_READ_FRAME))
         return -1;
     String dataSrt = "";
     if(receiveACK[12] == 0x41 && receiveACK[13] == 0x00){
@@ -94,7 +94,7 @@ uint8_t DFRobot_PN532::readUltralight(uint8_t *buffer,uint8_t block){
         cmdRead[3] = block; 
     
     writeCommand(cmdRead,4);
-    if(!readAck(22))
+    if(!readAck(PN532_READ_FRAME))
         return -1;
     if(receiveACK[12] == 0x41 && receiveACK[13] == 0x00){
         for(uint8_t i = 0;i<4;i++){
@@ -158,8 +158,10 @@ DFRobot_PN532:: sCard_t DFRobot_PN532::getInformation(){
     cmdnfcUid[1] = 1;                              // The quantity number of the maxium card that can be detected in every research
     cmdnfcUid[2] = MIFARE_ISO14443A;
     writeCommand(cmdnfcUid,3);
-    readAck(28);
-    for(int i = 0; i < receiveACK[18]; i++)
+    if(!readAck(PN532_LIST_FRAME) || receiveACK[13] != 1)
+        memset(receiveACK, 0, sizeof(receiveACK));
+    receiveACK[18] = min(receiveACK[18], (uint8_t)sizeof(card.uid));
+    for(int i = 0; i < receiveACK[18] && i < (int)sizeof(nfcUid); i++)
         nfcUid[i] = receiveACK[i + 19];
     
     /*for(int i= 0 ; i<32 ;i++){
@@ -358,8 +360,9 @@ bool DFRobot_PN532::scan()
     cmdnfcUid[0] = COMMAND_INLISTPASSIVETARGET;
     cmdnfcUid[1] = 1;                              // The quantity number of the maxium card that can be detected in every research
     cmdnfcUid[2] = MIFARE_ISO14443A;
+    this->_authSector = -1;    // Selecting the card again drops its authentication
     writeCommand(cmdnfcUid,3);
-    if(!readAck(25))
+    if(!readAck(PN532_LIST_FRAME))
         return false;
     for(int i = 0; i < 4; i++)
         nfcUid[i] = receiveACK[i + 19];
@@ -402,6 +405,66 @@ uint8_t DFRobot_PN532::readData(uint8_t *buffer,uint8_t block){
     return  1;
     
 }
+bool DFRobot_PN532::beginSession(void)
+{
+    uint32_t start = micros();
+    this->_session = this->scan();
+    this->_timing.scanTime += micros() - start;
+    this->_timing.scanCount++;
+    return this->_session;
+}
+
+bool DFRobot_PN532::readBlocks(uint8_t *buffer, uint8_t block, uint8_t count)
+{
+    uint32_t start;
+    int sector;
+    if(!this->nfcEnable || !this->_session)
+        return false;
+    for(uint8_t i = 0; i < count; i++){
+        /*! Sectors are 4 blocks up to block 128 and 16 blocks after that, one authentication covers the sector*/
+        sector = (block < 128) ? block / 4 : 32 + (block - 128) / 16;
+        if(sector != this->_authSector){
+            start = micros();
+            bool authenticated = passWordCheck(block, nfcUid, nfcPassword);
+            this->_timing.authTime += micros() - start;
+            this->_timing.authCount++;
+            if(!authenticated){
+                endSession();
+                return false;
+            }
+            this->_authSector = sector;
+        }
+        start = micros();
+        unsigned char cmdRead[4];
+            cmdRead[0] = COMMAND_INDATAEXCHANGE;
+            cmdRead[1] = 1;                   /* Card number */
+            cmdRead[2] = CARD_CMD_READING;     /* Mifare Read command = 0x30 */
+            cmdRead[3] = block;
+        writeCommand(cmdRead,4);
+        bool ok = readAck(PN532_READ_FRAME) && checkDCS(PN532_READ_FRAME) == 1 && receiveACK[12] == 0x41 && receiveACK[13] == 0x00;
+        this->_timing.readTime += micros() - start;
+        this->_timing.readCount++;
+        if(!ok){
+            endSession();
+            return false;
+        }
+        memcpy(buffer + i * 16, receiveACK + 14, 16);
+        block++;
+    }
+    return true;
+}
+
+void DFRobot_PN532::endSession(void)
+{
+    this->_session = false;
+    this->_authSector = -1;
+}
+
+void DFRobot_PN532::resetTiming(void)
+{
+    memset(&this->_timing, 0, sizeof(this->_timing));
+}
+
 String DFRobot_PN532::readData(int page) {
     if (page > 255)
         return "flase";
@@ -418,10 +481,10 @@ String DFRobot_PN532::readData(int page) {
         cmdRead[3] = page; 
     
     writeCommand(cmdRead,4);
-    if(!readAck(32))
+    if(!readAck(PN532_READ_FRAME))
         return "read timeout!";
     String dataSrt = "";
-    if(checkDCS(32) == 1 && receiveACK[12] == 0x41 && receiveACK[13] == 0x00){
+    if(checkDCS(PN532_READ_FRAME) == 1 && receiveACK[12] == 0x41 && receiveACK[13] == 0x00){
         for(int i = 0; i<16; i++)
         {
             blockData[i] = receiveACK[i + 14];
@@ -443,6 +506,7 @@ void DFRobot_PN532_IIC::writeCommand(uint8_t* cmd, uint8_t cmdlen) {
     uint8_t checksum;
     cmdlen++;
     delay(2);     // Delay for random time to wake up NFC module
+    _irqFired = false;
     // I2C START
     Wire.beginTransmission(I2C_ADDRESS);
     checksum = PN532_PREAMBLE + PN532_STARTCODE1 + PN532_STARTCODE2;
@@ -471,73 +535,72 @@ bool DFRobot_PN532_IIC::readAck(int x,long timeout ) {
     pn532ack[4] = 0xFF;
     pn532ack[5] = 0x00;
 	timeout = 0;
-    if(_mode == 1){
-    if(!waitRemind())
+    if(x > (int)sizeof(receiveACK))
+        x = sizeof(receiveACK);
+    /*! Wait for the chip to say each frame is ready, then read it in one burst instead of sleeping a fixed time*/
+    if(!waitReady(PN532_ACK_TIMEOUT) || !readFrame(receiveACK, 6))
         return false;
-    Wire.requestFrom(I2C_ADDRESS,8);
-    Wire.read();
-    for(int i = 0; i < 6; i++){
-        delay(1);
-        receiveACK[i]= Wire.read();
-    }
-    if(!waitRemind() ) return false;
-    
-    Wire.requestFrom(I2C_ADDRESS,x-4);
-    Wire.read();
-    for(int i = 0; i < x - 6; i++){
-        delay(1);
-        receiveACK[6 + i] = Wire.read();
-    }
-    
-    }
-    else if(_mode == 0){
-    delay(30);
-    Wire.requestFrom(I2C_ADDRESS,8);
-    Wire.read();
-    for(int i = 0; i < 6; i++){
-        delay(1);
-        receiveACK[i]= Wire.read();
-    }
-    
-    delay(30);
-    Wire.requestFrom(I2C_ADDRESS,x-4);
-    Wire.read();
-    for(int i = 0; i < x - 6; i++){
-        delay(1);
-        receiveACK[6 + i] = Wire.read();
-    }
-    }
     if(strncmp((char *)pn532ack,(char *)receiveACK, 6)!=0){
         return false ;
     }
+    if(!waitReady(PN532_FRAME_TIMEOUT) || !readFrame(receiveACK + 6, x - 6))
+        return false;
+    /*! Check the frame: start code, LEN + LCS == 0, TFI..DCS sums to 0 and the whole frame was read,
+        callers read the largest frame their command returns and LEN may not run past receiveACK*/
+    uint8_t len = receiveACK[9];
+    if(receiveACK[6] != PN532_PREAMBLE || receiveACK[7] != PN532_STARTCODE1 || receiveACK[8] != PN532_STARTCODE2)
+        return false;
+    if((uint8_t)(len + receiveACK[10]) != 0 || 11 + len + 1 > x)
+        return false;
+    uint8_t sum = 0;
+    for(int i = 11; i < 11 + len + 1; i++)
+        sum += receiveACK[i];
+    return sum == 0;
+}
+
+bool DFRobot_PN532_IIC::waitReady(uint16_t timeout){
+    uint32_t start = millis();
+    while(true){
+        if(_mode == 1){
+            /*! IRQ goes low when a frame is ready, the interrupt catches short pulses between polls*/
+            if(_irqFired || digitalRead(_irq) == LOW){
+                _irqFired = false;
+                return true;
+            }
+        }
+        else{
+            Wire.requestFrom(I2C_ADDRESS,1);
+            if(Wire.available() && (Wire.read() & PN532_I2C_READY))
+                return true;
+        }
+        if(millis() - start >= timeout)
+            return false;
+    }
+}
+
+bool DFRobot_PN532_IIC::readFrame(uint8_t *frame, uint8_t len){
+    /*! One transaction for the whole frame, the first byte is the ready status*/
+    if(Wire.requestFrom(I2C_ADDRESS,len + 1) != (size_t)(len + 1))
+        return false;
+    if(!(Wire.read() & PN532_I2C_READY))
+        return false;
+    for(int i = 0; i < len; i++)
+        frame[i] = Wire.read();
     return true;
 }
+
+volatile bool DFRobot_PN532_IIC::_irqFired = false;
+
+void DFRobot_PN532_IIC::irqHandler(void){
+    _irqFired = true;
+}
+
 DFRobot_PN532_IIC::DFRobot_PN532_IIC(uint8_t irq,uint8_t mode){
     
     _irq = irq;
     pinMode(_irq, INPUT);
     _mode = mode;
 }
-bool DFRobot_PN532_IIC::waitRemind(){
-    uint16_t timeout = 1000;
-    uint16_t timer = 0;
-     //digitalRead(_irq)
-    //return ret == 0;
-    //bool b = digitalRead(_irq);
-    //Serial.println(b);
-    while(digitalRead(_irq)!=0){
-        //Serial.print(digitalRead(_irq));
-    if (timeout != 0) {
-      timer += 10;
-      if (timer > timeout) {
-        return false;
-      }
-    }
-    delay(10);
-    }
-    //Serial.print(digitalRead(_irq));
-    return true;
-}
 bool DFRobot_PN532_IIC::begin(void) {   //nfc Module initialization  
     this->nfcPassword[0] = 0xff;
     this->nfcPassword[1] = 0xff;
@@ -551,6 +614,8 @@ bool DFRobot_PN532_IIC::begin(void) {   //nfc Module initialization
     cmdWrite[2] = 0x14; // timeout 50ms * 20 = 1 second
     cmdWrite[3] = 0x01; // use IRQ pin!
     Wire.begin();
+    if(_mode == 1)
+        attachInterrupt(_irq, irqHandler, FALLING);
     nfcEnable = true;
     writeCommand(cmdWrite,4);
     delay(10);
@@ -28,6 +28,11 @@
 #define COMMAND_INLISTPASSIVETARGET         (0x4A)
 #define COMMAND_INDATAEXCHANGE              (0x40)
 #define I2C_ADDRESS                    (0x48 >> 1)//Device address
+#define PN532_I2C_READY                     (0x01)//Status byte sent before every I2C frame, bit 0 set when data is ready
+#define PN532_ACK_TIMEOUT                   (10  )//ms to wait for the ACK frame
+#define PN532_FRAME_TIMEOUT                 (30  )//ms to wait for the response frame
+#define PN532_LIST_FRAME                    (31  )//Bytes to read for an InListPassiveTarget reply: ACK + frame with a 10 byte UID
+#define PN532_READ_FRAME                    (32  )//Bytes to read for an InDataExchange reply to a 16 byte READ: ACK + frame
 #define MIFARE_ISO14443A                    (0x00)
 // CARD Commands
 #define CARD_CMD_READING                     (0x30)//Command to read data
@@ -57,6 +62,14 @@ public:
       uint8_t uid[7];    /**<Uid content*/
       char cardType[30]={0};/**<The chip type*/
   }sCard_t;
+  typedef struct{
+      uint32_t scanTime;   /**<Total us spent selecting cards (InListPassiveTarget)*/
+      uint32_t authTime;   /**<Total us spent on sector authentication*/
+      uint32_t readTime;   /**<Total us spent reading blocks*/
+      uint16_t scanCount;
+      uint16_t authCount;
+      uint16_t readCount;
+  }sTiming_t;
 public: 
    /*!
     * @fn readData
@@ -169,6 +182,41 @@ public:
     * @return Info. of the sCard_t.
     */
    sCard_t getInformation();
+
+   /*!
+    * @fn beginSession
+    * @brief Select a MIFARE Classic card once so several blocks can be read without scanning again.
+    * @return Boolean type, the result of operation
+    * @retval true a card was found and selected
+    * @retval false no card
+    */
+   bool  beginSession(void);
+
+   /*!
+    * @fn readBlocks
+    * @brief Read consecutive blocks from the card selected by beginSession(), authenticating each sector only once.
+    * @param buffer The buffer of the read data, count * 16 bytes.
+    * @param block The number of the first block to read.
+    * @param count The number of blocks to read.
+    * @return Boolean type, the result of operation
+    * @retval true all blocks were read
+    * @retval false no session or a read failed, the session is closed
+    */
+   bool  readBlocks(uint8_t *buffer, uint8_t block, uint8_t count);
+
+   /*!
+    * @fn endSession
+    * @brief Forget the selected card and its authenticated sector.
+    */
+   void  endSession(void);
+
+   /*!
+    * @fn getTiming
+    * @brief Time spent in each kind of card operation since the last resetTiming().
+    * @return Info. of the sTiming_t.
+    */
+   sTiming_t getTiming() { return _timing; };
+   void  resetTiming(void);
      
 
    uint8_t receiveACK[35];    
@@ -181,6 +229,9 @@ public:
    uint8_t _mode;
      
 private:
+   sTiming_t _timing = {0};
+   bool _session = false;
+   int _authSector = -1;
        
    String readData(int page);
    virtual void writeCommand(uint8_t *command_data, uint8_t bytes)=0;
@@ -215,7 +266,10 @@ public:
 private:
     void writeCommand(uint8_t* cmd, uint8_t cmdlen);
     bool readAck(int x,long timeout = 1000); 
-    bool waitRemind();
+    bool waitReady(uint16_t timeout);
+    bool readFrame(uint8_t *frame, uint8_t len);
+    static void irqHandler(void);
+    static volatile bool _irqFired;
 };
 
 class DFRobot_PN532_UART:public DFRobot_PN532
@@ -30,6 +30,8 @@ void MAX6675::begin(const uint8_t clock, const uint8_t select, const uint8_t mis
   _status       = STATUS_NOREAD;
   _temperature  = MAX6675_NO_TEMPERATURE;
   _rawData      = 0;
+  _readTime     = 0;
+  _cal.count    = 0;
   setSPIspeed(1000000);
 
   pinMode(_select, OUTPUT);
@@ -91,7 +93,13 @@ void MAX6675::setGPIOpins(uint8_t clock, uint8_t miso, uint8_t mosi, uint8_t sel
 
 uint8_t MAX6675::read()
 {
-  //  return value of _read()  page 5 datasheet
+  return _decode(_read());
+}
+
+
+uint8_t MAX6675::_decode(uint16_t value)
+{
+  //  frame from _read()  page 5 datasheet
   //  BITS       DESCRIPTION
   //  ------------------------------
   //       00    three state ?
@@ -99,7 +107,6 @@ uint8_t MAX6675::read()
   //       02    INPUT OPEN
   //  03 - 14    TEMPERATURE (RAW)
   //       15    SIGN
-  uint16_t value = _read();
 
   //  needs a pull up on MISO pin to work properly!
   if (value == 0xFFFF)
@@ -123,17 +130,102 @@ uint8_t MAX6675::read()
 }
 
 
+float MAX6675::getTemperature(void)
+{
+  if (_cal.count == 0 || _temperature == MAX6675_NO_TEMPERATURE)
+  {
+    return _temperature + _offset;
+  }
+  //  the offset trims whatever the table gives
+  if (_cal.count == 1)
+  {
+    return _temperature + (_cal.actual[0] - _cal.measured[0]) + _offset;
+  }
+  //  find the segment, the first and last are extended past the ends
+  uint8_t i = 1;
+  while (i < _cal.count - 1 && _temperature > _cal.measured[i]) i++;
+  float m0 = _cal.measured[i - 1], m1 = _cal.measured[i];
+  float a0 = _cal.actual[i - 1],   a1 = _cal.actual[i];
+  return a0 + (_temperature - m0) * (a1 - a0) / (m1 - m0) + _offset;
+}
+
+
+bool MAX6675::setCalibration(const float * measured, const float * actual, uint8_t count)
+{
+  if (count > MAX6675_CAL_POINTS) return false;
+  for (uint8_t i = 1; i < count; i++)
+  {
+    if (measured[i] <= measured[i - 1]) return false;
+  }
+  for (uint8_t i = 0; i < count; i++)
+  {
+    _cal.measured[i] = measured[i];
+    _cal.actual[i]   = actual[i];
+  }
+  _cal.count = count;
+  return true;
+}
+
+
+bool MAX6675::loadCalibration(int address)
+{
+  MAX6675Calibration cal;
+  EEPROM.get(address, cal);
+  if (cal.magic != MAX6675_CAL_MAGIC || cal.version != MAX6675_CAL_VERSION) return false;
+  if (cal.count > MAX6675_CAL_POINTS || cal.checksum != _calChecksum(cal)) return false;
+  return setCalibration(cal.measured, cal.actual, cal.count);
+}
+
+
+void MAX6675::saveCalibration(int address)
+{
+  _cal.magic    = MAX6675_CAL_MAGIC;
+  _cal.version  = MAX6675_CAL_VERSION;
+  _cal.checksum = _calChecksum(_cal);
+  EEPROM.put(address, _cal);
+}
+
+
+//  Fletcher-16 over everything before the checksum
+uint16_t MAX6675::_calChecksum(const MAX6675Calibration &cal)
+{
+  const uint8_t * p = (const uint8_t *) &cal;
+  uint16_t sum1 = 0, sum2 = 0;
+  for (size_t i = 0; i < offsetof(MAX6675Calibration, checksum); i++)
+  {
+    sum1 = (sum1 + p[i]) % 255;
+    sum2 = (sum2 + sum1) % 255;
+  }
+  return (sum2 << 8) | sum1;
+}
+
+
 uint32_t MAX6675::_read(void)
 {
+  uint32_t start = micros();
   _rawData = 0;
+  //  SIMULATED FRAME
+  if (_frameSource != NULL)
+  {
+    _rawData = _frameSource();
+    _readTime = micros() - start;
+    return _rawData;
+  }
   //  DATA TRANSFER
   if (_hwSPI)
   {
     mySPI->beginTransaction(_spi_settings);
     digitalWrite(_select, LOW);
+    #if defined(PARTICLE)
+    //  both bytes in one DMA transfer, no callback so it returns when done
+    uint8_t frame[2];
+    mySPI->transfer(NULL, frame, 2, NULL);
+    _rawData = (frame[0] << 8) | frame[1];
+    #else
     _rawData = mySPI->transfer(0);
     _rawData <<= 8;
     _rawData += mySPI->transfer(0);
+    #endif
     digitalWrite(_select, HIGH);
     mySPI->endTransaction();
   }
@@ -156,6 +248,7 @@ uint32_t MAX6675::_read(void)
     digitalWrite(_select, HIGH);
   }
 
+  _readTime = micros() - start;
   return _rawData;
 }
 
@@ -37,6 +37,26 @@
 //  K_TC == 41.276 µV/°C
 
 
+//  returns a raw 16 bit frame in place of the SPI transfer, used for simulation
+typedef uint16_t (*MAX6675FrameSource)();
+
+
+//  piecewise linear calibration, measured -> actual °C
+#define MAX6675_CAL_POINTS                8
+#define MAX6675_CAL_MAGIC                 0x6675
+#define MAX6675_CAL_VERSION               1
+
+struct MAX6675Calibration
+{
+  uint16_t magic;
+  uint8_t  version;
+  uint8_t  count;
+  float    measured[MAX6675_CAL_POINTS];   //  ascending
+  float    actual[MAX6675_CAL_POINTS];
+  uint16_t checksum;
+};
+
+
 class MAX6675
 {
 public:
@@ -50,16 +70,30 @@ public:
 
   //       returns state - bit field: 0 = STATUS_OK
   uint8_t  read();
-  float    getTemperature(void)  { return _temperature + _offset; };
+  //       through the calibration table when one is set, then plus the offset
+  float    getTemperature(void);
 
   uint8_t  getStatus(void) const { return _status; };
 
-  //       use offset to calibrate the TC.
+  //       use offset to calibrate the TC, added on top of the calibration table
+  //       when there is one so it can trim a stored table.
   void     setOffset(const float  t)   { _offset = t; };
   float    getOffset() const           { return _offset; };
 
+  //       multi point calibration, count pairs of measured and actual °C with
+  //       measured ascending. Outside the table the end segments are extended.
+  //       count 0 clears the table, leaving just the offset.
+  bool     setCalibration(const float * measured, const float * actual, uint8_t count);
+  uint8_t  getCalibrationPoints() const { return _cal.count; };
+  bool     isCalibrated() const { return _cal.count > 0; };
+  //       keep the table in EEPROM at address, load returns false if none is stored
+  bool     loadCalibration(int address);
+  void     saveCalibration(int address);
+
   uint32_t lastRead()    { return _lastTimeRead; };
   uint16_t getRawData()  { return _rawData;};
+  //       µs the last SPI transfer (or frame source call) took, to compare HW and SW SPI
+  uint32_t getReadTime() { return _readTime; };
 
   //       speed in Hz
   void     setSPIspeed(uint32_t speed);
@@ -67,6 +101,9 @@ public:
   void     setSWSPIdelay(uint16_t del = 0)  { _swSPIdelay = del; };
   uint16_t getSWSPIdelay() { return _swSPIdelay; };
 
+  //       replace the chip with a frame source (e.g. an oven model), NULL restores SPI
+  void     setFrameSource(MAX6675FrameSource source) { _frameSource = source; };
+
 
   //       ESP32 specific
   #if defined(ESP32)
@@ -81,20 +118,28 @@ public:
 
 
 private:
+  //  MAX6675Array clocks a whole chain in one transaction and hands each chip its frame
+  friend class MAX6675Array;
+
   uint32_t _read();
+  uint8_t  _decode(uint16_t value);
+  uint16_t _calChecksum(const MAX6675Calibration &cal);
 
   uint8_t  _status;
   float    _temperature;
   float    _offset;
   uint32_t _lastTimeRead;
   uint16_t _rawData;
+  uint32_t _readTime;
   bool     _hwSPI;
+  MAX6675Calibration _cal;
 
   uint8_t  _clock;
   uint8_t  _miso;
   uint8_t  _select;
 
   uint16_t    _swSPIdelay = 0;
+  MAX6675FrameSource _frameSource = NULL;
   uint32_t    _SPIspeed;
   SPIClass    * mySPI;
   SPISettings _spi_settings;
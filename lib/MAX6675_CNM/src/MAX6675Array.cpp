@@ -0,0 +1,170 @@
+//    FILE: MAX6675Array.cpp
+// PURPOSE: Several MAX6675 chips on one SPI bus, shared SCK and MISO with a chip select each
+
+#include "MAX6675Array.h"
+
+
+MAX6675Array::MAX6675Array()
+{
+  _count     = 0;
+  _faultMask = 0;
+  _readTime  = 0;
+  for (uint8_t i = 0; i < MAX6675_ARRAY_SIZE; i++)
+  {
+    _weight[i] = 1.0;
+  }
+}
+
+
+bool MAX6675Array::begin(const uint8_t * selects, uint8_t count)
+{
+  if (count == 0 || count > MAX6675_ARRAY_SIZE) return false;
+  _count = count;
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    _zone[i].begin(selects[i]);
+  }
+  return true;
+}
+
+
+uint8_t MAX6675Array::read()
+{
+  uint16_t frame[MAX6675_ARRAY_SIZE];
+  uint32_t start = micros();
+
+  //  SIMULATED FRAMES
+  if (_frameSource != NULL)
+  {
+    for (uint8_t i = 0; i < _count; i++)
+    {
+      frame[i] = _frameSource(i);
+    }
+  }
+  //  DATA TRANSFER
+  else
+  {
+    //  one transaction for the whole array, only the chip select moves between chips
+    SPIClass * spi = _zone[0].mySPI;
+    spi->beginTransaction(_zone[0]._spi_settings);
+    for (uint8_t i = 0; i < _count; i++)
+    {
+      digitalWrite(_zone[i]._select, LOW);
+      #if defined(PARTICLE)
+      uint8_t buf[2];
+      spi->transfer(NULL, buf, 2, NULL);
+      frame[i] = (buf[0] << 8) | buf[1];
+      #else
+      frame[i] = spi->transfer(0);
+      frame[i] <<= 8;
+      frame[i] += spi->transfer(0);
+      #endif
+      digitalWrite(_zone[i]._select, HIGH);
+    }
+    spi->endTransaction();
+  }
+  _readTime = micros() - start;
+
+  _faultMask = 0;
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    _zone[i]._rawData = frame[i];
+    if (_zone[i]._decode(frame[i]) != STATUS_OK) _faultMask |= (1 << i);
+  }
+
+  uint8_t status = STATUS_NOREAD;
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    if (_weight[i] <= 0) continue;
+    if (_zone[i].getStatus() == STATUS_OK) return STATUS_OK;
+    if (status == STATUS_NOREAD) status = _zone[i].getStatus();
+  }
+  return status;
+}
+
+
+float MAX6675Array::getAverage()
+{
+  float   sum = 0;
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    if (_faultMask & (1 << i)) continue;
+    sum += _zone[i].getTemperature();
+    n++;
+  }
+  if (n == 0) return MAX6675_NO_TEMPERATURE;
+  return sum / n;
+}
+
+
+float MAX6675Array::getMax()
+{
+  float value = MAX6675_NO_TEMPERATURE;
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    if (_faultMask & (1 << i)) continue;
+    float t = _zone[i].getTemperature();
+    if (value == MAX6675_NO_TEMPERATURE || t > value) value = t;
+  }
+  return value;
+}
+
+
+float MAX6675Array::getMin()
+{
+  float value = MAX6675_NO_TEMPERATURE;
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    if (_faultMask & (1 << i)) continue;
+    float t = _zone[i].getTemperature();
+    if (value == MAX6675_NO_TEMPERATURE || t < value) value = t;
+  }
+  return value;
+}
+
+
+void MAX6675Array::setWeight(uint8_t zone, float weight)
+{
+  if (zone >= MAX6675_ARRAY_SIZE) return;
+  _weight[zone] = (weight > 0) ? weight : 0;
+}
+
+
+float MAX6675Array::getWeighted()
+{
+  float sum = 0, total = 0;
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    if (_weight[i] <= 0 || (_faultMask & (1 << i))) continue;
+    sum   += _weight[i] * _zone[i].getTemperature();
+    total += _weight[i];
+  }
+  if (total == 0) return MAX6675_NO_TEMPERATURE;
+  return sum / total;
+}
+
+
+bool MAX6675Array::isCalibrated()
+{
+  bool weighted = false;
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    if (_weight[i] <= 0) continue;
+    if (!_zone[i].isCalibrated()) return false;
+    weighted = true;
+  }
+  return weighted;
+}
+
+
+void MAX6675Array::setSPIspeed(uint32_t speed)
+{
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    _zone[i].setSPIspeed(speed);
+  }
+}
+
+
+//  -- END OF FILE --
@@ -0,0 +1,82 @@
+#pragma once
+//    FILE: MAX6675Array.h
+// PURPOSE: Several MAX6675 chips on one SPI bus, shared SCK and MISO with a chip select each
+//
+//  SCK  ----+-----------+-----------+----
+//  MISO ----+-----------+-----------+----
+//           |           |           |
+//       [MAX6675 0] [MAX6675 1] [MAX6675 2] ...
+//           |           |           |
+//  SS      CS0         CS1         CS2
+
+
+#include "MAX6675.h"
+
+
+#define MAX6675_ARRAY_SIZE                4
+
+
+//  returns a raw 16 bit frame for one zone in place of the SPI transfer, used for simulation
+typedef uint16_t (*MAX6675ZoneFrameSource)(uint8_t zone);
+
+
+class MAX6675Array
+{
+public:
+
+  MAX6675Array();
+
+  //  HW SPI, one chip select per zone
+  //       returns false if count is 0 or larger than MAX6675_ARRAY_SIZE
+  bool     begin(const uint8_t * selects, uint8_t count);
+
+  //       reads all zones back to back in one SPI transaction.
+  //       returns STATUS_OK if any weighted zone read OK,
+  //       otherwise the status of the first weighted zone
+  uint8_t  read();
+
+  uint8_t  getCount() const { return _count; };
+  //       the chip behind a zone, for calibration and raw data
+  MAX6675 & zone(uint8_t zone) { return _zone[zone]; };
+
+  //       per zone view
+  float    getTemperature(uint8_t zone) { return _zone[zone].getTemperature(); };
+  uint8_t  getStatus(uint8_t zone)      { return _zone[zone].getStatus(); };
+  //       bit per zone that failed the last read
+  uint8_t  getFaultMask() const         { return _faultMask; };
+
+  //       over the zones that read OK, MAX6675_NO_TEMPERATURE if none did
+  float    getAverage();
+  float    getMax();
+  float    getMin();
+
+  //       weighted view for regulation. Weights do not need to add up to 1,
+  //       a failed zone drops out and the others are scaled up to make up for it.
+  //       All zones start at weight 1, 0 leaves a zone out (e.g. a food probe).
+  void     setWeight(uint8_t zone, float weight);
+  float    getWeight(uint8_t zone) { return _weight[zone]; };
+  float    getWeighted();
+  //       true if every weighted zone has a calibration table
+  bool     isCalibrated();
+
+  //       speed in Hz, for all zones
+  void     setSPIspeed(uint32_t speed);
+  //       µs the last read of the whole array took
+  uint32_t getReadTime() { return _readTime; };
+
+  //       replace the chips with a frame source (e.g. an oven model), NULL restores SPI
+  void     setFrameSource(MAX6675ZoneFrameSource source) { _frameSource = source; };
+
+
+private:
+  MAX6675  _zone[MAX6675_ARRAY_SIZE];
+  float    _weight[MAX6675_ARRAY_SIZE];
+  uint8_t  _count;
+  uint8_t  _faultMask;
+  uint32_t _readTime;
+
+  MAX6675ZoneFrameSource _frameSource = NULL;
+};
+
+
+//  -- END OF FILE --
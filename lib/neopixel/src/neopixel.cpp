@@ -84,15 +84,42 @@
 #define pinSet(_pin, _hilo) (_hilo ? pinHI(_pin) : pinLO(_pin))
 
 #if (PLATFORM_ID == 32)
+volatile bool Adafruit_NeoPixel::dmaBusy[HAL_PLATFORM_SPI_NUM];
+
 Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, SPIClass& spi, uint8_t t) :
-  begun(false), type(t), brightness(0), pixels(NULL), endTime(0)
+  begun(false), type(t), brightness(0), pixels(NULL), endTime(0),
+  lastFrame(0), framesSent(0), framesSkipped(0), bytesSent(0), frameValid(false),
+  spi_(&spi), spiBuffer(NULL), sentPixels(NULL), spiBufferSize(0)
 {
   updateLength(n);
-  spi_ = &spi;
+}
+
+// DMA completion callbacks, the HAL gives them no context so there is one per interface
+void Adafruit_NeoPixel::dmaDone1(void) {
+  dmaBusy[HAL_SPI_INTERFACE1] = false;
+}
+
+void Adafruit_NeoPixel::dmaDone2(void) {
+  dmaBusy[HAL_SPI_INTERFACE2] = false;
+}
+
+// SPI bits for each nibble of a pixel byte, MSB first. Each WS2812B bit is
+// three SPI bits at 3.125MHz: 110 for a one and 100 for a zero.
+static const uint16_t nibbleBits[16] = {
+  0x924, 0x926, 0x934, 0x936, 0x9A4, 0x9A6, 0x9B4, 0x9B6,
+  0xD24, 0xD26, 0xD34, 0xD36, 0xDA4, 0xDA6, 0xDB4, 0xDB6
+};
+
+static inline void encodeByte(uint8_t *out, uint8_t v) {
+  uint32_t bits = ((uint32_t)nibbleBits[v >> 4] << 12) | nibbleBits[v & 0x0F];
+  out[0] = bits >> 16;
+  out[1] = bits >> 8;
+  out[2] = bits;
 }
 #else
 Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, uint8_t p, uint8_t t) :
-  begun(false), type(t), brightness(0), pixels(NULL), endTime(0)
+  begun(false), type(t), brightness(0), pixels(NULL), endTime(0),
+  lastFrame(0), framesSent(0), framesSkipped(0), bytesSent(0), frameValid(false)
 {
   updateLength(n);
   setPin(p);
@@ -103,6 +130,9 @@ Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, uint8_t p, uint8_t t) :
 Adafruit_NeoPixel::~Adafruit_NeoPixel() {
   if (pixels) free(pixels);
 #if (PLATFORM_ID == 32)
+  while (!canShow());
+  if (spiBuffer) free(spiBuffer);
+  if (sentPixels) free(sentPixels);
   spi_->end();
 #else
   if (begun) pinMode(pin, INPUT);
@@ -119,6 +149,15 @@ uint8_t Adafruit_NeoPixel::getType() const {
 
 void Adafruit_NeoPixel::updateLength(uint16_t n) {
   if (pixels) free(pixels); // Free existing data (if any)
+#if (PLATFORM_ID == 32)
+  // The bitstream is sized for the old length, show() builds a new one
+  if (spiBuffer) {
+    while (!canShow());
+    free(spiBuffer);
+    free(sentPixels);
+    spiBuffer = sentPixels = NULL;
+  }
+#endif
 
   // Allocate new data -- note: ALL PIXELS ARE CLEARED
   numBytes = n * ((type == SK6812RGBW) ? 4 : 3);
@@ -128,6 +167,7 @@ void Adafruit_NeoPixel::updateLength(uint16_t n) {
   } else {
     numLEDs = numBytes = 0;
   }
+  frameValid = false;
 }
 
 void Adafruit_NeoPixel::begin(void) {
@@ -191,6 +231,17 @@ void Adafruit_NeoPixel::setPin(uint8_t p) {
 void Adafruit_NeoPixel::show(void) {
   if(!pixels) return;
 
+  // Skip the whole transmission (and the latch wait) if the buffer is the
+  // same as the last frame sent. Hashing rather than a dirty flag also
+  // catches writes through getPixels() and colors set to what they were.
+  uint32_t hash = frameHash();
+  if(frameValid && hash == lastFrame) {
+    framesSkipped++;
+    return;
+  }
+  lastFrame = hash;
+  frameValid = true;
+
 #if (PLATFORM_ID != 32)
   // Data latch = 24 or 50 microsecond pause in the output stream.  Rather than
   // put a delay at the end of the function, the ending time is noted and
@@ -878,45 +929,59 @@ void Adafruit_NeoPixel::show(void) {
     return;
   }
 
-  constexpr uint8_t PIX_HI = 0b110;
-  constexpr uint8_t PIX_LO = 0b100;
+  // The last frame may still be going out, its bitstream can't change under the DMA
+  while (!canShow());
 
-  uint16_t resetOff = 120; // 300us / (1/3125000Mhz) / 8bits_per_byte
-  switch (type) {
-    case WS2812B: { // WS2812, WS2812B & WS2813 = 300us reset pulse
-        resetOff = 120;
-      } break;
-    case WS2812B_FAST: // WS2812B_FAST = 50us reset pulse
-    default: {   // default = 50us reset pulse
-        resetOff = 20;
-      } break;
-  }
-
-  constexpr uint8_t numBitsPerBit = 3; // How many SPI bits represent one neopixel bit
-  uint32_t spiArraySize = (numBytes * numBitsPerBit) + resetOff + resetOff;
-  uint8_t* spiArray = NULL;
-  spiArray = (uint8_t*) malloc(spiArraySize);
+  if (spiBuffer == NULL) {
+    uint16_t resetOff = 120; // 300us / (1/3125000Mhz) / 8bits_per_byte
+    switch (type) {
+      case WS2812B: { // WS2812, WS2812B & WS2813 = 300us reset pulse
+          resetOff = 120;
+        } break;
+      case WS2812B_FAST: // WS2812B_FAST = 50us reset pulse
+      default: {   // default = 50us reset pulse
+          resetOff = 20;
+        } break;
+    }
 
-  if (spiArray == NULL) {
-    Log.error("Not enough memory available!");
-    return;
-  }
+    constexpr uint8_t numBitsPerBit = 3; // How many SPI bits represent one neopixel bit
+    spiBufferSize = (numBytes * numBitsPerBit) + resetOff + resetOff;
+    spiBuffer = (uint8_t*) malloc(spiBufferSize);
+    sentPixels = (uint8_t*) malloc(numBytes);
+
+    if (spiBuffer == NULL || sentPixels == NULL) {
+      Log.error("Not enough memory available!");
+      if (spiBuffer) free(spiBuffer);
+      if (sentPixels) free(sentPixels);
+      spiBuffer = sentPixels = NULL;
+      frameValid = false; // Nothing went out, try again next time
+      return;
+    }
 
-  memset(spiArray, 0, spiArraySize);
-  // expand pixel data and pack into spi buffer
-  for (int x = 0; x < numPixels(); x++) {
-    for (int s = 0; s < 3; s++) {
-      spiArray[(x*9)+(s*3)+0+resetOff] = ((0x80 & pixels[(x*3)+s])?(PIX_HI << 5):(PIX_LO << 5)) + ((0x40 & pixels[(x*3)+s])?(PIX_HI << 2):(PIX_LO << 2)) + ((0x20 & pixels[(x*3)+s])?(0b11):(0b10));
-      spiArray[(x*9)+(s*3)+1+resetOff] = 0 /* bit 7 always 0 */ + ((0x10 & pixels[(x*3)+s])?(PIX_HI << 4):(PIX_LO << 4)) + ((0x08 & pixels[(x*3)+s])?(PIX_HI << 1):(PIX_LO << 1)) + 1 /* bit 0 always 1 */;
-      spiArray[(x*9)+(s*3)+2+resetOff] = ((0x04 & pixels[(x*3)+s])?(0b10 << 6):(0b00 << 6)) + ((0x02 & pixels[(x*3)+s])?(PIX_HI << 3):(PIX_LO << 3)) + ((0x01 & pixels[(x*3)+s])?(PIX_HI):(PIX_LO));
+    // Reset padding on both ends stays zero, encode every byte once
+    memset(spiBuffer, 0, spiBufferSize);
+    for (uint16_t i = 0; i < numBytes; i++) {
+      encodeByte(&spiBuffer[(i * 3) + resetOff], pixels[i]);
+    }
+    memcpy(sentPixels, pixels, numBytes);
+  } else {
+    // Only bytes that changed since the last frame need encoding again
+    uint16_t resetOff = (spiBufferSize - (numBytes * 3)) / 2;
+    for (uint16_t i = 0; i < numBytes; i++) {
+      if (pixels[i] != sentPixels[i]) {
+        encodeByte(&spiBuffer[(i * 3) + resetOff], pixels[i]);
+        sentPixels[i] = pixels[i];
+      }
     }
   }
 
+  // Hand the frame to the DMA and return, the callback marks the strip idle.
+  // SPI1 only drives the strip (MOSI only), so nothing else waits on the bus.
+  dmaBusy[spi_->interface()] = true;
   spi_->beginTransaction();
-  spi_->transfer(spiArray, nullptr, spiArraySize, nullptr);
+  spi_->transfer(spiBuffer, nullptr, spiBufferSize, (spi_->interface() == HAL_SPI_INTERFACE2) ? dmaDone2 : dmaDone1);
   spi_->endTransaction();
-
-  free(spiArray);
+  bytesSent += spiBufferSize;
 
 #elif HAL_PLATFORM_NRF52840 // Argon, Boron, Xenon, B SoM, B5 SoM, E SoM X, Tracker
 // [[[Begin of the Neopixel NRF52 EasyDMA implementation
@@ -1205,9 +1270,22 @@ void Adafruit_NeoPixel::show(void) {
 
 
 #endif
+#if (PLATFORM_ID != 32)
+  bytesSent += numBytes;
+#endif
+  framesSent++;
   endTime = micros(); // Save EOD time for latch on next call
 }
 
+// FNV-1a over the pixel buffer, used by show() to spot unchanged frames
+uint32_t Adafruit_NeoPixel::frameHash(void) const {
+  uint32_t h = 2166136261UL;
+  for(uint16_t i=0; i<numBytes; i++) {
+    h = (h ^ pixels[i]) * 16777619UL;
+  }
+  return h;
+}
+
 // Set pixel color from separate R,G,B components:
 void Adafruit_NeoPixel::setPixelColor(
   uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
@@ -1479,3 +1557,41 @@ uint8_t Adafruit_NeoPixel::getBrightness(void) const {
 void Adafruit_NeoPixel::clear(void) {
   memset(pixels, 0, numBytes);
 }
+
+// Fill count pixels from first with one packed color, count 0 fills to the
+// end of the strip. Only the buffer changes, call show() once afterwards.
+void Adafruit_NeoPixel::fill(uint32_t c, uint16_t first, uint16_t count) {
+  if(first >= numLEDs) return;
+  uint16_t end = (count == 0 || count > numLEDs - first) ? numLEDs : first + count;
+  for(uint16_t i=first; i<end; i++) {
+    setPixelColor(i, c);
+  }
+}
+
+// Set pixels first up to (not including) end to one packed color
+void Adafruit_NeoPixel::setRange(uint16_t first, uint16_t end, uint32_t c) {
+  if(end > numLEDs) end = numLEDs;
+  if(first >= end) return;
+  fill(c, first, end - first);
+}
+
+// False while a frame is still being sent by DMA, show() waits for it
+bool Adafruit_NeoPixel::canShow(void) const {
+#if (PLATFORM_ID == 32)
+  return !dmaBusy[spi_->interface()];
+#else
+  return true;
+#endif
+}
+
+uint32_t Adafruit_NeoPixel::getFramesSent(void) const {
+  return framesSent;
+}
+
+uint32_t Adafruit_NeoPixel::getFramesSkipped(void) const {
+  return framesSkipped;
+}
+
+uint32_t Adafruit_NeoPixel::getBytesSent(void) const {
+  return bytesSent;
+}
@@ -95,7 +95,9 @@ class Adafruit_NeoPixel {
     setColorDimmed(uint16_t aLedNumber, byte aRed, byte aGreen, byte aBlue, byte aBrightness),
     setColorDimmed(uint16_t aLedNumber, byte aRed, byte aGreen, byte aBlue, byte aWhite, byte aBrightness),
     updateLength(uint16_t n),
-    clear(void);
+    clear(void),
+    fill(uint32_t c, uint16_t first=0, uint16_t count=0),
+    setRange(uint16_t first, uint16_t end, uint32_t c);
   uint8_t
    *getPixels() const,
     getBrightness(void) const,
@@ -111,6 +113,12 @@ class Adafruit_NeoPixel {
     getPixelColor(uint16_t n) const;
   byte
     brightnessToPWM(byte aBrightness);
+  bool
+    canShow(void) const;
+  uint32_t
+    getFramesSent(void) const,
+    getFramesSkipped(void) const,
+    getBytesSent(void) const;
 
  private:
 
@@ -126,10 +134,28 @@ class Adafruit_NeoPixel {
     brightness,
    *pixels;        // Holds LED color values (3 bytes each)
   uint32_t
-    endTime;       // Latch timing reference
+    endTime,       // Latch timing reference
+    lastFrame,     // Hash of the pixel buffer at the last show()
+    framesSent,
+    framesSkipped, // show() calls with nothing changed
+    bytesSent;     // Bytes on the wire, including reset padding
+  bool
+    frameValid;    // false until the first frame has gone out
+  uint32_t
+    frameHash(void) const;
 #if (PLATFORM_ID == 32)
   SPIClass*
     spi_;
+  uint8_t
+   *spiBuffer,     // SPI bitstream, kept between frames so only changed bytes are encoded
+   *sentPixels;    // The pixel bytes spiBuffer was encoded from
+  uint16_t
+    spiBufferSize;
+  static volatile bool
+    dmaBusy[HAL_PLATFORM_SPI_NUM]; // A frame is still going out on that interface
+  static void
+    dmaDone1(void),
+    dmaDone2(void);
 #endif
 };
 
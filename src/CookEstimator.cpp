@@ -0,0 +1,56 @@
+#include "CookEstimator.h"
+
+CookEstimator::CookEstimator() {
+  _setpoint = 0;
+  _target = 0;
+  _dose = 0;
+  _rate = 1.0;
+  _start = 0;
+  _lastUpdate = 0;
+  _limit = 0;
+  _running = false;
+}
+
+void CookEstimator::begin(float setpoint, unsigned int cookTime, unsigned int now) {
+  _setpoint = setpoint;
+  _target = cookTime / 1000.0;
+  _dose = 0;
+  _rate = 1.0;      // Assume it is on track until the oven says otherwise
+  _start = now;
+  _lastUpdate = now;
+  _limit = cookTime * DOSESTRETCH;
+  _running = true;
+}
+
+void CookEstimator::update(float temp, unsigned int now) {
+  float dt, rate;
+
+  if(!_running) {
+    return;
+  }
+  dt = (now - _lastUpdate) / 1000.0;
+  _lastUpdate = now;
+
+  rate = constrain((temp - (_setpoint - DOSEBAND)) / DOSEBAND, 0.0f, DOSEMAXRATE);
+  _dose += rate * dt;
+  _rate += (rate - _rate) * dt / (ETASMOOTHING + dt);
+}
+
+bool CookEstimator::isDone(unsigned int now) {
+  return _dose >= _target || (now - _start) >= _limit;
+}
+
+unsigned int CookEstimator::getRemaining() {
+  float remaining;
+  unsigned int elapsed;
+
+  if(_dose >= _target) {
+    return 0;
+  }
+  remaining = (_target - _dose) / max(_rate, DOSEMINRATE) * 1000.0;
+  elapsed = _lastUpdate - _start;
+  if(elapsed >= _limit) {
+    return 0;
+  }
+  return min(remaining, (float)(_limit - elapsed));
+}
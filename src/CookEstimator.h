@@ -0,0 +1,46 @@
+#ifndef _COOKESTIMATOR_H_
+#define _COOKESTIMATOR_H_
+
+#include "Particle.h"
+
+const float DOSEBAND = 100.0;      // F below the setpoint where the food stops cooking
+const float DOSEMAXRATE = 1.25;    // Running hot cooks faster, but no faster than this
+const float DOSEMINRATE = 0.25;    // Floor on the rate behind the ETA so an open door doesn't send it to infinity
+const float DOSESTRETCH = 1.5;     // Never cook for longer than this times the recipe time
+const float ETASMOOTHING = 120.0;  // Time constant of the dose rate behind the ETA in seconds
+
+// Works out when a cook stage is really done from the oven temperature instead of a fixed countdown.
+// Each sample adds thermal dose at a rate of 0 at DOSEBAND below the setpoint rising linearly to 1 at
+// the setpoint, so the dose is in seconds-at-setpoint and the stage ends when it matches the recipe
+// time. An open door or a slow recovery stretches the stage, running hot shortens it. Everything is
+// running sums, nothing is kept per sample.
+class CookEstimator {
+  float _setpoint;
+  float _target;        // Dose the stage needs, s at the setpoint
+  float _dose;          // Dose so far
+  float _rate;          // Smoothed dose rate, for the ETA
+  unsigned int _start, _lastUpdate, _limit;
+  bool _running;
+
+  public:
+    CookEstimator();
+
+    // Starts a stage that would take cookTime ms at the setpoint (F)
+    void begin(float setpoint, unsigned int cookTime, unsigned int now);
+
+    // Adds one filtered temperature sample (F) taken at time now (ms)
+    void update(float temp, unsigned int now);
+
+    // True once the dose is reached or the stage has run DOSESTRETCH times the recipe time
+    bool isDone(unsigned int now);
+
+    // Estimated ms left in the stage at the current smoothed rate
+    unsigned int getRemaining();
+
+    float getDose() { return _dose; };
+    float getRate() { return _rate; };
+    bool isRunning() { return _running; };
+    void stop() { _running = false; };
+};
+
+#endif // _COOKESTIMATOR_H_
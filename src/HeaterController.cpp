@@ -0,0 +1,136 @@
+#include "HeaterController.h"
+
+HeaterController::HeaterController(int relayPin, float kp, float ki, float kd, unsigned int windowSize, unsigned int minSwitchTime) {
+  _relayPin = relayPin;
+  _kp = kp;
+  _ki = ki;
+  _kd = kd;
+  _windowSize = windowSize;
+  _minSwitchTime = minSwitchTime;
+  _setpoint = 0;
+  _feedForward = false;
+  _feedForwardBand = 0;
+  _relayOn = false;
+  _cycles = 0;
+  _onTime = 0;
+  _lastSwitch = 0;
+  _output = 0;
+  _integral = 0;
+  _derivative = 0;
+  _windowDone = false;
+  _firstSample = true;
+}
+
+void HeaterController::begin() {
+  pinMode(_relayPin, OUTPUT);
+  off();
+}
+
+void HeaterController::setSetpoint(float setpoint) {
+  _setpoint = setpoint;
+}
+
+void HeaterController::setTunings(float kp, float ki, float kd) {
+  _kp = kp;
+  _ki = ki;
+  _kd = kd;
+}
+
+void HeaterController::setFeedForward(bool enabled, float band) {
+  _feedForward = enabled;
+  _feedForwardBand = band;
+}
+
+void HeaterController::update(float temp) {
+  unsigned int now, elapsed, onTime;
+  float error, dt, output;
+  bool wasOn;
+
+  now = millis();
+  if(_firstSample) {
+    _lastTemp = temp;
+    _lastUpdate = now;
+    _windowStart = now;
+    _windowDone = false;
+    _derivative = 0;
+    _firstSample = false;
+  }
+  dt = (now - _lastUpdate) / 1000.0;
+  _lastUpdate = now;
+
+  error = _setpoint - temp;
+  if(_feedForward && error > _feedForwardBand) {
+    // Preheating, full power and keep the integral empty so it doesn't wind up
+    _output = 1.0;
+    _integral = 0;
+  }
+  else {
+    // Derivative on measurement so a setpoint change doesn't kick the output, filtered because at 4 Hz
+    // one step of the thermocouple reads as almost 2 F/s
+    if(dt > 0) {
+      _derivative += ((temp - _lastTemp) / dt - _derivative) * min(dt / HEATERDFILTER, 1.0f);
+    }
+    output = _kp * error + _integral - _kd * _derivative;
+
+    // Anti-windup, only integrate when it moves the output back out of saturation
+    if((output < 1.0 || error < 0) && (output > 0 || error > 0)) {
+      _integral = constrain(_integral + _ki * error * dt, 0.0f, 1.0f);
+      output = _kp * error + _integral - _kd * _derivative;
+    }
+    _output = constrain(output, 0.0f, 1.0f);
+  }
+  _lastTemp = temp;
+
+  // Time proportioned relay, on for the first part of each window. A lower output can still end the
+  // on time early, but once off the relay waits for the next window. A turn on held back by the
+  // minimum switch time, e.g. when the last window's turn off ran a little late, is tried again on
+  // the next sample rather than losing the window.
+  if((now - _windowStart) >= _windowSize) {
+    _windowStart += _windowSize * ((now - _windowStart) / _windowSize);
+    _windowDone = false;
+  }
+  elapsed = now - _windowStart;
+  onTime = _output * _windowSize;
+  if(onTime < _minSwitchTime) {
+    onTime = 0;
+  }
+  else if(_windowSize - onTime < _minSwitchTime) {
+    onTime = _windowSize;
+  }
+  wasOn = _relayOn;
+  setRelay(elapsed < onTime && !_windowDone, now);
+  if(wasOn && !_relayOn) {
+    _windowDone = true;
+  }
+}
+
+void HeaterController::off() {
+  if(_relayOn) {
+    _onTime += millis() - _lastSwitch;
+    _lastSwitch = millis();
+  }
+  digitalWrite(_relayPin, LOW);
+  _relayOn = false;
+  _output = 0;
+  _integral = 0;
+  _firstSample = true;
+}
+
+void HeaterController::setRelay(bool on, unsigned int now) {
+  if(on == _relayOn) {
+    return;
+  }
+  // Protect the relay contacts from short cycling
+  if((now - _lastSwitch) < _minSwitchTime) {
+    return;
+  }
+  digitalWrite(_relayPin, on ? HIGH : LOW);
+  if(!on) {
+    _onTime += now - _lastSwitch;
+  }
+  _relayOn = on;
+  _lastSwitch = now;
+  if(on) {
+    _cycles++;
+  }
+}
@@ -0,0 +1,57 @@
+#ifndef _HEATERCONTROLLER_H_
+#define _HEATERCONTROLLER_H_
+
+#include "Particle.h"
+
+const float HEATERDFILTER = 4.0;    // s, low pass on the derivative so single 0.25 C steps don't kick the output
+
+// PID temperature controller for an on/off oven relay. The PID output (0 to 1) is turned into a
+// duty cycle over a fixed time window. The relay comes on at the start of a window and goes off once
+// its share has run, and it isn't turned on again until the next window, so it cycles at most once
+// per window.
+class HeaterController {
+  int _relayPin;
+  float _kp, _ki, _kd;
+  float _setpoint;
+  float _integral;
+  float _lastTemp;
+  float _derivative;            // F/s, filtered
+  float _output;
+  float _feedForwardBand;
+  bool _feedForward;
+  bool _firstSample;
+  bool _relayOn;
+  bool _windowDone;             // The relay was switched off in this window, it stays off until the next
+  unsigned int _windowSize, _minSwitchTime;
+  unsigned int _windowStart, _lastSwitch, _lastUpdate;
+  unsigned int _cycles;
+  unsigned int _onTime;         // ms the relay has been on, not counting the current on period
+
+  void setRelay(bool on, unsigned int now);
+
+  public:
+    HeaterController(int relayPin, float kp, float ki, float kd, unsigned int windowSize, unsigned int minSwitchTime);
+
+    void begin();
+    void setSetpoint(float setpoint);
+    float getSetpoint() { return _setpoint; };
+    void setTunings(float kp, float ki, float kd);
+
+    // While enabled the heater runs flat out until the oven is within band degrees of the setpoint
+    void setFeedForward(bool enabled, float band);
+
+    // Call with each new temperature sample, updates the output and drives the relay
+    void update(float temp);
+
+    // Turns the relay off right away (ignores the minimum switch time) and resets the PID state
+    void off();
+
+    bool isRelayOn() { return _relayOn; };
+    float getOutput() { return _output; };
+    unsigned int getCycles() { return _cycles; };
+
+    // Cumulative ms the relay has been on since boot
+    unsigned int getOnTime() { return _onTime + (_relayOn ? millis() - _lastSwitch : 0); };
+};
+
+#endif // _HEATERCONTROLLER_H_
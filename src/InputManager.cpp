@@ -0,0 +1,219 @@
+#include "InputManager.h"
+
+InputManager *InputManager::_active = NULL;
+
+InputManager::InputManager() {
+  _inputCount = 0;
+  _edgeCount = 0;
+  _overflows = 0;
+  _eventHead = 0;
+  _eventCount = 0;
+  _eventsDropped = 0;
+  for(int i = 0; i < MAXINPUTS; i++) {
+    _overflow[i] = false;
+  }
+}
+
+// attachInterrupt() handlers get no arguments, so there is one per input slot
+void InputManager::edge0() {
+  _active->edge(0);
+}
+
+void InputManager::edge1() {
+  _active->edge(1);
+}
+
+void InputManager::edge2() {
+  _active->edge(2);
+}
+
+void InputManager::edge3() {
+  _active->edge(3);
+}
+
+int InputManager::addInput(int pin, PinMode mode, bool activeLow, unsigned int debounce, unsigned int longPress, unsigned int doubleClick) {
+  inputState *input;
+
+  if(_inputCount == MAXINPUTS) {
+    return -1;
+  }
+  input = &_inputs[_inputCount];
+  input->pin = pin;
+  input->activeLow = activeLow;
+  input->debounce = debounce;
+  input->longPress = longPress;
+  input->doubleClick = doubleClick;
+  input->gestures = longPress > 0 || doubleClick > 0;
+  pinMode(pin, mode);
+  _inputCount++;
+  return _inputCount - 1;
+}
+
+void InputManager::begin() {
+  static void (*const handlers[MAXINPUTS])() = {edge0, edge1, edge2, edge3};
+
+  _active = this;
+  sync();
+  for(int i = 0; i < _inputCount; i++) {
+    attachInterrupt(_inputs[i].pin, handlers[i], CHANGE);
+  }
+}
+
+void InputManager::resume() {
+  begin();
+}
+
+bool InputManager::readPin(int input) {
+  return (pinReadFast(_inputs[input].pin) == HIGH) != _inputs[input].activeLow;
+}
+
+// Interrupt handler, stamps the edge and queues it. If the queue is full the level is read
+// again once it drains, so the latest state is never lost even if some bounces are.
+void InputManager::edge(int input) {
+  rawEdge edge;
+
+  edge.input = input;
+  edge.active = readPin(input);
+  edge.time = millis();
+  _edgeCount++;
+  if(!_edges.push(edge)) {
+    _overflowTime[input] = edge.time;
+    _overflow[input] = true;
+    _overflows++;
+  }
+}
+
+// Starts from the current levels, anything already queued is stale
+void InputManager::sync() {
+  rawEdge edge;
+  inputState *input;
+
+  while(_edges.pop(&edge)) {
+  }
+  for(int i = 0; i < _inputCount; i++) {
+    input = &_inputs[i];
+    input->stable = readPin(i);
+    input->pending = input->stable;
+    input->pendingSince = millis();
+    input->pressStart = millis();
+    // A press that is already down (e.g. the one that woke us) doesn't count as a gesture
+    input->longFired = input->stable;
+    input->secondPress = false;
+    input->clickPending = false;
+    _overflow[i] = false;
+  }
+}
+
+void InputManager::update(unsigned int now) {
+  rawEdge edge;
+  inputState *input;
+
+  while(_edges.pop(&edge)) {
+    input = &_inputs[edge.input];
+    settle(edge.input, edge.time);
+    input->pending = edge.active;
+    input->pendingSince = edge.time;
+  }
+  // Edges were dropped, catch up with the pin as it is now from the last edge we know of
+  for(int i = 0; i < _inputCount; i++) {
+    if(_overflow[i]) {
+      _overflow[i] = false;
+      input = &_inputs[i];
+      if((int)(_overflowTime[i] - input->pendingSince) > 0) {
+        settle(i, _overflowTime[i]);
+        input->pendingSince = _overflowTime[i];
+      }
+      input->pending = readPin(i);
+    }
+  }
+  for(int i = 0; i < _inputCount; i++) {
+    settle(i, now);
+  }
+}
+
+// Commits a pending level that has held for the debounce window by time now, then runs the gesture timers up to now
+void InputManager::settle(int input, unsigned int now) {
+  inputState *state;
+
+  state = &_inputs[input];
+  if(state->pending != state->stable && (now - state->pendingSince) >= state->debounce) {
+    timers(input, state->pendingSince);
+    commit(input, state->pending, state->pendingSince);
+  }
+  timers(input, now);
+}
+
+void InputManager::timers(int input, unsigned int now) {
+  inputState *state;
+
+  state = &_inputs[input];
+  if(!state->gestures) {
+    return;
+  }
+  if(state->stable && state->longPress > 0 && !state->longFired && (now - state->pressStart) >= state->longPress) {
+    state->longFired = true;
+    state->secondPress = false;
+    emit(input, INPUT_LONGPRESS, state->pressStart + state->longPress);
+  }
+  if(state->clickPending && (now - state->clickTime) > state->doubleClick) {
+    state->clickPending = false;
+    emit(input, INPUT_CLICK, state->clickTime);
+  }
+}
+
+void InputManager::commit(int input, bool active, unsigned int time) {
+  inputState *state;
+
+  state = &_inputs[input];
+  state->stable = active;
+  emit(input, active ? INPUT_ACTIVE : INPUT_INACTIVE, time);
+  if(!state->gestures) {
+    return;
+  }
+  if(active) {
+    // A press inside the double click window pairs with the click before it
+    state->secondPress = state->clickPending;
+    state->clickPending = false;
+    state->pressStart = time;
+    state->longFired = false;
+    return;
+  }
+  if(state->longFired) {
+    return;
+  }
+  if(state->secondPress) {
+    state->secondPress = false;
+    emit(input, INPUT_DOUBLECLICK, time);
+  }
+  else if(state->doubleClick > 0) {
+    state->clickPending = true;
+    state->clickTime = time;
+  }
+  else {
+    emit(input, INPUT_CLICK, time);
+  }
+}
+
+void InputManager::emit(int input, inputEventType type, unsigned int time) {
+  inputEvent *event;
+
+  if(_eventCount == INPUTEVENTSIZE) {
+    _eventsDropped++;
+    return;
+  }
+  event = &_events[(_eventHead + _eventCount) % INPUTEVENTSIZE];
+  event->input = input;
+  event->type = type;
+  event->time = time;
+  _eventCount++;
+}
+
+bool InputManager::getEvent(inputEvent *event) {
+  if(_eventCount == 0) {
+    return false;
+  }
+  *event = _events[_eventHead];
+  _eventHead = (_eventHead + 1) % INPUTEVENTSIZE;
+  _eventCount--;
+  return true;
+}
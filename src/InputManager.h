@@ -0,0 +1,97 @@
+#ifndef _INPUTMANAGER_H_
+#define _INPUTMANAGER_H_
+
+#include "Particle.h"
+#include "SpscQueue.h"
+
+const int MAXINPUTS = 4;
+const int EDGEQUEUESIZE = 64;      // Raw edges waiting for loop(), enough for a long bouncy stall
+const int INPUTEVENTSIZE = 16;
+
+enum inputEventType {
+  INPUT_ACTIVE,          // Debounced level change, e.g. button down or door open
+  INPUT_INACTIVE,
+  INPUT_CLICK,           // Short press, sent once the double press window has passed
+  INPUT_DOUBLECLICK,
+  INPUT_LONGPRESS        // Held for the long press time, no click follows it
+};
+
+struct inputEvent {
+  uint8_t input;
+  inputEventType type;
+  unsigned int time;     // ms, when the edge happened rather than when it was seen
+};
+
+// Interrupt driven inputs. Every edge is stamped in the interrupt handler and queued, loop() then
+// replays the edges in order through a per input debounce window and the press gestures, so a
+// press that comes and goes while loop() is stuck somewhere is still seen, at the right time.
+class InputManager {
+  struct rawEdge {
+    uint8_t input;
+    bool active;
+    unsigned int time;
+  };
+
+  struct inputState {
+    int pin;
+    bool activeLow;
+    bool gestures;
+    unsigned int debounce, longPress, doubleClick;
+    bool stable, pending;
+    unsigned int pendingSince;
+    unsigned int pressStart;
+    bool longFired;            // Also set for a press that started before begin() or resume()
+    bool secondPress;
+    bool clickPending;
+    unsigned int clickTime;
+  };
+
+  inputState _inputs[MAXINPUTS];
+  int _inputCount;
+  SpscQueue<rawEdge, EDGEQUEUESIZE> _edges;
+  volatile bool _overflow[MAXINPUTS];
+  volatile unsigned int _overflowTime[MAXINPUTS];   // Last edge that didn't fit in the queue
+  volatile unsigned int _edgeCount, _overflows;
+  inputEvent _events[INPUTEVENTSIZE];
+  int _eventHead, _eventCount;
+  unsigned int _eventsDropped;
+
+  static InputManager *_active;
+  static void edge0();
+  static void edge1();
+  static void edge2();
+  static void edge3();
+
+  bool readPin(int input);
+  void edge(int input);
+  void sync();
+  void emit(int input, inputEventType type, unsigned int time);
+  void settle(int input, unsigned int now);
+  void timers(int input, unsigned int now);
+  void commit(int input, bool active, unsigned int time);
+
+  public:
+    InputManager();
+
+    // Adds an input before begin(), returns its id or -1 if there is no room. Gestures are only
+    // tracked with a longPress or doubleClick time (ms), a doubleClick of 0 clicks on release.
+    int addInput(int pin, PinMode mode, bool activeLow, unsigned int debounce, unsigned int longPress = 0, unsigned int doubleClick = 0);
+
+    // Attaches the interrupts and takes the current levels as the starting point
+    void begin();
+
+    // Call after waking from sleep, edges during sleep are lost so the levels are read again
+    void resume();
+
+    // Debounces the queued edges up to time now (ms) and turns them into events
+    void update(unsigned int now);
+
+    bool getEvent(inputEvent *event);
+    bool isActive(int input) { return _inputs[input].stable; };
+
+    unsigned int edges() { return _edgeCount; };
+    unsigned int overflows() { return _overflows; };
+    unsigned int eventsDropped() { return _eventsDropped; };
+};
+
+#endif // _INPUTMANAGER_H_
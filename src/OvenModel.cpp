@@ -0,0 +1,61 @@
+#include "OvenModel.h"
+
+OvenModel::OvenModel() {
+  reset();
+}
+
+void OvenModel::reset() {
+  _ovenTemp = OVENAMBIENT;
+  for(int i = 0; i < OVENZONES; i++) {
+    _probeTemp[i] = OVENAMBIENT;
+  }
+  _foodTemp = FOODSTART;
+  _foodIn = false;
+  _started = false;
+}
+
+void OvenModel::loadFood() {
+  _foodTemp = FOODSTART;
+  _foodIn = true;
+}
+
+void OvenModel::update(unsigned int now, bool heaterOn, bool doorOpen) {
+  float dt, step, power, loss, zoneTemp;
+
+  if(!_started) {
+    _lastUpdate = now;
+    _started = true;
+    return;
+  }
+  dt = (now - _lastUpdate) / 1000.0;
+  _lastUpdate = now;
+
+  // Integrate in one second steps so a long gap between samples stays stable
+  while(dt > 0) {
+    step = (dt > 1.0) ? 1.0 : dt;
+    power = heaterOn ? OVENPOWER : 0;
+    loss = (OVENLOSS + (doorOpen ? OVENDOORLOSS : 0)) * (_ovenTemp - OVENAMBIENT);
+    _ovenTemp += (power - loss) * step / OVENCAPACITY;
+    for(int i = 0; i < OVENZONES; i++) {
+      zoneTemp = _ovenTemp + (heaterOn ? OVENHOTSPOT[i] : 0);
+      _probeTemp[i] += (zoneTemp - _probeTemp[i]) * step / PROBELAG;
+    }
+    if(_foodIn) {
+      _foodTemp += (_ovenTemp - _foodTemp) * step / FOODLAG;
+    }
+    dt -= step;
+  }
+}
+
+uint16_t OvenModel::getFrame(int zone) {
+  float temp;
+  uint16_t counts;
+
+  temp = (zone < OVENZONES) ? _probeTemp[zone] : _foodTemp;
+  // 12 bit temperature in 0.25 C steps in bits 3 to 14, open input flag (bit 2) clear
+  counts = (temp > 0) ? (uint16_t)(temp * 4.0) : 0;
+  if(counts > 0x0FFF) {
+    counts = 0x0FFF;
+  }
+  return counts << 3;
+}
@@ -0,0 +1,47 @@
+#ifndef _OVENMODEL_H_
+#define _OVENMODEL_H_
+
+#include "Particle.h"
+
+const float OVENAMBIENT = 22.0;        // Room temperature in C
+const float OVENPOWER = 2500.0;        // Heating element power in W
+const float OVENCAPACITY = 8000.0;     // Heat capacity of the oven cavity and walls in J/C
+const float OVENLOSS = 9.0;            // Heat loss through the walls in W/C
+const float OVENDOORLOSS = 40.0;       // Extra heat loss with the door open in W/C
+const float PROBELAG = 20.0;           // Thermocouple time constant in seconds
+const int OVENZONES = 3;               // Cavity thermocouples, the food probe comes after them
+const float OVENHOTSPOT[OVENZONES] = {0.0, 30.0, -15.0};  // C each zone runs above the cavity while the element is on
+const float FOODSTART = 4.0;           // Food goes in straight from the fridge, C
+const float FOODLAG = 1500.0;          // Time constant of the food core in seconds
+
+// Lumped-parameter thermal model of the oven, one node for the cavity, a node per thermocouple
+// zone that sits above or below it while the element is on, and a slow node for the food core.
+// Produces MAX6675 frames so the real driver and controller can be exercised without an oven attached.
+class OvenModel {
+  float _ovenTemp;
+  float _probeTemp[OVENZONES];
+  float _foodTemp;
+  bool _foodIn;
+  unsigned int _lastUpdate;
+  bool _started;
+
+  public:
+    OvenModel();
+
+    void reset();
+
+    // Puts cold food in the oven, the food probe reads FOODSTART until then
+    void loadFood();
+
+    // Advances the model to time now (ms) with the given relay and door state
+    void update(unsigned int now, bool heaterOn, bool doorOpen);
+
+    float getOvenTemp() { return _ovenTemp; };
+    float getProbeTemp(int zone) { return _probeTemp[zone]; };
+    float getFoodTemp() { return _foodTemp; };
+
+    // The 16 bit frame a MAX6675 would shift out for a zone, zone OVENZONES is the food probe
+    uint16_t getFrame(int zone);
+};
+
+#endif // _OVENMODEL_H_
@@ -0,0 +1,191 @@
+#include "PixelEffects.h"
+
+// Level to PWM with a gamma of 2.6, so equal steps in level look like equal steps in brightness
+static const uint8_t gamma8[256] = {
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,   0,   0,   0,   1,   1,   1,   1,   1,   1,   1,   1,
+    1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,   2,   3,   3,   3,   3,
+    3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   5,   6,   6,   6,   6,   7,
+    7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  10,  11,  11,  11,  12,  12,
+   13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,  20,
+   20,  21,  21,  22,  22,  23,  24,  24,  25,  25,  26,  27,  27,  28,  29,  29,
+   30,  31,  31,  32,  33,  34,  34,  35,  36,  37,  38,  38,  39,  40,  41,  42,
+   42,  43,  44,  45,  46,  47,  48,  49,  50,  51,  52,  53,  54,  55,  56,  57,
+   58,  59,  60,  61,  62,  63,  64,  65,  66,  68,  69,  70,  71,  72,  73,  75,
+   76,  77,  78,  80,  81,  82,  84,  85,  86,  88,  89,  90,  92,  93,  94,  96,
+   97,  99, 100, 102, 103, 105, 106, 108, 109, 111, 112, 114, 115, 117, 119, 120,
+  122, 124, 125, 127, 129, 130, 132, 134, 136, 137, 139, 141, 143, 145, 146, 148,
+  150, 152, 154, 156, 158, 160, 162, 164, 166, 168, 170, 172, 174, 176, 178, 180,
+  182, 184, 186, 188, 191, 193, 195, 197, 199, 202, 204, 206, 209, 211, 213, 215,
+  218, 220, 223, 225, 227, 230, 232, 235, 237, 240, 242, 245, 247, 250, 252, 255
+};
+
+// One breath, a raised cosine that never quite goes out
+static const uint8_t pulseWave[PULSEFRAMES] = {
+   24,  25,  26,  29,  33,  38,  43,  50,  58,  66,  75,  85,  95, 106, 117, 128,
+  140, 151, 162, 173, 184, 194, 204, 213, 221, 229, 236, 241, 246, 250, 253, 254,
+  255, 254, 253, 250, 246, 241, 236, 229, 221, 213, 204, 194, 184, 173, 162, 151,
+  140, 128, 117, 106,  95,  85,  75,  66,  58,  50,  43,  38,  33,  29,  26,  25
+};
+
+// Levels from the head of the chase backwards
+static const uint8_t chaseTail[CHASETAIL] = {255, 140, 70, 30};
+
+// Gradient stops from cold to hot
+static const uint32_t gradientStops[] = {0x0000FF, 0x00FFFF, 0x00FF00, 0xFFFF00, 0xFF0000};
+static const int GRADIENTSTOPS = sizeof(gradientStops) / sizeof(gradientStops[0]);
+
+PixelEffects::PixelEffects(Adafruit_NeoPixel *strip) {
+  _strip = strip;
+  _effect = EFFECT_OFF;
+  _color = 0;
+  _count = 0;
+  _frame = 0;
+  _progress = 0;
+  _head = -1;
+  _dirty = true;
+  _renderTime = 0;
+  _maxRenderTime = 0;
+}
+
+uint32_t PixelEffects::scale(uint32_t color, uint8_t level) {
+  uint16_t pwm;
+
+  pwm = gamma8[level] + 1;
+  return ((((color >> 16) & 0xFF) * pwm >> 8) << 16) | ((((color >> 8) & 0xFF) * pwm >> 8) << 8) | ((color & 0xFF) * pwm >> 8);
+}
+
+void PixelEffects::start(pixelEffect effect, uint32_t color) {
+  if(effect == _effect && color == _color) {
+    return;
+  }
+  _effect = effect;
+  _color = color;
+  _frame = 0;
+  _head = -1;
+  _dirty = true;
+}
+
+void PixelEffects::solid(uint32_t color) {
+  start(EFFECT_SOLID, color);
+}
+
+void PixelEffects::pulse(uint32_t color) {
+  start(EFFECT_PULSE, color);
+}
+
+void PixelEffects::chase(uint32_t color) {
+  start(EFFECT_CHASE, color);
+}
+
+void PixelEffects::progress(uint32_t color) {
+  start(EFFECT_PROGRESS, color);
+}
+
+void PixelEffects::gradient() {
+  start(EFFECT_GRADIENT, _effect == EFFECT_GRADIENT ? _color : gradientStops[0]);
+}
+
+void PixelEffects::setProgress(uint32_t done, uint32_t total) {
+  uint16_t progress;
+
+  progress = (total == 0 || done >= total) ? PROGRESSFULL : (uint64_t)done * PROGRESSFULL / total;
+  if(progress != _progress) {
+    _progress = progress;
+    _dirty = true;
+  }
+}
+
+void PixelEffects::setTemperature(int temp, int low, int high) {
+  uint32_t from, to, color;
+  int position, stop, frac;
+
+  // Position along the stops in 1/256ths
+  temp = constrain(temp, low, high);
+  position = (high > low) ? (temp - low) * ((GRADIENTSTOPS - 1) * 256) / (high - low) : 0;
+  stop = min(position >> 8, GRADIENTSTOPS - 2);
+  frac = position - (stop << 8);
+  from = gradientStops[stop];
+  to = gradientStops[stop + 1];
+  color = 0;
+  for(int shift = 0; shift <= 16; shift += 8) {
+    color |= ((((from >> shift) & 0xFF) * (256 - frac) + ((to >> shift) & 0xFF) * frac) >> 8) << shift;
+  }
+  if(color != _color) {
+    _color = color;
+    _dirty = true;
+  }
+}
+
+void PixelEffects::off() {
+  start(EFFECT_OFF, 0);
+  _strip->clear();
+  _strip->show();
+  _dirty = false;
+}
+
+void PixelEffects::fill(uint32_t color) {
+  for(int i = 0; i < _count; i++) {
+    _strip->setPixelColor(i, color);
+  }
+}
+
+void PixelEffects::render() {
+  unsigned int start;
+  uint32_t lit;
+  int head, pixel, whole;
+
+  start = micros();
+  _count = _strip->numPixels();
+  if(_count == 0) {
+    return;
+  }
+  switch(_effect) {
+    case EFFECT_OFF:
+    case EFFECT_SOLID:
+    case EFFECT_GRADIENT:
+      if(!_dirty) {
+        return;
+      }
+      fill(_color);
+      break;
+    case EFFECT_PULSE:
+      fill(scale(_color, pulseWave[_frame % PULSEFRAMES]));
+      break;
+    case EFFECT_CHASE:
+      head = (_frame / CHASEFRAMES) % _count;
+      if(head == _head && !_dirty) {
+        break;
+      }
+      _strip->clear();
+      for(int i = 0; i < CHASETAIL && i < _count; i++) {
+        pixel = (head + _count - i) % _count;
+        _strip->setPixelColor(pixel, scale(_color, chaseTail[i]));
+      }
+      _head = head;
+      break;
+    case EFFECT_PROGRESS:
+      if(!_dirty) {
+        return;
+      }
+      // Whole pixels lit, then the next one at the left over fraction
+      lit = (uint32_t)_progress * _count;
+      whole = lit / PROGRESSFULL;
+      _strip->clear();
+      for(int i = 0; i < whole; i++) {
+        _strip->setPixelColor(i, _color);
+      }
+      if(whole < _count) {
+        _strip->setPixelColor(whole, scale(_color, (lit % PROGRESSFULL) >> 8));
+      }
+      break;
+  }
+  _dirty = false;
+  _frame++;
+  _strip->show();
+
+  _renderTime = micros() - start;
+  if(_renderTime > _maxRenderTime) {
+    _maxRenderTime = _renderTime;
+  }
+}
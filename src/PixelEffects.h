@@ -0,0 +1,69 @@
+#ifndef _PIXELEFFECTS_H_
+#define _PIXELEFFECTS_H_
+
+#include "Particle.h"
+#include "neopixel.h"
+
+const int PIXELFRAMEPERIOD = 40;   // ms per frame, 25 Hz
+const int PULSEFRAMES = 64;        // Frames per breath, the length of the pulse table
+const int CHASEFRAMES = 2;         // Frames per step of the chase
+const int CHASETAIL = 4;           // Lit pixels behind the head, fading out
+const uint16_t PROGRESSFULL = 0xFFFF;
+
+enum pixelEffect {
+  EFFECT_OFF,
+  EFFECT_SOLID,
+  EFFECT_PULSE,          // The whole ring breathes
+  EFFECT_CHASE,          // A head with a fading tail runs round the ring
+  EFFECT_PROGRESS,       // An arc grows round the ring as a job completes, the leading pixel partly lit
+  EFFECT_GRADIENT        // The whole ring goes from blue to red as a temperature climbs
+};
+
+// Status ring animations, rendered one frame at a time from the scheduler. Colors are packed 0xRRGGBB.
+// Inputs are converted to fixed point when they are set, so rendering a frame is table lookups and
+// integer multiplies. Effects that don't move only redraw when their input changes, and the strip
+// doesn't send a frame that is the same as the last one.
+class PixelEffects {
+  Adafruit_NeoPixel *_strip;
+  pixelEffect _effect;
+  uint32_t _color;
+  uint16_t _count;
+  uint16_t _frame;
+  uint16_t _progress;            // 0 to PROGRESSFULL
+  int _head;                     // Chase position drawn last, -1 to force a redraw
+  bool _dirty;
+  unsigned int _renderTime, _maxRenderTime;   // us
+
+  void start(pixelEffect effect, uint32_t color);
+  void fill(uint32_t color);
+
+  public:
+    PixelEffects(Adafruit_NeoPixel *strip);
+
+    void solid(uint32_t color);
+    void pulse(uint32_t color);
+    void chase(uint32_t color);
+    void progress(uint32_t color);
+    void gradient();
+
+    // Fraction of the progress arc that is lit, done out of total in any units
+    void setProgress(uint32_t done, uint32_t total);
+
+    // Temperature for the gradient, from cold at low to hot at high
+    void setTemperature(int temp, int low, int high);
+
+    // Clears the ring and sends it right away, for when the scheduler is about to stop
+    void off();
+
+    // Draws the next frame and shows it, call every PIXELFRAMEPERIOD ms
+    void render();
+
+    pixelEffect getEffect() { return _effect; };
+    unsigned int getRenderTime() { return _renderTime; };
+    unsigned int getMaxRenderTime() { return _maxRenderTime; };
+
+    // Color scaled by a 0 to 255 level with gamma correction, so fades look even
+    static uint32_t scale(uint32_t color, uint8_t level);
+};
+
+#endif // _PIXELEFFECTS_H_
@@ -0,0 +1,68 @@
+#include "PromptQueue.h"
+
+PromptQueue::PromptQueue(DFRobotDFPlayerMini *player) {
+  _player = player;
+  _dropped = 0;
+  clear();
+}
+
+bool PromptQueue::isQueued(int trackNumber) {
+  for(int i = 0; i < _count; i++) {
+    if(_tracks[(_head + i) % PROMPTQUEUESIZE] == trackNumber) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool PromptQueue::enqueue(int trackNumber, unsigned int holdoff) {
+  unsigned int now;
+  bool tracked;
+
+  // A prompt that is already playing or waiting to play is dropped, it would only say the same thing twice
+  if(trackNumber == _playing || isQueued(trackNumber)) {
+    return false;
+  }
+  now = millis();
+  tracked = trackNumber > 0 && trackNumber < PROMPTTRACKS;
+  if(tracked && holdoff > 0 && _queuedAt[trackNumber] != 0 && (now - _queuedAt[trackNumber]) < holdoff) {
+    return false;
+  }
+  if(_count == PROMPTQUEUESIZE) {
+    _dropped++;
+    return false;
+  }
+  _tracks[_tail] = trackNumber;
+  _tail = (_tail + 1) % PROMPTQUEUESIZE;
+  _count++;
+  if(tracked) {
+    _queuedAt[trackNumber] = (now != 0) ? now : 1;    // 0 means never queued
+  }
+  return true;
+}
+
+void PromptQueue::update() {
+  // The player sends the finished message twice and may still be finishing the previous clip, only the
+  // one for the clip that is playing ends it
+  if(_player->available() && _player->readType() == DFPlayerPlayFinished && _player->read() == _playing) {
+    _playing = 0;
+  }
+  if(_playing != 0 && (millis() - _playStart) >= PROMPTTIMEOUT) {
+    _playing = 0;
+  }
+  if(_playing == 0 && _count > 0) {
+    _playing = _tracks[_head];
+    _head = (_head + 1) % PROMPTQUEUESIZE;
+    _count--;
+    _playStart = millis();
+    _player->play(_playing);
+  }
+}
+
+void PromptQueue::clear() {
+  _head = 0;
+  _tail = 0;
+  _count = 0;
+  _playing = 0;
+  memset(_queuedAt, 0, sizeof(_queuedAt));
+}
@@ -0,0 +1,40 @@
+#ifndef _PROMPTQUEUE_H_
+#define _PROMPTQUEUE_H_
+
+#include "Particle.h"
+#include "DFRobotDFPlayerMini.h"
+
+const int PROMPTQUEUESIZE = 8;
+const int PROMPTTRACKS = 16;             // Tracks 1 to 15 are remembered for the repeat holdoff
+const unsigned int PROMPTTIMEOUT = 6000; // Give up on a finished event after 6 seconds (longest clip)
+
+// Queues voice prompts for the DFPlayer so loop() never has to wait for a clip to finish.
+// The next track is started when the player reports DFPlayerPlayFinished (or the timeout passes).
+class PromptQueue {
+  DFRobotDFPlayerMini *_player;
+  int _tracks[PROMPTQUEUESIZE];
+  int _head, _tail, _count;
+  int _playing;                // Track currently playing, 0 when idle
+  unsigned int _playStart;
+  unsigned int _queuedAt[PROMPTTRACKS];   // millis() each track was last accepted, for the holdoff
+  unsigned int _dropped;
+
+  bool isQueued(int trackNumber);
+
+  public:
+    PromptQueue(DFRobotDFPlayerMini *player);
+
+    // Adds a track to the queue, returns false if it is already playing or queued, the queue is full,
+    // or it was accepted less than holdoff ms ago (for prompts requested every pass of loop())
+    bool enqueue(int trackNumber, unsigned int holdoff = 0);
+
+    // Call every pass of loop(), starts the next track once the current one is done
+    void update();
+
+    void clear();
+    bool isPlaying() { return _playing != 0; };
+    int pending() { return _count; };
+    unsigned int dropped() { return _dropped; };
+};
+
+#endif // _PROMPTQUEUE_H_
@@ -0,0 +1,89 @@
+#include "PublishQueue.h"
+
+PublishQueue::PublishQueue() {
+  _highWater = 0;
+  _coalesced = 0;
+  _dropped = 0;
+  _sent = 0;
+  clear();
+}
+
+void PublishQueue::enqueue(Adafruit_MQTT_Publish *feed, float value, uint8_t precision) {
+  publishRecord *record;
+
+  if(_count == PUBLISHQUEUESIZE) {
+    coalesce();
+  }
+  if(_count == PUBLISHQUEUESIZE) {
+    // Every record is the latest for its feed, lose the oldest
+    _head = (_head + 1) % PUBLISHQUEUESIZE;
+    _count--;
+    _dropped++;
+  }
+  record = &_records[(_head + _count) % PUBLISHQUEUESIZE];
+  record->feed = feed;
+  record->queuedAt = millis();
+  record->value = value;
+  record->precision = precision;
+  _count++;
+  if((unsigned int)_count > _highWater) {
+    _highWater = _count;
+  }
+}
+
+// Removes every record that has a newer one for the same feed, keeping the rest in order
+void PublishQueue::coalesce() {
+  int i, j, kept;
+  bool superseded;
+
+  kept = 0;
+  for(i = 0; i < _count; i++) {
+    publishRecord *record = &_records[(_head + i) % PUBLISHQUEUESIZE];
+    superseded = false;
+    for(j = i + 1; j < _count && !superseded; j++) {
+      superseded = (_records[(_head + j) % PUBLISHQUEUESIZE].feed == record->feed);
+    }
+    if(superseded) {
+      _coalesced++;
+      continue;
+    }
+    _records[(_head + kept) % PUBLISHQUEUESIZE] = *record;
+    kept++;
+  }
+  _count = kept;
+}
+
+int PublishQueue::drain(int maxRecords) {
+  publishRecord *record;
+  char payload[64];
+  bool ok;
+  int published;
+  unsigned int age;
+
+  for(published = 0; published < maxRecords && _count > 0; published++) {
+    record = &_records[_head];
+    age = (millis() - record->queuedAt) / 1000;
+    if(age > PUBLISHLATE && Time.isValid()) {
+      // Late, let Adafruit IO file it under the time it happened rather than when it arrived. Counted back
+      // from now, a record queued before the clock was synced would otherwise say 1970.
+      snprintf(payload, sizeof(payload), "{\"value\":%.*f,\"created_at\":\"%s\"}", record->precision, record->value,
+               Time.format(Time.now() - age, TIME_FORMAT_ISO8601_FULL).c_str());
+      ok = record->feed->publish(payload);
+    }
+    else {
+      ok = record->feed->publish((double)record->value, record->precision);
+    }
+    if(!ok) {
+      break;
+    }
+    _head = (_head + 1) % PUBLISHQUEUESIZE;
+    _count--;
+    _sent++;
+  }
+  return published;
+}
+
+void PublishQueue::clear() {
+  _head = 0;
+  _count = 0;
+}
@@ -0,0 +1,48 @@
+#ifndef _PUBLISHQUEUE_H_
+#define _PUBLISHQUEUE_H_
+
+#include "Particle.h"
+#include "Adafruit_MQTT.h"
+
+const int PUBLISHQUEUESIZE = 16;
+const unsigned int PUBLISHLATE = 10;    // Records older than this many seconds carry their own timestamp
+
+struct publishRecord {
+  Adafruit_MQTT_Publish *feed;
+  uint32_t queuedAt;           // millis(), Time may not be synced yet when a record is queued
+  float value;
+  uint8_t precision;
+};
+
+// Holds status and telemetry records while the broker is unreachable and forwards them in order once it is back.
+// When the ring is full older records for a feed are coalesced so only the latest value per feed survives.
+class PublishQueue {
+  publishRecord _records[PUBLISHQUEUESIZE];
+  int _head, _count;
+  unsigned int _highWater;
+  unsigned int _coalesced;     // Superseded records removed to make room
+  unsigned int _dropped;       // Records lost because every slot held a different feed's latest value
+  unsigned int _sent;
+
+  void coalesce();
+
+  public:
+    PublishQueue();
+
+    // Queues a value for the feed, stamped with millis()
+    void enqueue(Adafruit_MQTT_Publish *feed, float value, uint8_t precision = 0);
+
+    // Publishes up to maxRecords oldest first, stops at the first failure so nothing is reordered. A late
+    // record carries the time it was queued, worked out from its age, once Time is valid. Returns the
+    // number published.
+    int drain(int maxRecords);
+
+    void clear();
+    int pending() { return _count; };
+    unsigned int highWater() { return _highWater; };
+    unsigned int coalesced() { return _coalesced; };
+    unsigned int dropped() { return _dropped; };
+    unsigned int sent() { return _sent; };
+};
+
+#endif // _PUBLISHQUEUE_H_
@@ -0,0 +1,176 @@
+#include "RecipeRecord.h"
+
+const int BLOCKSIZE = 16;
+
+// Reads an unsigned ASCII number from the start of a block, false if there are no digits
+static bool parseNumber(const uint8_t *block, int *value) {
+  int i, number;
+
+  number = 0;
+  for(i = 0; i < BLOCKSIZE && block[i] >= '0' && block[i] <= '9'; i++) {
+    number = number * 10 + (block[i] - '0');
+  }
+  if(i == 0) {
+    return false;
+  }
+  *value = number;
+  return true;
+}
+
+// Copies a NUL terminated printable name, false if it is empty, unterminated or has control characters
+static bool copyName(char *dest, const char *src, int length) {
+  int i;
+
+  for(i = 0; i < length && src[i] != 0; i++) {
+    if(src[i] < ' ' || src[i] > '~') {
+      return false;
+    }
+  }
+  if(i == 0 || i >= RECIPENAMESIZE) {
+    return false;
+  }
+  memcpy(dest, src, i);
+  dest[i] = 0;
+  return true;
+}
+
+static bool validStage(int cookTemp, int cookMinutes, recipeError *error) {
+  if(cookTemp < MINCOOKTEMP || cookTemp > MAXCOOKTEMP) {
+    *error = RECIPE_BADTEMP;
+    return false;
+  }
+  if(cookMinutes <= 0 || cookMinutes > MAXCOOKMINUTES) {
+    *error = RECIPE_BADTIME;
+    return false;
+  }
+  return true;
+}
+
+recipeError decodeRecipe(const uint8_t *data, cookingInstructions *ci) {
+  recipeRecord record;
+  cookingInstructions decoded;
+  recipeError error;
+
+  memcpy(&record, data, RECIPERECORDSIZE);
+  memset(&decoded, 0, sizeof(decoded));
+  if(record.magic != RECIPEMAGIC) {
+    return RECIPE_BADMAGIC;
+  }
+  if(record.version != RECIPEVERSION) {
+    return RECIPE_BADVERSION;
+  }
+  if(record.crc != recipeCRC(data, RECIPERECORDSIZE - sizeof(record.crc))) {
+    return RECIPE_BADCRC;
+  }
+  if(record.stageCount == 0 || record.stageCount > MAXSTAGES) {
+    return RECIPE_BADSTAGECOUNT;
+  }
+  for(int i = 0; i < record.stageCount; i++) {
+    if(!validStage(record.stages[i].cookTemp, record.stages[i].cookMinutes, &error)) {
+      return error;
+    }
+    decoded.stages[i].cookTemp = record.stages[i].cookTemp;
+    decoded.stages[i].cookMinutes = record.stages[i].cookMinutes;
+  }
+  if(record.coreTemp != 0 && (record.coreTemp * 2 < MINCORETEMP || record.coreTemp * 2 > MAXCORETEMP)) {
+    return RECIPE_BADCORETEMP;
+  }
+  if(!copyName(decoded.recipeName, record.recipeName, RECIPENAMESIZE)) {
+    return RECIPE_BADNAME;
+  }
+  decoded.coreTemp = record.coreTemp * 2;
+  decoded.stageCount = record.stageCount;
+  decoded.calOffset = record.calOffset;
+  loadStage(&decoded, 0);
+  *ci = decoded;
+  return RECIPE_OK;
+}
+
+recipeError decodeLegacyRecipe(const uint8_t *nameBlock, const uint8_t *tempBlock, const uint8_t *timeBlock, cookingInstructions *ci) {
+  cookingInstructions decoded;
+  recipeError error;
+  int cookTemp, cookMinutes;
+
+  memset(&decoded, 0, sizeof(decoded));
+  if(!copyName(decoded.recipeName, (const char *)nameBlock, BLOCKSIZE)) {
+    return RECIPE_BADNAME;
+  }
+  if(!parseNumber(tempBlock, &cookTemp)) {
+    return RECIPE_BADTEMP;
+  }
+  if(!parseNumber(timeBlock, &cookMinutes)) {
+    return RECIPE_BADTIME;
+  }
+  if(!validStage(cookTemp, cookMinutes, &error)) {
+    return error;
+  }
+  decoded.stages[0].cookTemp = cookTemp;
+  decoded.stages[0].cookMinutes = cookMinutes;
+  decoded.stageCount = 1;
+  decoded.coreTemp = 0;
+  decoded.calOffset = LEGACYCALOFFSET;
+  loadStage(&decoded, 0);
+  *ci = decoded;
+  return RECIPE_OK;
+}
+
+void encodeRecipe(const cookingInstructions *ci, uint8_t *data) {
+  recipeRecord record;
+
+  memset(&record, 0, sizeof(record));
+  record.magic = RECIPEMAGIC;
+  record.version = RECIPEVERSION;
+  record.stageCount = ci->stageCount;
+  record.calOffset = ci->calOffset;
+  record.coreTemp = ci->coreTemp / 2;
+  for(int i = 0; i < ci->stageCount && i < MAXSTAGES; i++) {
+    record.stages[i].cookTemp = ci->stages[i].cookTemp;
+    record.stages[i].cookMinutes = ci->stages[i].cookMinutes;
+  }
+  strncpy(record.recipeName, ci->recipeName, RECIPENAMESIZE - 1);
+  memcpy(data, &record, RECIPERECORDSIZE);
+  record.crc = recipeCRC(data, RECIPERECORDSIZE - sizeof(record.crc));
+  memcpy(data, &record, RECIPERECORDSIZE);
+}
+
+void loadStage(cookingInstructions *ci, int stage) {
+  ci->stage = stage;
+  ci->cookTemp = ci->stages[stage].cookTemp + ci->calOffset;
+  ci->cookTime = ci->stages[stage].cookMinutes * 60000; // Need to convert to ms
+}
+
+const char *recipeErrorString(recipeError error) {
+  switch(error) {
+    case RECIPE_OK:
+      return "ok";
+    case RECIPE_BADMAGIC:
+      return "not a recipe card";
+    case RECIPE_BADVERSION:
+      return "unsupported record version";
+    case RECIPE_BADCRC:
+      return "checksum mismatch";
+    case RECIPE_BADSTAGECOUNT:
+      return "bad stage count";
+    case RECIPE_BADTEMP:
+      return "bad cook temperature";
+    case RECIPE_BADTIME:
+      return "bad cook time";
+    case RECIPE_BADNAME:
+      return "bad recipe name";
+    case RECIPE_BADCORETEMP:
+      return "bad food core temperature";
+  }
+  return "unknown error";
+}
+
+uint16_t recipeCRC(const uint8_t *data, int length) {
+  uint16_t crc = 0xFFFF;
+
+  for(int i = 0; i < length; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for(int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+  }
+  return crc;
+}
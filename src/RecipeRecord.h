@@ -0,0 +1,78 @@
+#ifndef _RECIPERECORD_H_
+#define _RECIPERECORD_H_
+
+#include "Particle.h"
+
+const int RECIPENAMESIZE = 28;          // Including the terminating NUL
+const int MAXSTAGES = 3;
+const int RECIPERECORDSIZE = 48;        // Three 16 byte MIFARE blocks
+const uint8_t RECIPEMAGIC = 0xC5;       // Not printable, so it can't be mistaken for an old ASCII card
+const uint8_t RECIPEVERSION = 1;
+const int LEGACYCALOFFSET = -150;       // Old cards subtract 150 F to compensate for a faulty thermocouple
+const int MINCOOKTEMP = 100;
+const int MAXCOOKTEMP = 550;
+const int MAXCOOKMINUTES = 600;
+const int MINCORETEMP = 100;            // Food core targets, F
+const int MAXCORETEMP = 210;
+
+struct cookingStage {
+  int cookTemp;       // F, before the calibration offset
+  int cookMinutes;
+};
+
+struct cookingInstructions {
+  char recipeName[RECIPENAMESIZE];
+  int cookTemp;       // Current stage, F with the calibration offset applied
+  int cookTime;       // Current stage, ms
+  int calOffset;
+  int stageCount;
+  int stage;
+  cookingStage stages[MAXSTAGES];
+  int coreTemp;       // F the food probe must reach to finish early, 0 to cook for the full time
+};
+
+// Binary recipe card layout, stored little endian in blocks 4 to 6 of a MIFARE Classic card
+struct __attribute__((packed)) recipeRecord {
+  uint8_t magic;
+  uint8_t version;
+  uint8_t stageCount;
+  uint8_t coreTemp;   // Food core target in 2 F steps, 0 for none (older cards leave it 0)
+  int16_t calOffset;
+  struct __attribute__((packed)) {
+    uint16_t cookTemp;
+    uint16_t cookMinutes;
+  } stages[MAXSTAGES];
+  char recipeName[RECIPENAMESIZE];
+  uint16_t crc;       // CRC-16/CCITT over all the bytes before it
+};
+
+static_assert(sizeof(recipeRecord) == RECIPERECORDSIZE, "recipeRecord must fill exactly three MIFARE blocks");
+
+enum recipeError {
+  RECIPE_OK = 0,
+  RECIPE_BADMAGIC,
+  RECIPE_BADVERSION,
+  RECIPE_BADCRC,
+  RECIPE_BADSTAGECOUNT,
+  RECIPE_BADTEMP,
+  RECIPE_BADTIME,
+  RECIPE_BADNAME,
+  RECIPE_BADCORETEMP
+};
+
+// Decodes a binary recipe card without allocating, ci is left untouched on failure
+recipeError decodeRecipe(const uint8_t *data, cookingInstructions *ci);
+
+// Decodes an old card with the name, temperature and minutes as ASCII in separate 16 byte blocks
+recipeError decodeLegacyRecipe(const uint8_t *nameBlock, const uint8_t *tempBlock, const uint8_t *timeBlock, cookingInstructions *ci);
+
+// Fills data with RECIPERECORDSIZE bytes ready to be written to a card
+void encodeRecipe(const cookingInstructions *ci, uint8_t *data);
+
+// Makes the given stage current, applying the calibration offset and converting to ms
+void loadStage(cookingInstructions *ci, int stage);
+
+const char *recipeErrorString(recipeError error);
+uint16_t recipeCRC(const uint8_t *data, int length);
+
+#endif // _RECIPERECORD_H_
@@ -0,0 +1,86 @@
+#include "Scheduler.h"
+
+Scheduler::Scheduler(schedulerClock msClock, schedulerClock usClock) {
+  _taskCount = 0;
+  _msClock = msClock;
+  _usClock = usClock;
+}
+
+int Scheduler::addTask(const char *name, taskFunction function, unsigned int period) {
+  schedulerTask *task;
+
+  if(_taskCount == MAXTASKS) {
+    return -1;
+  }
+  task = &_tasks[_taskCount];
+  task->name = name;
+  task->function = function;
+  task->period = period;
+  task->deadline = _msClock();
+  task->lastStart = task->deadline;
+  task->lastInterval = 0;
+  _taskCount++;
+  resetStats();
+  return _taskCount - 1;
+}
+
+bool Scheduler::run() {
+  schedulerTask *task;
+  unsigned int now, late, start;
+
+  now = _msClock();
+  for(int i = 0; i < _taskCount; i++) {
+    task = &_tasks[i];
+    late = now - task->deadline;
+    if((int)late < 0) {
+      continue;
+    }
+
+    // The first run counts from when the task was added
+    task->lastInterval = now - task->lastStart;
+    task->lastStart = now;
+
+    start = _usClock();
+    task->function();
+    task->runTime = _usClock() - start;
+    task->runs++;
+
+    if(task->runTime > task->maxRunTime) {
+      task->maxRunTime = task->runTime;
+    }
+    if(late > task->maxJitter) {
+      task->maxJitter = late;
+    }
+
+    // Keep a fixed cadence, but if a whole period was missed start again from now instead of bursting
+    if(late >= task->period || task->runTime >= task->period * 1000) {
+      task->overruns++;
+      task->deadline = now + task->period;
+    }
+    else {
+      task->deadline += task->period;
+    }
+    return true;
+  }
+  return false;
+}
+
+void Scheduler::resetStats() {
+  for(int i = 0; i < _taskCount; i++) {
+    _tasks[i].runTime = 0;
+    _tasks[i].maxRunTime = 0;
+    _tasks[i].maxJitter = 0;
+    _tasks[i].runs = 0;
+    _tasks[i].overruns = 0;
+  }
+}
+
+void Scheduler::printStats() {
+  schedulerTask *task;
+
+  for(int i = 0; i < _taskCount; i++) {
+    task = &_tasks[i];
+    Serial.printf("Task %s: period %ums, runs %u, max run %uus, max jitter %ums, overruns %u\n",
+                  task->name, task->period, task->runs, task->maxRunTime, task->maxJitter, task->overruns);
+  }
+}
@@ -0,0 +1,49 @@
+#ifndef _SCHEDULER_H_
+#define _SCHEDULER_H_
+
+#include "Particle.h"
+
+const int MAXTASKS = 8;
+
+typedef void (*taskFunction)();
+typedef system_tick_t (*schedulerClock)();
+
+struct schedulerTask {
+  const char *name;
+  taskFunction function;
+  unsigned int period;        // ms between runs
+  unsigned int deadline;      // millis() value the task is due at
+  unsigned int runTime;       // us taken by the last run
+  unsigned int maxRunTime;    // us, worst case
+  unsigned int maxJitter;     // ms the task started after its deadline, worst case
+  unsigned int lastStart;     // millis() value the last run started at
+  unsigned int lastInterval;  // ms between the starts of the last two runs
+  unsigned int runs;
+  unsigned int overruns;      // runs that took longer than the period or missed a whole period
+};
+
+// Cooperative fixed-period scheduler. Tasks are added in priority order and each call to run()
+// executes only the highest priority task that is due, so a slow low priority task can delay a
+// higher priority one by at most one run of itself. Deadlines and run times come from the two
+// clocks it is given, millis() and micros() on the device, a virtual clock under test.
+class Scheduler {
+  schedulerTask _tasks[MAXTASKS];
+  int _taskCount;
+  schedulerClock _msClock;
+  schedulerClock _usClock;
+
+  public:
+    Scheduler(schedulerClock msClock = millis, schedulerClock usClock = micros);
+
+    // Returns the task id, or -1 if the table is full
+    int addTask(const char *name, taskFunction function, unsigned int period);
+
+    // Runs the highest priority task that is due, returns false if nothing was due
+    bool run();
+
+    const schedulerTask *getTask(int id) { return (id >= 0 && id < _taskCount) ? &_tasks[id] : NULL; };
+    void resetStats();
+    void printStats();
+};
+
+#endif // _SCHEDULER_H_
@@ -11,6 +11,19 @@
 SYSTEM_THREAD(ENABLED);
 SYSTEM_MODE(AUTOMATIC);
 
+// Wire only buffers 32 bytes by default, make it big enough for a whole OLED page per transaction
+hal_i2c_config_t acquireWireBuffer() {
+  hal_i2c_config_t config = {
+    .size = sizeof(hal_i2c_config_t),
+    .version = HAL_I2C_CONFIG_VERSION_1,
+    .rx_buffer = new (std::nothrow) uint8_t[WIREBUFFERSIZE],
+    .rx_buffer_size = WIREBUFFERSIZE,
+    .tx_buffer = new (std::nothrow) uint8_t[WIREBUFFERSIZE],
+    .tx_buffer_size = WIREBUFFERSIZE
+  };
+  return config;
+}
+
 void setup () {
   // sync time
   Time.zone(TIMEZONE);
@@ -29,15 +42,29 @@ void setup () {
   Serial1.begin(9600);
   waitFor(Serial.isConnected,10000);
 
-  //Initialize thermocouple
-  thermocouple.begin(SCK, SS, MISO);
+  //Initialize thermocouples on hardware SPI, with a calibration table for each one that has been stored
+  thermocouples.begin(THERMOCOUPLESELECTS, THERMOCOUPLECOUNT);
+  for(int i = 0; i < THERMOCOUPLECOUNT; i++){
+    thermocouples.setWeight(i, ZONEWEIGHTS[i]);
+    if(thermocouples.zone(i).loadCalibration(CALIBRATIONADDR + i * sizeof(MAX6675Calibration))){
+      Serial.printf("Thermocouple %i calibration: %i points\n", i, thermocouples.zone(i).getCalibrationPoints());
+    }
+  }
+  Particle.function("calibrate", calibrateCommand);
+#ifdef SIMULATEOVEN
+  thermocouples.setFrameSource(simulatedFrame);
+#endif
 
   //Initiliaze oven relay
-  pinMode(OVENRELAY, OUTPUT);
-  digitalWrite(OVENRELAY, LOW); // Make sure Oven is off
+  heater.begin(); // Make sure Oven is off
+
+  //Initialize the on/off button and the hall sensor on the door, both interrupt driven
+  onOffInput = inputs.addInput(ONOFFBUTTON, INPUT_PULLDOWN, false, BUTTONDEBOUNCE, LONGPRESSTIME, DOUBLEPRESSTIME);
+  doorInput = inputs.addInput(HALLPIN, INPUT, true, DOORDEBOUNCE);
+  inputs.begin();
 
-  //Initialize hall sensor
-  pinMode(HALLPIN, INPUT);
+  // Reminder and cooling timers, 64 bit so they never wrap
+  timers.begin(System.millis());
 
   //Initialize mp3 player
   Serial.println(F("Initializing DFPlayer ... (May take 3~5 seconds)"));
@@ -70,248 +97,365 @@ void setup () {
 
   // Initialize Display
   display.begin(SSD1306_SWITCHCAPVCC, 0x3C);
+  display.setBurstSize(OLEDBURST, WIREBUFFERSIZE);
   //display.setRotation(2); ??? MAY HAVE TO ROTATE
   display.setRotation(0);
   display.clearDisplay();
   display.display();
 
   // Setup MQTT subscription
+  smartCookerRemote.setCallback(remoteCommand);
   mqtt.subscribe(&smartCookerRemote);
+  mqtt.setPublishWindow(PUBLISHWINDOW);
 
-  // Get data from Adafruit
-   // new Thread("adafruitData", getAdafruitSubscription);
+  // Tasks are added in priority order, heater control must never wait on the network or I2C
+  scheduler.addTask("sensor", sensorTask, SENSORPERIOD);
+  controlTaskId = scheduler.addTask("control", controlTask, CONTROLPERIOD);
+  scheduler.addTask("network", networkTask, NETWORKPERIOD);
+  scheduler.addTask("nfc", nfcTask, NFCPERIOD);
+  scheduler.addTask("ui", uiTask, UIPERIOD);
+  scheduler.addTask("pixels", pixelTask, PIXELPERIOD);
+  scheduler.addTask("telemetry", telemetryTask, TELEMETRYPERIOD);
 
 }
 
 void loop () {
+  inputEvent event;
 
-  if(onOffButton.isClicked()){
-    Serial.printf("On/off button pressed: %i!!\n\n", buttonFlag);
-    if(buttonFlag == LOW){
-      buttonFlag = HIGH;
-      status = READY;
-     }else{
-      buttonFlag = LOW;
-      status = SHUTDOWN;
-    }
+  // Start the next voice prompt if the last one has finished
+  prompts.update();
+
+  // Button presses and door movements, queued by their interrupts even while loop() was busy
+  inputs.update(millis());
+  while(inputs.getEvent(&event)){
+    inputCommand(event);
   }
 
-  MQTT_connect();
-  MQTT_ping();
+  // Runs out any timers that are due and calls their functions
+  timers.update(System.millis());
 
-  getAdafruitSubscription(&status, &ci, &notificationFlag);
+  // The OLED frame goes out a page per pass, so a redraw never holds the control task up for a whole frame
+  if(display.isFlushing() && display.flush()){
+    Serial.printf("OLED frame: %u bytes in %lu us\n", display.getFrameBytes(), display.getFrameTime());
+  }
+
+  scheduler.run();
+}
 
+// Handles a debounced event from the on/off button or the door
+void inputCommand(inputEvent event){
+  if(event.input == doorInput){
+    if(event.type == INPUT_ACTIVE){
+      doorOpened = true;
+      doorOpenings++;
+    }
+    Serial.printf("Door %s at %u ms\n", event.type == INPUT_ACTIVE ? "opened" : "closed", event.time);
+    return;
+  }
+  switch(event.type){
+    case INPUT_CLICK:
+      Serial.printf("On/off button pressed: %i!!\n\n", buttonFlag);
+      if(buttonFlag == LOW){
+        buttonFlag = HIGH;
+        status = READY;
+      }else{
+        buttonFlag = LOW;
+        status = SHUTDOWN;
+      }
+      break;
+    case INPUT_LONGPRESS:
+      Serial.printf("On/off button held, shutting down\n");
+      heater.off();
+      buttonFlag = LOW;
+      status = SHUTDOWN;
+      notificationFlag = false;
+      break;
+    case INPUT_DOUBLECLICK:
+      Serial.printf("On/off button double pressed, prompts cleared\n");
+      prompts.clear();
+      break;
+    default:
+      break;
+  }
+}
+
+// Runs the cooking state machine and the oven thermostat
+void controlTask() {
   switch(status){
     case READY:
       Serial.printf("System Ready\n\n");
       //Just sitting here waiting until we get a recipe
      if(!notificationFlag){
-        pixelFill(0,PIXELCOUNT, green);
-        displayNotification("System Ready");
+        ring.pulse(green);
+        showNotification("System Ready");
         notificationFlag = true;
         // Send to adafruit
-        if(mqtt.Update()) {
-          smartCookerStatus.publish(status);
-        }
+        outbox.enqueue(&smartCookerStatus, status);
         playClip(9);
       }
-
-      if(nfcRead(&ci, &status, &notificationFlag)){
-        /// There has been an error need to scan card again
-        playClip(6);
-        playClip(7);
-      }
       break;
     case SHUTDOWN:
       // Only come in here if we are going to sleep
       Serial.printf("Status is Shut Down\n");
       if(!notificationFlag){
-        pixelFill(0, PIXELCOUNT, blue);
-        displayNotification("Oven Off");
+        ring.solid(blue);
+        showNotification("Oven Off");
         notificationFlag = true;
       }
 
       /// Make sure the oven is off to be safe
-      digitalWrite(OVENRELAY, LOW);
+      heater.off();
+      timers.stop(&coolTimer);
+      timers.stop(&waitTimer);
+      // Let any queued prompts finish before going to sleep
+      if(prompts.isPlaying() || prompts.pending() > 0){
+        break;
+      }
+      // Sleep can come before the telemetry task next runs
+      telemetry.flush();
+      scheduler.printStats();
+      Serial.printf("Outbox: %d pending, %u sent, high water %u, %u coalesced, %u dropped\n", outbox.pending(), outbox.sent(),
+                    outbox.highWater(), outbox.coalesced(), outbox.dropped());
+      Serial.printf("Telemetry: %d frames pending, %u dropped\n", telemetry.pending(), telemetry.dropped());
+      Serial.printf("Inputs: %u edges, %u overflows, %u events dropped, door opened %u times\n", inputs.edges(), inputs.overflows(),
+                    inputs.eventsDropped(), doorOpenings);
+      Serial.printf("Timers: %u fired, %u rebased\n", timers.fired(), timers.rebases());
+      Serial.printf("Pixels: %lu frames, %lu bytes, %lu unchanged frames skipped, max render %uus\n", pixel.getFramesSent(), pixel.getBytesSent(),
+                    pixel.getFramesSkipped(), ring.getMaxRenderTime());
       sleepULP(status);
+      scheduler.resetStats();
+      probe.clearFault();
+      foodProbe.clearFault();
       status = READY;
       notificationFlag = false;
       break;  
     case HEATING:
       Serial.printf("Oven Heating\n\n");
       if(!notificationFlag){
-        pixelFill(0, PIXELCOUNT, yellow);
-        displayNotification("Oven Heating");
+        ring.gradient();
+        showNotification("Oven Heating");
         playClip(1);
         notificationFlag = true;
-        digitalWrite(OVENRELAY, HIGH);
+        // Run flat out until we get close to the cook temperature
+        heater.setSetpoint(ci.cookTemp);
+        heater.setFeedForward(true, FEEDFORWARDBAND);
           // Send to adafruit
-        if(mqtt.Update()) {
-          smartCookerStatus.publish(status);
-        }
+        outbox.enqueue(&smartCookerStatus, status);
         notificationFlag = true;
        }
       tempF = temperatureRead();
+      heater.update(tempF);
+      ring.setTemperature(tempF, RINGCOLDTEMP, ci.cookTemp);
       if(tempF >= ci.cookTemp){
+        heater.setFeedForward(false, 0);
         status = WAITINGFORFOODIN;
         notificationFlag = false;
-        waitTimer.startTimer(WAITTIME);
+        timers.start(&waitTimer, WAITTIME, waitReminder);
        }
       break;
     case WAITINGFORFOODIN:
       Serial.printf("Status is Waiting for Food In, temp: %f\n", tempF);
       /// Want to keep displaying so we can visually monitor the temp if needed
-      displayNotification("Put food in the oven", tempF);
-      playClip(6);
+      showNotification("Put food in the oven", true);
+      playClip(6, PROMPTREPEAT);
       if(!notificationFlag){
         reminder++;
-        pixelFill(0, PIXELCOUNT, orange);
+        ring.chase(orange);
         playClip(2);
+        doorOpened = false;
           //  First time through Send to adafruit
-        if(mqtt.Update()) {
-          smartCookerStatus.publish(status);
-        }
+        outbox.enqueue(&smartCookerStatus, status);
         notificationFlag = true;
       }
       
-      doorOpen = digitalRead(HALLPIN);
-
-      if(!doorOpen) {
+      // Opening the door to put the food in starts the cook
+      if(doorOpened || inputs.isActive(doorInput)) {
+          doorOpened = false;
+          timers.stop(&waitTimer);
+#ifdef SIMULATEOVEN
+          oven.loadFood();
+#endif
           notificationFlag = false;
           status = COOKING;
-          cookTimer.startTimer(ci.cookTime - COOLINGTEMPTIME);  // Food is in the oven start cooking
+          startStageTimer();  // Food is in the oven start cooking
           break;
       } else{
-         if(waitTimer.isTimerReady()){
-           if(reminder < NUMOFREMINDERS){
-              playClip(2);
-              reminder++;
-              waitTimer.startTimer(WAITTIME);
-            }
-           else{
-              status = SHUTDOWN;
-              notificationFlag = false;
-              reminder = 0;
-            }
-          }          
+          // Need to keep controlling the temp while waiting so oven doesn't get too hot
           tempF = temperatureRead();
-
-          if(tempF >= (ci.cookTemp)){ // Need to keep monitoring the temp while waiting so oven doesn't get too hot
-            digitalWrite(OVENRELAY, LOW);
-          }
-          else if(tempF < (ci.cookTemp - TEMPOFFSET)){
-            digitalWrite(OVENRELAY, HIGH);
-          }
+          heater.update(tempF);
       }
       break;
     case COOKING:
-      Serial.printf("Status is Cooking, Temp: %0.2f\n", tempF);
-      // We need to keep displaying notification so we can visually monitor the temp
-      displayNotification("Food Cooking, Temp: ", tempF);
+      Serial.printf("Status is Cooking, Temp: %0.2f, Food: %0.2f, Dose: %0.0f s\n", tempF, foodTempF, cookEstimate.getDose());
       if(!notificationFlag){
-        pixelFill(0, PIXELCOUNT, red);
+        ring.progress(red);
         playClip(3);
          // Send to adafruit
-        if(mqtt.Update()) {
-          smartCookerStatus.publish(status);
-        }
+        outbox.enqueue(&smartCookerStatus, status);
+        etaMinutes = -1;
         notificationFlag = true;
       }
-      if(cookTimer.isTimerReady()){
+      tempF = temperatureRead();
+      foodTempF = foodProbe.getTemperatureF();
+      cookEstimate.update(tempF, millis());
+      // We need to keep displaying notification so we can visually monitor the temp
+      showCookingEta();
+      if(ci.coreTemp > 0 && foodProbe.isValid() && foodTempF >= ci.coreTemp){
+        // The food is done inside, skip the rest of the recipe. Without a working food probe the timer decides.
+        Serial.printf("Food core reached %0.1f F, target %i F, finishing early\n", foodTempF, ci.coreTemp);
+        heater.off();
+        timers.start(&coolTimer, COOLINGTEMPTIME, coolingDone);
+        status = COOLING;
+        notificationFlag = false;
+      }else if(cookEstimate.isDone(millis()) && ci.stage + 1 < ci.stageCount){
+        // Move on to the next stage of the recipe
+        loadStage(&ci, ci.stage + 1);
+        heater.setSetpoint(ci.cookTemp);
+        startStageTimer();
+        Serial.printf("Starting stage %i, Temp: %i\n", ci.stage + 1, ci.cookTemp);
+      }else if(cookEstimate.isDone(millis())){
         // Food is done cooking
-        digitalWrite(OVENRELAY, LOW);
-        coolTimer.startTimer(COOLINGTEMPTIME);
+        heater.off();
+        timers.start(&coolTimer, COOLINGTEMPTIME, coolingDone);
         status = COOLING;
         notificationFlag = false;
       }else{
-        tempF = temperatureRead();
-        if(tempF > (ci.cookTemp)){
-          digitalWrite(OVENRELAY, LOW);
-        }
-        else if(tempF < (ci.cookTemp - TEMPOFFSET)){
-          digitalWrite(OVENRELAY, HIGH);
-        }
+        heater.update(tempF);
       }
       break;
     case COOLING:
-      Serial.printf("Status is Cooling\n");
+      Serial.printf("Status is Cooling, %u s left\n", (unsigned int)(timers.getRemaining(&coolTimer) / 1000));
       if(!notificationFlag){
-        pixelFill(0, PIXELCOUNT, indigo);
+        ring.pulse(indigo);
         reminder++;
         playClip(4);
         // Send to adafruit
-        if(mqtt.Update()) {
-          smartCookerStatus.publish(status);
-        }
+        outbox.enqueue(&smartCookerStatus, status);
+        outbox.enqueue(&smartCookerEta, 0);
+        cookEstimate.stop();
 
-        displayNotification("Food is Cooling");
+        showNotification("Food is Cooling");
         notificationFlag = true;
       }
-
-     if(coolTimer.isTimerReady()){
-        status=WAITINGFORFOODOUT;
-        notificationFlag = false;
-        waitTimer.startTimer(WAITTIME);
-      }
       break;
     case WAITINGFORFOODOUT:
       Serial.printf("Status is Waiting for Food Out\n");
       if(!notificationFlag){
-        pixelFill(0, PIXELCOUNT, violet);
-        displayNotification("Take Food Out of the Oven");
+        ring.chase(violet);
+        doorOpened = false;
+        showNotification("Take Food Out of the Oven");
         playClip(6);
         playClip(5);
         reminder++;
         notificationFlag = true;
         // Send to adafruit
-        if(mqtt.Update()) {
-          smartCookerStatus.publish(status);
-        }
+        outbox.enqueue(&smartCookerStatus, status);
       }
-      playClip(6);
-      doorOpen = digitalRead(HALLPIN);
-
-      if(!doorOpen){
+      playClip(6, PROMPTREPEAT);
+      if(doorOpened || inputs.isActive(doorInput)){
+        doorOpened = false;
+        timers.stop(&waitTimer);
         // put the system to sleep
         status = SHUTDOWN;
         notificationFlag = false;
         reminder = 0;
-        break;
-      }if(waitTimer.isTimerReady()){
-        if(reminder < NUMOFREMINDERS){
-          reminder++;
-          playClip(5);
-          waitTimer.startTimer(WAITTIME);
-        }else {
-          // put the system to sleep
-          status = SHUTDOWN;
-          notificationFlag = false;
-          reminder = 0;
-        }
-    } 
+      }
     break;
   }
 }
 
-// Lights up a segment of the pixel strip while randomly changing brightness for a blinking affect
-void pixelFill(int startPixel, int endPixel, int hexColor, bool clear){
-  if(clear){
-    pixel.clear();
-    pixel.show();
-  }else{
-    for(int i = startPixel; i < endPixel; i++){
-      pixel.setPixelColor(i, hexColor);
-      pixel.show();
-    }
+// Redraws the OLED at most once a second, only when the message changed or the temperature is shown
+void uiTask() {
+  if(displayChanged || displayTemp){
+    displayNotification(message, displayTemp ? tempF : 0);
+    displayChanged = false;
+  }
+}
+
+// Keeps the MQTT connection alive, handles remote commands and publishes status changes
+void networkTask() {
+  char frame[TELEMETRYFRAMESIZE * 4 / 3 + 4];
+
+  // Update() sends the keepalive pings itself
+  if(!MQTT_connect()) {
+    return;
+  }
+
+  // Runs remoteCommand() for dashboard commands and picks up PUBACKs and PINGRESPs
+  mqtt.dispatchPackets();
+
+  // Forward anything queued while the broker was away, a few records per pass in one TCP write.
+  // PUBACKs come back through dispatchPackets() on the next pass.
+  mqtt.beginBatch();
+  outbox.drain(PUBLISHBATCH);
+  while(telemetry.peek(frame, sizeof(frame)) && smartCookerTelemetry.publish(frame)) {
+    telemetry.pop();
+  }
+  mqtt.endBatch();
+}
+
+// Samples the oven while a cook is running, the network task publishes the telemetry frames
+void telemetryTask() {
+  static unsigned int lastTempFeed;
+  telemetrySample sample;
+  const schedulerTask *control;
+
+  if(status == READY || status == SHUTDOWN) {
+    // The cook is over, don't leave its last few samples in a frame that won't fill
+    telemetry.flush();
+    return;
+  }
+  control = scheduler.getTask(controlTaskId);
+  sample.timestamp = Time.now();
+  sample.tempF = probe.getTemperatureF();
+  sample.setpointF = heater.getSetpoint();
+  sample.relayOn = heater.isRelayOn();
+  sample.dutySeconds = heater.getOnTime() / 1000;
+  sample.controlPeriod = control->lastInterval;
+  sample.nfcErrors = nfcErrors;
+  sample.mqttFailures = mqtt.getFailures();
+  telemetry.record(sample);
+
+  // tempF only moves in the states that run the heater, the probe is current in all of them
+  if((millis() - lastTempFeed) >= TEMPFEEDPERIOD && probe.isValid()) {
+    outbox.enqueue(&smartCookerTemp, probe.getTemperatureF(), 1);
+    lastTempFeed = millis();
+  }
+}
+
+// Looks for a recipe card while the system is ready
+void nfcTask() {
+  if(status != READY){
+    return;
+  }
+  if(nfcRead(&ci, &status, &notificationFlag)){
+    nfcErrors++;
+    /// There has been an error need to scan card again
+    playClip(6, PROMPTREPEAT);
+    playClip(7, PROMPTREPEAT);
   }
 }
 
+// Queues a message for the OLED, the UI task draws it
+void showNotification(String newMessage, bool withTemp) {
+  if(newMessage != message || withTemp != displayTemp){
+    message = newMessage;
+    displayTemp = withTemp;
+    displayChanged = true;
+  }
+}
+
+// Draws the next status ring frame, unchanged frames aren't sent to the strip
+void pixelTask() {
+  ring.render();
+}
+
 // Displays notifications to OLED
 void displayNotification(String message, float temp) {
   String dateTime, timeStamp;
   dateTime = Time.timeStr();
+  // Only the changed bytes go out when the frame is flushed, so don't push the cleared frame first
   display.clearDisplay();
-  display.display();
   timeStamp = dateTime.substring(11, 19);
   display.setTextSize(TEXTSIZE);
   display.setTextColor(WHITE);
@@ -323,36 +467,56 @@ void displayNotification(String message, float temp) {
   }else{
    display.printf("%s %0.2f\nTime: %s ", message.c_str(),  temp, timeStamp.c_str());
   }
- display.display();
+ display.displayAsync();
 }
 
 bool nfcRead(struct cookingInstructions* cookingStruct, systemStatus * status, bool *notification){
-  if (nfc.scan()) {
-    if (nfc.readData(dataNameRead, RECIPENAMEBLOCK) != 1) {
-      Serial.printf("Block %i Read failure!\n", RECIPENAMEBLOCK);
+  recipeError error;
+  DFRobot_PN532::sTiming_t timing;
+  unsigned int swipeStart;
+  int stageTotal;
+
+  nfc.resetTiming();
+  swipeStart = millis();
+  if (nfc.beginSession()) {
+    // One card select, then one authentication per sector for all the blocks we need
+    if (!nfc.readBlocks(recipeData, RECIPERECORDBLOCK, 1)) {
+      Serial.printf("Block %i Read failure!\n", RECIPERECORDBLOCK);
       return true;
     }
-    else {
-      cookingStruct->recipeName = (char *)dataNameRead;
-      Serial.printf("Recipe Name: %s\n", cookingStruct->recipeName.c_str());
-    }
-    if (nfc.readData(dataTempRead, RECIPETEMPBLOCK) != 1) {
-       Serial.printf("Block %i Read failure!\n", RECIPETEMPBLOCK);
-       return true;
+    if (recipeData[0] == RECIPEMAGIC) {
+      // Binary card, the rest of the record is in the next two blocks
+      if (!nfc.readBlocks(recipeData + BLOCK_SIZE, RECIPERECORDBLOCK + 1, RECIPERECORDSIZE / BLOCK_SIZE - 1)) {
+        Serial.printf("Block %i Read failure!\n", RECIPERECORDBLOCK + 1);
+        return true;
+      }
+      error = decodeRecipe(recipeData, cookingStruct);
     }
     else {
-      cookingStruct->cookTemp = (atoi((char*)dataTempRead) - 150); // Had to subtract from temperature to compensate for a faulty thermocouple
-      Serial.printf("Recipe Temp: %i\n", cookingStruct->cookTemp);
+      // Old ASCII card, block 4 already holds the time so read the name and temperature blocks after it
+      if (!nfc.readBlocks(recipeData + BLOCK_SIZE, RECIPENAMEBLOCK, 2)) {
+        Serial.printf("Block %i Read failure!\n", RECIPENAMEBLOCK);
+        return true;
+      }
+      error = decodeLegacyRecipe(recipeData + BLOCK_SIZE, recipeData + 2 * BLOCK_SIZE, recipeData, cookingStruct);
     }
-    if (nfc.readData(dataTimeRead, RECIPETIMEBLOCK) != 1) {
-      Serial.printf("Block %i Read failure!\n", RECIPETIMEBLOCK);
+    nfc.endSession();
+    if (error != RECIPE_OK) {
+      Serial.printf("Recipe card error: %s\n", recipeErrorString(error));
       return true;
-   }
-    else {
-      cookingStruct->cookTime = atoi((char*)dataTimeRead) * 60000; // Need to convert to ms
-      Serial.printf("Recipe Time: %i\n", cookingStruct->cookTime);
     }
-    delay(500);
+    applyCalibration(cookingStruct);
+
+    stageTotal = 0;
+    for (int i = 0; i < cookingStruct->stageCount; i++) {
+      stageTotal += cookingStruct->stages[i].cookMinutes;
+    }
+    Serial.printf("Recipe Name: %s\n", cookingStruct->recipeName);
+    Serial.printf("Recipe Temp: %i, Stages: %i, Total Time: %i min\n", cookingStruct->cookTemp, cookingStruct->stageCount, stageTotal);
+
+    timing = nfc.getTiming();
+    Serial.printf("Card read in %ums: %u scans %uus, %u auths %uus, %u reads %uus\n", millis() - swipeStart,
+                  timing.scanCount, timing.scanTime, timing.authCount, timing.authTime, timing.readCount, timing.readTime);
 
     *status=HEATING;
     *notification = false;
@@ -361,62 +525,155 @@ bool nfcRead(struct cookingInstructions* cookingStruct, systemStatus * status, b
   return false;
 }
 
-float temperatureRead(){
-  float tempC, tempF;
-  // Monitor Temperature of Oven
-  tempStatus = thermocouple.read();
-  if (tempStatus != STATUS_OK) {
-    Serial.printf("temperatureRead ERROR!\n");
+// Old cards take 150 F off to make up for the faulty thermocouple, a calibration table corrects the probe itself
+void applyCalibration(struct cookingInstructions* cookingStruct){
+  if(thermocouples.isCalibrated() && cookingStruct->calOffset == LEGACYCALOFFSET){
+    cookingStruct->calOffset = 0;
+    loadStage(cookingStruct, cookingStruct->stage);
   }
+}
 
-  tempC = thermocouple.getTemperature();
-  tempF = (9.0/5.0)* tempC + 32;
-  Serial.printf("Temperature:%0.2f or %0.2f\n",tempC,tempF);
-  return tempF;
+// Cloud function, sets and stores a thermocouple calibration from "measured:actual,..." pairs in C
+// with measured ascending, e.g. "20:22,100:118,250:301". A "zone/" prefix picks a thermocouple other
+// than zone 0, e.g. "2/20:21,250:262". An empty list clears it.
+int calibrateCommand(String points){
+  float measured[MAX6675_CAL_POINTS], actual[MAX6675_CAL_POINTS];
+  const char *p;
+  char *end;
+  int count, zone;
+
+  count = 0;
+  zone = 0;
+  p = points.c_str();
+  if(strchr(p, '/') != NULL){
+    zone = strtol(p, &end, 10);
+    if(end == p || *end != '/' || zone < 0 || zone >= THERMOCOUPLECOUNT){
+      return -1;
+    }
+    p = end + 1;
+  }
+  while(*p != 0){
+    if(count == MAX6675_CAL_POINTS){
+      return -1;
+    }
+    measured[count] = strtof(p, &end);
+    if(end == p || *end != ':'){
+      return -1;
+    }
+    p = end + 1;
+    actual[count] = strtof(p, &end);
+    if(end == p){
+      return -1;
+    }
+    count++;
+    p = (*end == ',') ? end + 1 : end;
+    if(*end != ',' && *end != 0){
+      return -1;
+    }
+  }
+  if(!thermocouples.zone(zone).setCalibration(measured, actual, count)){
+    return -1;
+  }
+  thermocouples.zone(zone).saveCalibration(CALIBRATIONADDR + zone * sizeof(MAX6675Calibration));
+  Serial.printf("Thermocouple %i calibration saved: %i points\n", zone, count);
+  return count;
 }
 
-// Function to connect and reconnect as necessary to the MQTT server.
-// Should be called in the loop function and it will take care if connecting.
-void MQTT_connect() {
-    int8_t ret;
+// Filtered and weighted oven temperature in F, the sensor task keeps it current
+float temperatureRead(){
+  return probe.getTemperatureF();
+}
 
-    // Return if already connected.
-    if (mqtt.connected()) {
-        return;
-    }
+// Reads all the thermocouples once per conversion and trips the cook if the oven probes have failed
+void sensorTask() {
+  static bool tripped = false;
+  static unsigned int lastRead;
+  static uint8_t lastFaults;
+  unsigned int now;
+  uint8_t readStatus;
+
+  // The scheduler may run the task early to hold its cadence, reading sooner restarts the conversion
+  now = millis();
+  if((now - lastRead) < MAX6675CONVERSION) {
+    return;
+  }
+  lastRead = now;
+
+  // One SPI burst for every zone. A failed cavity zone drops out of the weighted temperature,
+  // the probe only faults once none of them can be read.
+  readStatus = thermocouples.read();
+  probe.update(readStatus, thermocouples.getWeighted(), now);
+  foodProbe.update(thermocouples.getStatus(FOODPROBE), thermocouples.getTemperature(FOODPROBE), now);
+  if(thermocouples.getFaultMask() != lastFaults) {
+    lastFaults = thermocouples.getFaultMask();
+    Serial.printf("Thermocouple zones failing: %02X, read in %lu us\n", lastFaults, thermocouples.getReadTime());
+  }
 
-    Serial.print("Connecting to MQTT... ");
+  tempStatus = probe.getFaultStatus();
+  if(!probe.isFaulted()) {
+    tripped = false;
+    return;
+  }
+  if(tripped || (status != HEATING && status != WAITINGFORFOODIN && status != COOKING)) {
+    return;
+  }
+  // Never leave the relay running on a temperature we can't trust
+  heater.off();
+  Serial.printf("Thermocouple fault %02X after %u bad frames, heater off\n", tempStatus, probe.getBadFrames());
+  ring.pulse(red);
+  showNotification("Thermocouple Fault");
+  status = SHUTDOWN;
+  notificationFlag = true;
+  outbox.enqueue(&smartCookerStatus, status);
+  tripped = true;
+}
 
-    while ((ret = mqtt.connect()) !=  0) {  // connect will return 0 for connected
-        Serial.printf("Error Code %s\n", mqtt.connectErrorString(ret));
-        Serial.printf("Retrying MQTT connection in 5 seconds...\n");
-        mqtt.disconnect();
-        delay(5000);  // wait 5 seconds and try again
-    }
-    Serial.printf("MQTT Connected!\n");
+// Feeds the thermocouple driver from the oven model, driven by the heater relay and door sensor
+uint16_t simulatedFrame(uint8_t zone){
+#ifdef SIMULATEOVEN
+  // The model only moves on once per burst
+  oven.update(millis(), heater.isRelayOn(), inputs.isActive(doorInput));
+  return oven.getFrame(zone);
+#else
+  return 0;
+#endif
 }
 
-bool MQTT_ping() {
-    static unsigned int last;
-    bool pingStatus;
-
-    if ((millis() - last) > 120000) {
-        Serial.printf("Pinging MQTT \n");
-        pingStatus = mqtt.ping();
-        if (!pingStatus) {
-            Serial.printf("Disconnecting \n");
-            mqtt.disconnect();
-        }
-        last = millis();
+// Steps the MQTT connection manager, it never waits on the broker so the heater keeps its cadence
+// during an outage. Returns true once connected and subscribed.
+bool MQTT_connect() {
+    static mqttState_t lastState = MQTT_STATE_BACKOFF;
+    bool connected;
+
+    connected = mqtt.Update();
+    if (mqtt.getState() != lastState) {
+        Serial.printf("MQTT %s -> %s (%lu ms %s since boot, %u failures)\n", mqtt.stateString(lastState), mqtt.stateString(mqtt.getState()),
+                      mqtt.getStateTime(lastState), mqtt.stateString(lastState), mqtt.getFailures());
+        lastState = mqtt.getState();
     }
-    return pingStatus;
+    return connected;
 }
 
 void sleepULP(systemStatus status){
-  displayNotification("System Turned Off");
-  pixelFill(0, PIXELCOUNT, white, true);
+  // A thermocouple fault stays up while asleep, so whoever comes back to the oven sees why it
+  // stopped. The pulse stops with the scheduler, a solid ring holds its last frame.
+  if(probe.isFaulted()) {
+    displayNotification("Thermocouple Fault");
+    ring.solid(red);
+    ring.render();
+  }
+  else {
+    displayNotification("System Turned Off");
+    ring.off();
+  }
+  // Nothing runs loop() while asleep, the frame has to be on the panel first, and the ring frame
+  // still going out by DMA has to finish before the SPI stops with the clocks
+  while(!display.flush());
+  while(!pixel.canShow()) {
+    delayMicroseconds(50);
+  }
   // Just to be safe
-  digitalWrite(OVENRELAY, LOW);
+  heater.off();
 
   SystemSleepConfiguration config;
   config.mode(SystemSleepMode::ULTRA_LOW_POWER).gpio(D11, CHANGE);
@@ -425,79 +682,144 @@ void sleepULP(systemStatus status){
 
   if(result.wakeupReason() == SystemSleepWakeupReason::BY_GPIO){
     Serial.printf("We just woke up\n");
+    inputs.resume();
+    timers.rebase(System.millis());
     displayNotification("System Turned On");
     buttonFlag = true;
     playClip(8);
   }
 }
 
-void playClip(int trackNumber){
-    myDFPlayer.play(trackNumber);
-    delay(6000);
+// Queues a voice prompt, the prompt queue plays it once the previous clip has finished. A holdoff
+// keeps a prompt asked for on every pass from repeating more often than that
+void playClip(int trackNumber, unsigned int holdoff){
+    prompts.enqueue(trackNumber, holdoff);
 }
 
-void getAdafruitSubscription(systemStatus *status, struct cookingInstructions* cookingStruct, bool *notification){
-  Adafruit_MQTT_Subscribe *subscription;
-
-  while ((subscription = mqtt.readSubscription(0))) {
-    Serial.printf("getting subscription\n\n");
-    if (subscription == &smartCookerRemote) {
-      subValue = atoi((char *)smartCookerRemote.lastread);
-      Serial.printf("cooker value: %d\n", subValue);
-      switch(subValue){
-        case DECVOL:
-          Serial.printf("Decreasing Volumn\n");
-          myDFPlayer.volumeDown();
-          break;
-        case INCVOL:
-           Serial.printf("Increasing Volumn\n");
-           myDFPlayer.volumeUp();
-          break;
-        case SLEEP:
-           Serial.printf("Shutting Down\n");
-           sleepULP(*status);
-          break;
-        case LASAGNA:
-          Serial.printf("Cooking Lasagna\n");
-          cookingStruct->recipeName = recipes[0].cookTime;
-          cookingStruct->cookTemp = recipes[0].cookTemp;
-          cookingStruct->cookTime = recipes[0].cookTime;
-          *status=HEATING;
-          *notification = false;          
-          break;
-        case CHICKEN:
-         Serial.printf("Cooking Chicken\n");
-          cookingStruct->recipeName = recipes[1].cookTime;
-          cookingStruct->cookTemp = recipes[1].cookTemp;
-          cookingStruct->cookTime = recipes[1].cookTime;
-          *status=HEATING;
-          *notification = false;          
-          break;
-        case MACCHEESE:
-         Serial.printf("Cooking Mac & Cheese\n");
-          cookingStruct->recipeName = recipes[2].cookTime;
-          cookingStruct->cookTemp = recipes[2].cookTemp;
-          cookingStruct->cookTime = recipes[2].cookTime;
-          *status=HEATING;
-          *notification = false;          
-          break;
-        case STEAK:
-        Serial.printf("Cooking Steak\n");
-          cookingStruct->recipeName = recipes[3].cookTime;
-          cookingStruct->cookTemp = recipes[3].cookTemp;
-          cookingStruct->cookTime = recipes[3].cookTime;
-          *status=HEATING;
-          *notification = false;          
-          break;
-        case TURKEY:
-        Serial.printf("Cooking Turkey\n");
-          cookingStruct->recipeName = recipes[4].cookTime;
-          cookingStruct->cookTemp = recipes[4].cookTemp;
-          cookingStruct->cookTime = recipes[4].cookTime;
-          *status=HEATING;
-          *notification = false;          
-          break;
-      }
-    }
+// Handles a command from the Adafruit dashboard, called by mqtt.dispatchPackets() with the value already parsed
+void remoteCommand(uint32_t value){
+  subValue = value;
+  Serial.printf("cooker value: %d\n", subValue);
+  switch(subValue){
+    case DECVOL:
+      Serial.printf("Decreasing Volumn\n");
+      myDFPlayer.volumeDown();
+      break;
+    case INCVOL:
+       Serial.printf("Increasing Volumn\n");
+       myDFPlayer.volumeUp();
+      break;
+    case SLEEP:
+       Serial.printf("Shutting Down\n");
+       sleepULP(status);
+      break;
+    case LASAGNA:
+      Serial.printf("Cooking Lasagna\n");
+      startRemoteRecipe(0, &status, &ci, &notificationFlag);
+      break;
+    case CHICKEN:
+     Serial.printf("Cooking Chicken\n");
+      startRemoteRecipe(1, &status, &ci, &notificationFlag);
+      break;
+    case MACCHEESE:
+     Serial.printf("Cooking Mac & Cheese\n");
+      startRemoteRecipe(2, &status, &ci, &notificationFlag);
+      break;
+    case STEAK:
+    Serial.printf("Cooking Steak\n");
+      startRemoteRecipe(3, &status, &ci, &notificationFlag);
+      break;
+    case TURKEY:
+    Serial.printf("Cooking Turkey\n");
+      startRemoteRecipe(4, &status, &ci, &notificationFlag);
+      break;
+  }
+}
+void startRemoteRecipe(int recipe, systemStatus *status, struct cookingInstructions* cookingStruct, bool *notification){
+  *cookingStruct = recipes[recipe];
+  loadStage(cookingStruct, 0);
+  applyCalibration(cookingStruct);
+  *status=HEATING;
+  *notification = false;
+}
+
+// Starts the dose estimate for the current stage
+void startStageTimer(){
+  cookEstimate.begin(ci.cookTemp, stageCookTime(ci.stage), millis());
+}
+
+// Cooling time is up, ask for the food to be taken out
+void coolingDone(){
+  if(status != COOLING){
+    return;
+  }
+  status = WAITINGFORFOODOUT;
+  notificationFlag = false;
+  timers.start(&waitTimer, WAITTIME, waitReminder);
+}
+
+// A reminder period ran out with the food still waiting to go in or come out, remind again or give up
+void waitReminder(){
+  if(status != WAITINGFORFOODIN && status != WAITINGFORFOODOUT){
+    return;
+  }
+  if(reminder < NUMOFREMINDERS){
+    playClip(status == WAITINGFORFOODIN ? 2 : 5);
+    reminder++;
+    timers.start(&waitTimer, WAITTIME, waitReminder);
+  }else{
+    // put the system to sleep
+    status = SHUTDOWN;
+    notificationFlag = false;
+    reminder = 0;
+  }
+}
+
+// Recipe time for a stage in ms, the last stage finishes early to leave time for cooling
+unsigned int stageCookTime(int stage){
+  unsigned int cookTime;
+
+  cookTime = ci.stages[stage].cookMinutes * 60000;
+  if(stage + 1 < ci.stageCount){
+    return cookTime;
+  }
+  return cookTime > COOLINGTEMPTIME ? cookTime - COOLINGTEMPTIME : 0;
+}
+
+// ms until the food is done, the current stage as estimated plus the recipe time of the ones after it
+unsigned int cookRemaining(){
+  unsigned int remaining;
+
+  remaining = cookEstimate.getRemaining();
+  for(int i = ci.stage + 1; i < ci.stageCount; i++){
+    remaining += stageCookTime(i);
+  }
+  return remaining;
+}
+
+// Recipe time for the whole cook in ms
+unsigned int cookTotal(){
+  unsigned int total;
+
+  total = 0;
+  for(int i = 0; i < ci.stageCount; i++){
+    total += stageCookTime(i);
+  }
+  return total;
+}
+
+// Puts the time left on the OLED and the ring, and sends it to the dashboard whenever the minute changes
+void showCookingEta(){
+  unsigned int remaining, total;
+  int minutes;
+
+  remaining = cookRemaining();
+  total = cookTotal();
+  ring.setProgress(total > remaining ? total - remaining : 0, total);
+  minutes = (remaining + 59999) / 60000;
+  showNotification(String::format("Cooking, %i min left\nTemp:", minutes), true);
+  if(minutes != etaMinutes){
+    outbox.enqueue(&smartCookerEta, minutes);
+    etaMinutes = minutes;
   }
 }
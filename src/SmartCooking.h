@@ -2,44 +2,105 @@
 #include "DFRobot_PN532.h"
 #include "DFRobotDFPlayerMini.h"
 #include "MAX6675.h"
+#include "MAX6675Array.h"
 #include "Adafruit_SSD1306.h"
 #include "Adafruit_MQTT/Adafruit_MQTT_SPARK.h"
 #include "Adafruit_MQTT.h"
 #include "neopixel.h"
-#include "Button.h"
-#include "IoTTimer.h"
 #include "Colors.h"
 #include "credentials.h"
+#include "PromptQueue.h"
+#include "Scheduler.h"
+#include "PublishQueue.h"
+#include "Telemetry.h"
+#include "HeaterController.h"
+#include "TemperatureProbe.h"
+#include "CookEstimator.h"
+#include "PixelEffects.h"
+#include "InputManager.h"
+#include "TimerWheel.h"
+#include "OvenModel.h"
+#include "RecipeRecord.h"
+
+// Uncomment to run against a simulated oven instead of the thermocouple, the relay still switches
+//#define SIMULATEOVEN
 
 const int TIMEZONE = -4;
 const int ONOFFBUTTON = D11;
-const int HALLPIN = D19;
+const int HALLPIN = D19;         // Hall sensor on the door, reads LOW while it is open
+const int BUTTONDEBOUNCE = 30;   // ms
+const int LONGPRESSTIME = 2000;  // Hold the on/off button this long to shut down from any state
+const int DOUBLEPRESSTIME = 350; // Second press within this long of the first silences the queued prompts
+const int DOORDEBOUNCE = 100;
 const int OVENRELAY = D4;
 const int OLED_RESET= -1;
 const int TEXTSIZE = 1;
+const int OLEDBURST = 128;       // OLED data bytes per I2C transaction, one full page
+const int WIREBUFFERSIZE = OLEDBURST + 1;  // Plus the SSD1306 control byte
 const int PIXELCOUNT = 12;
 const int BRIGHTNESS = 35;
+const int RINGCOLDTEMP = 70;     // F, the bottom of the heating gradient on the ring
 const int BLOCK_SIZE = 16;
 const int PN532_IRQ = 2;
-const int POLLING = 0;
+const int POLLING = 0;   // Poll the PN532 status byte, use 1 if the IRQ line is wired to PN532_IRQ
 const int RECIPENAMEBLOCK = 1;
 const int RECIPETEMPBLOCK = 2;
 const int RECIPETIMEBLOCK = 4;
+const int CALIBRATIONADDR = 0;    // EEPROM address of the first thermocouple calibration table, one per zone after it
+const int RECIPERECORDBLOCK = 4;  // Binary recipe cards use blocks 4 to 6, old cards keep the time in block 4
+
+// Thermocouples sharing SCK and MISO, three around the cavity and a food probe. The zone next to the
+// element reads hot while it is on, so it counts for less when regulating. The food probe isn't
+// regulated on, it ends the cook early once the recipe's core temperature is reached.
+const int THERMOCOUPLECOUNT = 4;
+const uint8_t THERMOCOUPLESELECTS[THERMOCOUPLECOUNT] = {SS, D5, D6, D7};
+const float ZONEWEIGHTS[THERMOCOUPLECOUNT] = {0.5, 0.2, 0.3, 0.0};
+const int FOODPROBE = 3;
 
 const int WAITTIME = 10*60000; //Remind every 10 minutes
 const int COOLINGTEMPTIME = 15*60000;  // Has to be in ms
 const int NUMOFREMINDERS = 3; // Three reminders before the system shuts down
-const int TEMPOFFSET = 5; 
+const int PROMPTREPEAT = 15000; // Prompts asked for every pass (reminder tone, scan again) repeat at most every 15 s
+
+// Heater PID tuning, output is the fraction of each relay window the oven is on
+const float HEATERKP = 0.04;      // Full power at 25 F below the setpoint
+const float HEATERKI = 0.0004;    // Per F second
+const float HEATERKD = 2.0;       // Per F/s
+const int HEATERWINDOW = 20000;   // Relay time proportioning window in ms
+const int MINRELAYTIME = 2000;    // Shortest on or off time to protect the relay contacts
+const float FEEDFORWARDBAND = 25; // Heat flat out until within this many degrees of the setpoint
+
+const int SENSORPERIOD = MAX6675CONVERSION;  // Thermocouple read once per conversion
+const int CONTROLPERIOD = 250;  // Temperature control at 4 Hz
+const int NETWORKPERIOD = 100;  // MQTT at 10 Hz
+const int NFCPERIOD = 500;      // Card scan at 2 Hz
+const int UIPERIOD = 1000;      // OLED at 1 Hz
+const int PIXELPERIOD = PIXELFRAMEPERIOD;  // Status ring animation frames
+const int TELEMETRYPERIOD = 10000;  // Telemetry sample every 10 s, so a frame a minute
+const int TEMPFEEDPERIOD = 60000;   // Oven temperature to the dashboard feed once a minute
+const int PUBLISHBATCH = 4;     // Queued records forwarded per network pass
+const int PUBLISHWINDOW = 4;    // QoS 1 publishes allowed to wait for their PUBACK at once
 
 // Declare Objects
 //Timer timer(1000, watchdogCheckin);
 DFRobot_PN532_IIC  nfc(PN532_IRQ, POLLING);
 Adafruit_SSD1306 display(OLED_RESET);
 Adafruit_NeoPixel pixel(PIXELCOUNT, SPI1, WS2812B);
-Button onOffButton(ONOFFBUTTON);
-IoTTimer cookTimer, coolTimer, waitTimer, wdTimer;
-MAX6675 thermocouple;
+PixelEffects ring(&pixel);
+InputManager inputs;
+TimerWheel timers;            // Runs the timers below off System.millis()
+WheelTimer coolTimer, waitTimer;
+MAX6675Array thermocouples;
+TemperatureProbe probe;       // Weighted cavity temperature
+TemperatureProbe foodProbe;
+CookEstimator cookEstimate;   // Ends each cook stage on thermal dose instead of a fixed countdown
 DFRobotDFPlayerMini myDFPlayer;
+PromptQueue prompts(&myDFPlayer);
+Scheduler scheduler;
+#ifdef SIMULATEOVEN
+OvenModel oven;
+#endif
+HeaterController heater(OVENRELAY, HEATERKP, HEATERKI, HEATERKD, HEATERWINDOW, MINRELAYTIME);
 TCPClient TheClient;
 ApplicationWatchdog *wd;
 
@@ -51,13 +112,12 @@ Adafruit_MQTT_SPARK mqtt(&TheClient, AIO_SERVER, AIO_SERVERPORT, AIO_USERNAME, A
 // Setup Feeds to publish or subscribe
 // Notice MQTT paths for AIO follow the form: <username>/feeds/<feedname>
 Adafruit_MQTT_Subscribe smartCookerRemote = Adafruit_MQTT_Subscribe(&mqtt, AIO_USERNAME "/feeds/smartcooker");
-Adafruit_MQTT_Publish smartCookerStatus = Adafruit_MQTT_Publish(&mqtt,AIO_USERNAME "/feeds/smartcookerstatus");
-
-struct cookingInstructions {
-  String recipeName;
-  int cookTemp;
-  int cookTime;
-};
+Adafruit_MQTT_Publish smartCookerStatus = Adafruit_MQTT_Publish(&mqtt,AIO_USERNAME "/feeds/smartcookerstatus", MQTT_QOS_1);
+Adafruit_MQTT_Publish smartCookerTemp = Adafruit_MQTT_Publish(&mqtt,AIO_USERNAME "/feeds/smartcookertemp", MQTT_QOS_1);
+Adafruit_MQTT_Publish smartCookerEta = Adafruit_MQTT_Publish(&mqtt,AIO_USERNAME "/feeds/smartcookereta", MQTT_QOS_1);
+Adafruit_MQTT_Publish smartCookerTelemetry = Adafruit_MQTT_Publish(&mqtt,AIO_USERNAME "/feeds/smartcookertelemetry", MQTT_QOS_1);
+PublishQueue outbox;
+Telemetry telemetry;
 
 enum systemStatus {
   READY = 27,
@@ -68,11 +128,13 @@ enum systemStatus {
   COOLING,
   WAITINGFORFOODOUT
 };
-cookingInstructions recipes[5] = {{"Lasagna", 375, 40 },
-                                 {"Baked Chicken", 350, 36 },
-                                 {"Mac & Cheese", 350, 36 }, 
-                                 {"Salsbury Steak and Mac & Cheese", 350, 35 },
-                                 {"Roasted Turkey", 350, 35 }};
+//Hard coded recipes for remote cooking, stage temperatures in F and times in minutes, then the food core target in F.
+// They target the real oven temperature, the old cards' 150 F thermocouple offset is for cards only.
+cookingInstructions recipes[5] = {{"Lasagna", 0, 0, 0, 1, 0, {{375, 40}}, 165},
+                                 {"Baked Chicken", 0, 0, 0, 1, 0, {{350, 36}}, 165},
+                                 {"Mac & Cheese", 0, 0, 0, 1, 0, {{350, 36}}, 165}, 
+                                 {"Salsbury Steak & Mac Cheese", 0, 0, 0, 1, 0, {{350, 35}}, 160},
+                                 {"Roasted Turkey", 0, 0, 0, 1, 0, {{350, 35}}, 165}};
 
 enum remoteControl {
   DECVOL = 0,
@@ -85,33 +147,54 @@ enum remoteControl {
   TURKEY = 21
 };
 
-//Hard coded recipes for remote cooking
-
 // Variables
 struct cookingInstructions ci;
 bool tempToHigh = TRUE;
 uint8_t tempStatus;
 systemStatus status = READY;
 int reminder = 0;
-float tempC, tempF;
+float tempC, tempF, foodTempF;
 String message;
-uint8_t dataNameRead[16] = {0};
-uint8_t dataTempRead[16] = {0};
-uint8_t dataTimeRead[16] = {0};
+uint8_t recipeData[RECIPERECORDSIZE] = {0};
 int vol, subValue, buttonFlag = HIGH;
 bool notificationFlag = false;
-int doorOpen = LOW;
+bool displayChanged = false;
+bool displayTemp = false;
+int controlTaskId;
+int etaMinutes = -1;      // Last cook ETA sent to the dashboard
+uint16_t nfcErrors = 0;
+int onOffInput, doorInput;
+bool doorOpened = false;    // Set by a door open event, cleared by the state waiting for one
+unsigned int doorOpenings = 0;
 
 /************Declare Functions*************/
 void sleepULP(systemStatus status);
-void MQTT_connect();
-bool MQTT_ping();
+bool MQTT_connect();
 void getConc() ;
-void pixelFill(int startPixel, int endPixel, int hexColor, bool clear=false);
 void displayNotification(String message, float temp=0);
+void showNotification(String newMessage, bool withTemp=false);
 bool nfcRead(struct cookingInstructions* cookingStruct, systemStatus * status, bool *notification);
 float temperatureRead();
 void watchdogHandler();
 void watchdogCheckin();
-void playClip(int trackNumber);
-void getAdafruitSubscription(systemStatus *status, struct cookingInstructions* cookingStruct, bool *notification);
+void playClip(int trackNumber, unsigned int holdoff = 0);
+void inputCommand(inputEvent event);
+void remoteCommand(uint32_t value);
+void startRemoteRecipe(int recipe, systemStatus *status, struct cookingInstructions* cookingStruct, bool *notification);
+void startStageTimer();
+void coolingDone();
+void waitReminder();
+unsigned int stageCookTime(int stage);
+unsigned int cookRemaining();
+unsigned int cookTotal();
+void showCookingEta();
+void controlTask();
+void networkTask();
+void nfcTask();
+void uiTask();
+void pixelTask();
+void sensorTask();
+void applyCalibration(struct cookingInstructions* cookingStruct);
+int calibrateCommand(String points);
+void telemetryTask();
+uint16_t simulatedFrame(uint8_t zone);
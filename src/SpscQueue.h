@@ -0,0 +1,47 @@
+#ifndef _SPSCQUEUE_H_
+#define _SPSCQUEUE_H_
+
+#include "Particle.h"
+#include <atomic>
+
+// Fixed size ring for one producer and one consumer, e.g. an interrupt handler feeding loop().
+// Only the producer moves the head and only the consumer moves the tail, so neither side has to
+// disable interrupts or take a lock. SIZE must be a power of two.
+template<typename T, int SIZE>
+class SpscQueue {
+  static_assert(SIZE > 0 && (SIZE & (SIZE - 1)) == 0, "SpscQueue size must be a power of two");
+
+  T _items[SIZE];
+  std::atomic<uint16_t> _head, _tail;
+
+  public:
+    SpscQueue() : _head(0), _tail(0) {}
+
+    // Producer side, returns false if the ring is full
+    bool push(const T &item) {
+      uint16_t head = _head.load(std::memory_order_relaxed);
+
+      if((uint16_t)(head - _tail.load(std::memory_order_acquire)) >= SIZE) {
+        return false;
+      }
+      _items[head & (SIZE - 1)] = item;
+      _head.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+    // Consumer side, returns false if the ring is empty
+    bool pop(T *item) {
+      uint16_t tail = _tail.load(std::memory_order_relaxed);
+
+      if(tail == _head.load(std::memory_order_acquire)) {
+        return false;
+      }
+      *item = _items[tail & (SIZE - 1)];
+      _tail.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+    int count() { return (uint16_t)(_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire)); };
+};
+
+#endif // _SPSCQUEUE_H_
@@ -0,0 +1,113 @@
+#include "Telemetry.h"
+
+static const char BASE64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+Telemetry::Telemetry() {
+  _head = 0;
+  _count = 0;
+  _dropped = 0;
+  _frame = _frames[0];
+  _length = 0;
+  _samples = 0;
+  memset(&_last, 0, sizeof(_last));
+}
+
+void Telemetry::putVarint(uint32_t value) {
+  while(value >= 0x80) {
+    _frame[_length++] = (value & 0x7F) | 0x80;
+    value >>= 7;
+  }
+  _frame[_length++] = value;
+}
+
+void Telemetry::putSigned(int32_t value) {
+  putVarint(((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+void Telemetry::record(const telemetrySample &sample) {
+  int32_t temp, lastTemp;
+
+  if(_samples == 0) {
+    // Every frame starts from zero so it can be decoded on its own
+    memset(&_last, 0, sizeof(_last));
+    _frame[0] = TELEMETRYVERSION;
+    _frame[1] = 0;
+    _length = 2;
+  }
+  temp = lroundf(sample.tempF * 10);
+  lastTemp = lroundf(_last.tempF * 10);
+  putVarint(sample.timestamp - _last.timestamp);
+  putSigned(temp - lastTemp);
+  putSigned(lroundf(sample.setpointF) - lroundf(_last.setpointF));
+  putVarint(sample.relayOn ? 1 : 0);
+  putVarint(sample.dutySeconds - _last.dutySeconds);
+  putSigned(sample.controlPeriod - _last.controlPeriod);
+  putVarint((uint16_t)(sample.nfcErrors - _last.nfcErrors));
+  putVarint((uint16_t)(sample.mqttFailures - _last.mqttFailures));
+  _last = sample;
+  _samples++;
+  _frame[1] = _samples;
+
+  if(_samples == TELEMETRYSAMPLES || _length + TELEMETRYMAXSAMPLE > TELEMETRYFRAMESIZE) {
+    closeFrame();
+  }
+}
+
+void Telemetry::flush() {
+  if(_samples > 0) {
+    closeFrame();
+  }
+}
+
+void Telemetry::closeFrame() {
+  int slot;
+
+  slot = (_head + _count) % TELEMETRYFRAMES;
+  _lengths[slot] = _length;
+  if(_count == TELEMETRYFRAMES - 1) {
+    // Keep one slot to fill, lose the oldest frame
+    _head = (_head + 1) % TELEMETRYFRAMES;
+    _dropped++;
+  }
+  else {
+    _count++;
+  }
+  _frame = _frames[(_head + _count) % TELEMETRYFRAMES];
+  _samples = 0;
+  _length = 0;
+}
+
+bool Telemetry::peek(char *out, int size) {
+  const uint8_t *frame;
+  uint32_t triple;
+  int i, n, length;
+
+  if(_count == 0) {
+    return false;
+  }
+  frame = _frames[_head];
+  length = _lengths[_head];
+  if(size < (length + 2) / 3 * 4 + 1) {
+    return false;
+  }
+  n = 0;
+  for(i = 0; i < length; i += 3) {
+    triple = frame[i] << 16;
+    if(i + 1 < length) triple |= frame[i + 1] << 8;
+    if(i + 2 < length) triple |= frame[i + 2];
+    out[n++] = BASE64[(triple >> 18) & 0x3F];
+    out[n++] = BASE64[(triple >> 12) & 0x3F];
+    out[n++] = (i + 1 < length) ? BASE64[(triple >> 6) & 0x3F] : '=';
+    out[n++] = (i + 2 < length) ? BASE64[triple & 0x3F] : '=';
+  }
+  out[n] = 0;
+  return true;
+}
+
+void Telemetry::pop() {
+  if(_count == 0) {
+    return;
+  }
+  _head = (_head + 1) % TELEMETRYFRAMES;
+  _count--;
+}
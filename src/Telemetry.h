@@ -0,0 +1,60 @@
+#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+#include "Particle.h"
+
+const uint8_t TELEMETRYVERSION = 1;
+const int TELEMETRYSAMPLES = 6;         // Samples per frame
+const int TELEMETRYFRAMESIZE = 96;      // Encoded bytes per frame, base64 makes it 128 characters
+const int TELEMETRYMAXSAMPLE = 32;      // Worst case encoded sample, a frame closes early rather than overflow
+const int TELEMETRYFRAMES = 8;          // Completed frames held while offline
+
+struct telemetrySample {
+  uint32_t timestamp;       // Unix seconds
+  float tempF;
+  float setpointF;
+  bool relayOn;
+  uint32_t dutySeconds;     // Cumulative relay on time
+  uint16_t controlPeriod;   // ms between the last two control task runs
+  uint16_t nfcErrors;       // Cumulative
+  uint16_t mqttFailures;    // Cumulative, failed connects and failed writes
+};
+
+// Packs samples into compact binary frames for publishing.
+//
+// Frame layout: version, sample count, then for each sample its difference from the previous one
+// (the first is against all zeros) as LEB128 varints, signed fields zigzag encoded:
+//   seconds, tempF x10, setpoint F, relay (0/1), duty seconds, last control interval ms, NFC errors,
+//   MQTT failures
+// tools/decode_telemetry.py turns a stream of frames back into a cook curve.
+class Telemetry {
+  uint8_t _frames[TELEMETRYFRAMES][TELEMETRYFRAMESIZE];
+  uint8_t _lengths[TELEMETRYFRAMES];
+  int _head, _count;            // Completed frames
+  uint8_t *_frame;              // Frame being filled, the slot after the last completed one
+  int _length, _samples;
+  telemetrySample _last;
+  unsigned int _dropped;
+
+  void putVarint(uint32_t value);
+  void putSigned(int32_t value);
+  void closeFrame();
+
+  public:
+    Telemetry();
+
+    void record(const telemetrySample &sample);
+    // Closes the frame being filled early so its samples can go out, at the end of a cook
+    void flush();
+
+    // Oldest completed frame as base64 in out (at least 4 * TELEMETRYFRAMESIZE / 3 + 2 bytes),
+    // false if there is none. pop() removes it once it has been published.
+    bool peek(char *out, int size);
+    void pop();
+
+    int pending() { return _count; };
+    int filling() { return _samples; };
+    unsigned int dropped() { return _dropped; };
+};
+
+#endif // _TELEMETRY_H_
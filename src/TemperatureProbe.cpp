@@ -0,0 +1,122 @@
+#include "TemperatureProbe.h"
+
+TemperatureProbe::TemperatureProbe() {
+  _next = 0;
+  _filled = 0;
+  _temp = 0;
+  _rate = 0;
+  _initialized = false;
+  _lastUpdate = 0;
+  _badRun = 0;
+  _badFrames = 0;
+  _faulted = false;
+  _faultStatus = STATUS_OK;
+  _jumpReading = 0;
+  _jumpRun = 0;
+  _reseeds = 0;
+}
+
+void TemperatureProbe::update(uint8_t status, float reading, unsigned int now) {
+  if(status == STATUS_OK && reading > PROBEMAXTEMP) {
+    status = STATUS_ERROR;
+  }
+  if(status == STATUS_OK && _initialized && fabsf(reading - _temp) > PROBEMAXJUMP) {
+    // A glitch doesn't repeat itself, a run that agrees means the estimate lost the oven
+    _jumpRun = (_jumpRun > 0 && fabsf(reading - _jumpReading) <= PROBEAGREE) ? _jumpRun + 1 : 1;
+    _jumpReading = reading;
+    if(_jumpRun >= PROBERESEED) {
+      _reseeds++;
+      restart();
+    }
+    else {
+      status = STATUS_ERROR;
+    }
+  }
+  else {
+    _jumpRun = 0;
+  }
+  if(status != STATUS_OK) {
+    _badFrames++;
+    _faultStatus = status;
+    if(++_badRun >= PROBEFAULTLIMIT) {
+      _faulted = true;
+    }
+    return;
+  }
+  _badRun = 0;
+
+  _window[_next] = reading;
+  _next = (_next + 1) % PROBEMEDIAN;
+  if(_filled < PROBEMEDIAN) {
+    _filled++;
+  }
+  filter(median(), now);
+}
+
+float TemperatureProbe::median() {
+  float sorted[PROBEMEDIAN], value;
+  int i, j;
+
+  // Insertion sort, the window is tiny
+  for(i = 0; i < _filled; i++) {
+    value = _window[i];
+    for(j = i; j > 0 && sorted[j - 1] > value; j--) {
+      sorted[j] = sorted[j - 1];
+    }
+    sorted[j] = value;
+  }
+  return sorted[_filled / 2];
+}
+
+void TemperatureProbe::filter(float measurement, unsigned int now) {
+  float dt, q, s, k0, k1, error, p00, p01, p10, p11;
+
+  if(!_initialized) {
+    _temp = measurement;
+    _rate = 0;
+    _p00 = PROBENOISE;
+    _p01 = _p10 = 0;
+    _p11 = 1.0;
+    _lastUpdate = now;
+    _initialized = true;
+    return;
+  }
+  dt = (now - _lastUpdate) / 1000.0;
+  _lastUpdate = now;
+
+  // Predict, temperature moves on at the current rate and the rate drifts
+  _temp += _rate * dt;
+  q = PROBEACCEL;
+  p00 = _p00 + dt * (_p10 + _p01) + dt * dt * _p11 + q * dt * dt * dt * dt / 4;
+  p01 = _p01 + dt * _p11 + q * dt * dt * dt / 2;
+  p10 = _p10 + dt * _p11 + q * dt * dt * dt / 2;
+  p11 = _p11 + q * dt * dt;
+
+  // Correct with the median
+  s = p00 + PROBENOISE;
+  k0 = p00 / s;
+  k1 = p10 / s;
+  error = measurement - _temp;
+  _temp += k0 * error;
+  _rate += k1 * error;
+  _p00 = (1 - k0) * p00;
+  _p01 = (1 - k0) * p01;
+  _p10 = p10 - k1 * p00;
+  _p11 = p11 - k1 * p01;
+}
+
+void TemperatureProbe::clearFault() {
+  _faulted = false;
+  _badRun = 0;
+  _faultStatus = STATUS_OK;
+  // The oven may be somewhere else entirely by now
+  restart();
+}
+
+// Starts the estimate again from the next good frame
+void TemperatureProbe::restart() {
+  _initialized = false;
+  _filled = 0;
+  _next = 0;
+  _jumpRun = 0;
+}
@@ -0,0 +1,60 @@
+#ifndef _TEMPERATUREPROBE_H_
+#define _TEMPERATUREPROBE_H_
+
+#include "Particle.h"
+#include "MAX6675.h"
+
+const unsigned int MAX6675CONVERSION = 220;  // ms per conversion, reading sooner restarts it
+const int PROBEMEDIAN = 5;                   // Samples in the median window, odd
+const int PROBEFAULTLIMIT = 5;               // Consecutive bad frames before the fault latches
+const float PROBEMAXJUMP = 50.0;             // C away from the estimate, more is a bad frame
+const int PROBERESEED = 3;                   // Jumped frames in a row that agree restart the estimate
+const float PROBEAGREE = 5.0;                // C between jumped frames that agree
+const float PROBEMAXTEMP = 1000.0;           // C, the MAX6675 tops out at 1023.75
+const float PROBENOISE = 0.5;                // Measurement variance after the median, C^2
+const float PROBEACCEL = 0.01;               // Process noise, variance of changes in the heating rate, (C/s^2)^2
+
+// Thermocouple sampling pipeline. Fed once per conversion with a reading from a MAX6675 or from
+// one view of a MAX6675Array, it drops frames that are flagged open, missing or implausible,
+// takes the median of the last few good samples and feeds it to a constant-rate Kalman filter
+// that estimates the temperature and how fast it is changing. A run of bad frames latches a
+// fault that stays set until clearFault(). Frames that jump away from the estimate but agree with
+// each other are the oven and not a glitch, a few of them in a row restart the estimate there.
+class TemperatureProbe {
+  float _window[PROBEMEDIAN];
+  int _next, _filled;
+  float _temp, _rate;                // Estimate in C and C/s
+  float _p00, _p01, _p10, _p11;      // Estimate covariance
+  bool _initialized;
+  unsigned int _lastUpdate;
+  int _badRun;
+  unsigned int _badFrames;
+  bool _faulted;
+  uint8_t _faultStatus;
+  float _jumpReading;                // Last frame that jumped, and how many agreeing ones in a row
+  int _jumpRun;
+  unsigned int _reseeds;
+
+  void restart();
+  float median();
+  void filter(float measurement, unsigned int now);
+
+  public:
+    TemperatureProbe();
+
+    // Adds one conversion taken at time now (ms), status and reading in C as the driver returned them
+    void update(uint8_t status, float reading, unsigned int now);
+
+    float getTemperature() { return _temp; };
+    float getTemperatureF() { return _temp * 9.0 / 5.0 + 32; };
+    float getRate() { return _rate; };                        // C/s
+    bool isValid() { return _initialized && !_faulted; };
+
+    bool isFaulted() { return _faulted; };
+    uint8_t getFaultStatus() { return _faultStatus; };     // MAX6675 status of the last bad frame
+    unsigned int getBadFrames() { return _badFrames; };
+    unsigned int getReseeds() { return _reseeds; };
+    void clearFault();
+};
+
+#endif // _TEMPERATUREPROBE_H_
@@ -0,0 +1,205 @@
+#include "TimerWheel.h"
+
+WheelTimer::WheelTimer() {
+  _next = NULL;
+  _pprev = NULL;
+  _expires = 0;
+  _remaining = 0;
+  _function = NULL;
+  _state = TIMER_IDLE;
+}
+
+TimerWheel::TimerWheel() {
+  for(int level = 0; level < WHEELLEVELS; level++) {
+    for(int slot = 0; slot < WHEELSLOTS; slot++) {
+      _slots[level][slot] = NULL;
+    }
+  }
+  _now = 0;
+  _time = 0;
+  _running = 0;
+  _fired = 0;
+  _rebases = 0;
+}
+
+void TimerWheel::begin(uint64_t now) {
+  rebase(now);
+  _rebases = 0;
+}
+
+// Files a timer in the coarsest level that still has a slot just for its tick range
+void TimerWheel::link(WheelTimer *timer) {
+  WheelTimer **slot;
+  uint64_t expires, delta;
+  int level;
+
+  expires = timer->_expires;
+  if(expires < _now) {
+    // Overdue, runs out on the next tick
+    expires = _now;
+  }
+  delta = expires - _now;
+  if(delta >= WHEELRANGE) {
+    // Further off than the wheel reaches, park it in the top level and file it again as it comes round
+    expires = _now + WHEELRANGE - 1;
+    delta = WHEELRANGE - 1;
+  }
+  level = 0;
+  while(delta >= ((uint64_t)1 << (WHEELBITS * (level + 1)))) {
+    level++;
+  }
+  slot = &_slots[level][(expires >> (WHEELBITS * level)) & (WHEELSLOTS - 1)];
+
+  timer->_next = *slot;
+  if(timer->_next != NULL) {
+    timer->_next->_pprev = &timer->_next;
+  }
+  timer->_pprev = slot;
+  *slot = timer;
+}
+
+void TimerWheel::unlink(WheelTimer *timer) {
+  *timer->_pprev = timer->_next;
+  if(timer->_next != NULL) {
+    timer->_next->_pprev = timer->_pprev;
+  }
+  timer->_next = NULL;
+  timer->_pprev = NULL;
+}
+
+// Files the timers in one slot of a higher level again, they land a level or more further down
+void TimerWheel::cascade(int level, int slot) {
+  WheelTimer *timer, *next;
+
+  timer = _slots[level][slot];
+  _slots[level][slot] = NULL;
+  while(timer != NULL) {
+    next = timer->_next;
+    link(timer);
+    timer = next;
+  }
+}
+
+void TimerWheel::tick() {
+  WheelTimer *expired, *timer;
+  int index, slot;
+
+  index = _now & (WHEELSLOTS - 1);
+  // Every time a level comes round bring the next slot of the level above down into it
+  if(index == 0) {
+    for(int level = 1; level < WHEELLEVELS; level++) {
+      slot = (_now >> (WHEELBITS * level)) & (WHEELSLOTS - 1);
+      cascade(level, slot);
+      if(slot != 0) {
+        break;
+      }
+    }
+  }
+  // Callbacks restarting a timer start it from the tick it ran out on, so a repeating timer doesn't drift
+  _time = _now;
+  _now++;
+
+  // Take the slot over first so a callback can restart its own timer or stop any other one
+  expired = _slots[0][index];
+  _slots[0][index] = NULL;
+  if(expired != NULL) {
+    expired->_pprev = &expired;
+  }
+  while(expired != NULL) {
+    timer = expired;
+    unlink(timer);
+    timer->_state = TIMER_EXPIRED;
+    _running--;
+    _fired++;
+    if(timer->_function != NULL) {
+      timer->_function();
+    }
+  }
+}
+
+void TimerWheel::start(WheelTimer *timer, uint64_t msec, timerFunction function) {
+  if(timer->_state == TIMER_RUNNING) {
+    unlink(timer);
+    _running--;
+  }
+  timer->_expires = _time + msec;
+  timer->_function = function;
+  timer->_state = TIMER_RUNNING;
+  link(timer);
+  _running++;
+}
+
+void TimerWheel::stop(WheelTimer *timer) {
+  if(timer->_state == TIMER_RUNNING) {
+    unlink(timer);
+    _running--;
+  }
+  timer->_state = TIMER_IDLE;
+}
+
+void TimerWheel::pause(WheelTimer *timer) {
+  if(timer->_state != TIMER_RUNNING) {
+    return;
+  }
+  timer->_remaining = getRemaining(timer);
+  unlink(timer);
+  _running--;
+  timer->_state = TIMER_PAUSED;
+}
+
+void TimerWheel::resume(WheelTimer *timer) {
+  if(timer->_state != TIMER_PAUSED) {
+    return;
+  }
+  start(timer, timer->_remaining, timer->_function);
+}
+
+uint64_t TimerWheel::getRemaining(WheelTimer *timer) {
+  if(timer->_state == TIMER_PAUSED) {
+    return timer->_remaining;
+  }
+  if(timer->_state != TIMER_RUNNING || timer->_expires <= _time) {
+    return 0;
+  }
+  return timer->_expires - _time;
+}
+
+void TimerWheel::update(uint64_t now) {
+  if(now < _now) {
+    return;
+  }
+  if(now - _now > WHEELREBASE) {
+    rebase(now);
+  }
+  while(_now <= now) {
+    tick();
+  }
+  _time = now;
+}
+
+void TimerWheel::rebase(uint64_t now) {
+  WheelTimer *timers, *timer, *next;
+
+  // Gather every running timer in one list, then file them again against the new clock
+  timers = NULL;
+  for(int level = 0; level < WHEELLEVELS; level++) {
+    for(int slot = 0; slot < WHEELSLOTS; slot++) {
+      timer = _slots[level][slot];
+      _slots[level][slot] = NULL;
+      while(timer != NULL) {
+        next = timer->_next;
+        timer->_next = timers;
+        timers = timer;
+        timer = next;
+      }
+    }
+  }
+  _now = now;
+  _time = now;
+  while(timers != NULL) {
+    next = timers->_next;
+    link(timers);
+    timers = next;
+  }
+  _rebases++;
+}
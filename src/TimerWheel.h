@@ -0,0 +1,88 @@
+#ifndef _TIMERWHEEL_H_
+#define _TIMERWHEEL_H_
+
+#include "Particle.h"
+
+const int WHEELBITS = 6;
+const int WHEELSLOTS = 1 << WHEELBITS;   // Slots per level
+const int WHEELLEVELS = 4;               // 1 ms ticks, so the levels cover 64 ms, 4 s, 4.4 min and 4.6 h
+const uint64_t WHEELRANGE = (uint64_t)1 << (WHEELBITS * WHEELLEVELS);
+const unsigned int WHEELREBASE = 1000;   // ms, a bigger jump in the clock re-files the timers instead of stepping every tick
+
+typedef void (*timerFunction)();
+
+enum timerState {
+  TIMER_IDLE,
+  TIMER_RUNNING,
+  TIMER_PAUSED,
+  TIMER_EXPIRED          // Ran out, stays expired until it is started again
+};
+
+// A timer owned by the caller and filed in a TimerWheel while it runs
+class WheelTimer {
+  friend class TimerWheel;
+
+  WheelTimer *_next;
+  WheelTimer **_pprev;         // The pointer to this timer in its slot list
+  uint64_t _expires;           // Absolute ms on the wheel clock
+  uint64_t _remaining;         // ms left when paused
+  timerFunction _function;
+  timerState _state;
+
+  public:
+    WheelTimer();
+
+    timerState getState() { return _state; };
+    bool isRunning() { return _state == TIMER_RUNNING; };
+    bool isPaused() { return _state == TIMER_PAUSED; };
+    bool isExpired() { return _state == TIMER_EXPIRED; };
+};
+
+// Hierarchical timer wheel on a 64 bit monotonic ms clock (System.millis()), so nothing wraps.
+// A timer is filed in the level whose slots are just fine enough for how far off it is and moves
+// down a level as its time gets closer. Each tick only looks at one slot, plus one slot of a higher
+// level every 64 ticks, so the cost per tick doesn't depend on how many timers are running.
+// Callbacks run from update(), in loop(), never from an interrupt.
+class TimerWheel {
+  WheelTimer *_slots[WHEELLEVELS][WHEELSLOTS];
+  uint64_t _now;               // Next tick to process
+  uint64_t _time;              // Clock at the last update(), timers start from here
+  int _running;
+  unsigned int _fired, _rebases;
+
+  void link(WheelTimer *timer);
+  void unlink(WheelTimer *timer);
+  void cascade(int level, int slot);
+  void tick();
+
+  public:
+    TimerWheel();
+
+    // Starts the clock at now (ms), timers started before this run from 0
+    void begin(uint64_t now);
+
+    // (Re)starts a timer to run out msec from now, the function (if any) is called when it does
+    void start(WheelTimer *timer, uint64_t msec, timerFunction function = NULL);
+    void stop(WheelTimer *timer);
+
+    // Pausing keeps the time left, resume() carries on from there
+    void pause(WheelTimer *timer);
+    void resume(WheelTimer *timer);
+
+    // ms until a running timer runs out, the time left for a paused one, otherwise 0
+    uint64_t getRemaining(WheelTimer *timer);
+
+    // Runs out every timer due by time now (ms) and calls their functions
+    void update(uint64_t now);
+
+    // Moves the clock to now without stepping through the ticks in between, e.g. after sleep.
+    // Timers keep their absolute expiry, any that are overdue run out on the next update().
+    void rebase(uint64_t now);
+
+    uint64_t now() { return _time; };
+    int running() { return _running; };
+    unsigned int fired() { return _fired; };
+    unsigned int rebases() { return _rebases; };
+};
+
+#endif // _TIMERWHEEL_H_
@@ -0,0 +1,126 @@
+// Runs the cook estimator against fixed temperatures, where the dose has a closed form, and against
+// the oven model with a bang-bang thermostat, with and without the door left open for a while, to
+// check the stage stretches for a cold oven, shortens for a hot one and the ETA settles.
+#include "HostTest.h"
+#include "CookEstimator.h"
+#include "OvenModel.h"
+
+namespace {
+
+const unsigned int SAMPLE = 250;              // ms, the control task period
+const unsigned int COOKTIME = 40 * 60000;     // ms at the setpoint
+const float SETPOINT = 350;
+
+float toF(float c) {
+  return c * 9 / 5 + 32;
+}
+
+// Feeds a constant temperature until the stage is done, returns how long it took in ms
+unsigned int runConstant(float temp) {
+  CookEstimator est;
+  unsigned int now = 0;
+
+  est.begin(SETPOINT, COOKTIME, now);
+  while(!est.isDone(now)) {
+    now += SAMPLE;
+    est.update(temp, now);
+  }
+  return now;
+}
+
+// Preheats the model oven and cooks a stage in it with the door open for doorMinutes from doorAt
+// minutes in, returns the stage length in ms and the worst ETA error over the last third in worstEta
+unsigned int runOven(int doorAt, int doorMinutes, float *worstEta) {
+  OvenModel oven;
+  CookEstimator est;
+  unsigned int now, start, elapsed, length;
+  std::vector<std::pair<unsigned int, unsigned int>> etas;   // (elapsed, remaining) ms
+  bool door;
+  float temp;
+
+  now = 0;
+  oven.update(now, false, false);
+  do {
+    now += SAMPLE;
+    temp = toF(oven.getProbeTemp(0));
+    oven.update(now, temp < SETPOINT, false);
+  } while(temp < SETPOINT);
+
+  start = now;
+  est.begin(SETPOINT, COOKTIME, now);
+  while(!est.isDone(now)) {
+    now += SAMPLE;
+    elapsed = now - start;
+    door = doorAt >= 0 && elapsed >= doorAt * 60000u && elapsed < (doorAt + doorMinutes) * 60000u;
+    temp = toF(oven.getProbeTemp(0));
+    oven.update(now, temp < SETPOINT && !door, door);
+    est.update(temp, now);
+    etas.push_back({elapsed, est.getRemaining()});
+  }
+  length = now - start;
+
+  *worstEta = 0;
+  for(const std::pair<unsigned int, unsigned int> &eta : etas) {
+    if(eta.first >= length * 2 / 3) {
+      *worstEta = max(*worstEta, fabsf((float)eta.first + eta.second - length) / 60000);
+    }
+  }
+  return length;
+}
+
+}
+
+int main() {
+  unsigned int length, steady, opened;
+  float worstEta, worstOpened;
+
+  // At the setpoint the dose is the recipe time
+  length = runConstant(SETPOINT);
+  CHECK(length >= COOKTIME && length <= COOKTIME + SAMPLE);
+
+  // Half way into the band cooks at half the rate, up to the stretch limit
+  length = runConstant(SETPOINT - DOSEBAND / 2);
+  CHECK(length >= COOKTIME * DOSESTRETCH && length <= COOKTIME * DOSESTRETCH + SAMPLE);
+  length = runConstant(SETPOINT - DOSEBAND - 10);
+  CHECK(length >= COOKTIME * DOSESTRETCH && length <= COOKTIME * DOSESTRETCH + SAMPLE);
+
+  // Running hot cooks faster, but no faster than DOSEMAXRATE
+  length = runConstant(SETPOINT + DOSEBAND / 10);
+  CHECK(fabsf(length - COOKTIME / 1.1f) <= SAMPLE);
+  length = runConstant(SETPOINT + DOSEBAND);
+  CHECK(fabsf(length - COOKTIME / DOSEMAXRATE) <= SAMPLE);
+
+  // The ETA at the start is the recipe time, and it never runs past the stretch limit
+  CookEstimator est;
+  est.begin(SETPOINT, COOKTIME, 1000);
+  CHECK(est.isRunning());
+  CHECK(est.getRemaining() == COOKTIME);
+  for(unsigned int now = 1000 + SAMPLE; now < 1000 + COOKTIME; now += SAMPLE) {
+    est.update(0, now);
+  }
+  CHECK(est.getDose() == 0);
+  CHECK(est.getRemaining() <= COOKTIME * (DOSESTRETCH - 1) + SAMPLE);
+  CHECK(est.getRate() >= 0);
+  est.stop();
+  est.update(SETPOINT, 1000 + 2 * COOKTIME);
+  CHECK(est.getDose() == 0);
+  CHECK(!est.isRunning());
+
+  // In the model oven the thermostat ripple around the setpoint about evens out
+  steady = runOven(-1, 0, &worstEta);
+  printf("CookEstimator: steady oven %.1f min, worst ETA error over the last third %.1f min\n", steady / 60000.0,
+         worstEta);
+  CHECK(fabsf((float)steady - COOKTIME) < COOKTIME / 10);
+  CHECK(worstEta < 1);
+
+  // Opening the door for 3 minutes stretches the stage by the time the oven spent out of the band
+  // and getting back. The ETA jumps while the door is open and has caught up again a few smoothing
+  // time constants after the oven is back at the setpoint.
+  opened = runOven(10, 3, &worstOpened);
+  printf("  door open 3 min at 10 min: %.1f min, worst ETA error over the last third %.1f min\n", opened / 60000.0,
+         worstOpened);
+  CHECK(opened > steady + 60000);
+  CHECK(opened < steady + 15 * 60000);
+  CHECK(worstOpened < 1);
+  return host::finish("CookEstimatorTest");
+}
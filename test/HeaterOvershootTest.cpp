@@ -0,0 +1,213 @@
+// Heats the oven model to 375 F and holds it there for an hour, once with the old bang-bang control
+// (relay off at the setpoint, back on TEMPOFFSET below it, checked once per 6 s pass of loop() while a
+// prompt played) and once with the HeaterController at the control task's 4 Hz. The door is opened
+// for the food when the setpoint is first reached. Reports overshoot, settling time and relay cycles.
+// Then holds the controller at a fixed output with the pass that turns the relay off running late, so
+// the next window's turn on lands inside the minimum switch time, and checks the duty still follows.
+#include "HeaterController.h"
+#include "Host.h"
+#include "HostTest.h"
+#include "OvenModel.h"
+
+namespace {
+
+const int RELAY = D4;
+const float SETPOINT = 375;
+const float ZONEWEIGHTS[OVENZONES] = {0.5, 0.2, 0.3};
+const unsigned int HOLDTIME = 3600000;   // ms at the setpoint after first reaching it
+const unsigned int DOOROPEN = 5000;
+const float SETTLEBAND = 5;              // F either side of the setpoint
+
+// Old control
+const float TEMPOFFSET = 5;
+const unsigned int BANGBANGPERIOD = 6000;   // ms, the blocking playClip() in every pass
+
+// HeaterController tuning and cadence, as in SmartCooking.h
+const float HEATERKP = 0.04;
+const float HEATERKI = 0.0004;
+const float HEATERKD = 2.0;
+const int HEATERWINDOW = 20000;
+const int MINRELAYTIME = 2000;
+const float FEEDFORWARDBAND = 25;
+const unsigned int CONTROLPERIOD = 250;
+
+// Fixed output runs
+const float DUTYOUTPUT = 0.9;
+const int DUTYWINDOWS = 30;
+const unsigned int PASSLAG = 5;          // ms the control task runs behind the window grid
+
+struct result {
+  float overshoot;          // F the reading went above the setpoint, worst case
+  float cavityOvershoot;    // F the cavity air went above it
+  float settling;           // s from first reaching the setpoint until the reading stays in the band
+  float ripple;             // F peak to peak of the reading over the last 20 minutes
+  unsigned int cycles;      // relay on switches
+  unsigned int duration;    // ms heating and holding
+};
+
+float toF(float c) {
+  return c * 9 / 5 + 32;
+}
+
+// What the sensor task reports, the weighted zones in the MAX6675's 0.25 C steps
+float readTemp(OvenModel *oven) {
+  float c = 0;
+
+  for(int i = 0; i < OVENZONES; i++) {
+    c += ZONEWEIGHTS[i] * (int)(oven->getProbeTemp(i) * 4) / 4.0;
+  }
+  return toF(c);
+}
+
+// Runs the oven with controller deciding the relay, called every period ms with the reading
+template <typename Controller> result run(unsigned int period, Controller controller) {
+  OvenModel oven;
+  result r = {0, 0, 0, 0, 0, 0};
+  unsigned int start, reached, lastOut, now;
+  float temp, low, high;
+  bool relay, lastRelay;
+
+  start = millis();
+  reached = 0;
+  lastOut = 0;
+  low = 1000;
+  high = 0;
+  lastRelay = false;
+  oven.update(start, false, false);
+  while(reached == 0 || millis() - reached < HOLDTIME) {
+    now = millis();
+    bool doorOpen = reached != 0 && now - reached < DOOROPEN;
+    oven.update(now, digitalRead(RELAY) == HIGH, doorOpen);
+    temp = readTemp(&oven);
+    if(reached == 0 && temp >= SETPOINT) {
+      reached = now;
+    }
+    if(reached != 0) {
+      r.overshoot = max(r.overshoot, temp - SETPOINT);
+      r.cavityOvershoot = max(r.cavityOvershoot, toF(oven.getOvenTemp()) - SETPOINT);
+      if(fabsf(temp - SETPOINT) > SETTLEBAND) {
+        lastOut = now;
+      }
+      if(now - reached >= HOLDTIME - 1200000) {
+        low = min(low, temp);
+        high = max(high, temp);
+      }
+    }
+    controller(temp, reached != 0);
+    relay = digitalRead(RELAY) == HIGH;
+    r.cycles += relay && !lastRelay;
+    lastRelay = relay;
+    host::advance(period * 1000ULL);
+  }
+  digitalWrite(RELAY, LOW);
+  r.settling = (lastOut > reached ? lastOut - reached : 0) / 1000.0;
+  r.ripple = high - low;
+  r.duration = millis() - start;
+  return r;
+}
+
+// Moves the clock on to ms
+void advanceTo(uint64_t ms) {
+  if(host::now() < ms * 1000) {
+    host::advance(ms * 1000 - host::now());
+  }
+}
+
+// Relay on time over DUTYWINDOWS windows at DUTYOUTPUT. The window starts at the first pass, the
+// rest run PASSLAG ms behind their deadlines, and every pass that is due to turn the relay off runs
+// late ms later than that.
+float lateOffDuty(unsigned int late) {
+  HeaterController heater(RELAY, DUTYOUTPUT / 100, 0, 0, HEATERWINDOW, MINRELAYTIME);
+  uint64_t start, next;
+  unsigned int onTime;
+
+  heater.begin();
+  heater.setSetpoint(100);
+  start = host::now() / 1000 + 1;
+  advanceTo(start);
+  onTime = heater.getOnTime();
+  heater.update(0);
+  next = start + PASSLAG;
+  advanceTo(next);
+  while(next - start < DUTYWINDOWS * HEATERWINDOW) {
+    // A steady 0 F sample keeps the output at DUTYOUTPUT
+    heater.update(0);
+    next += CONTROLPERIOD;
+    // The on time runs out at this pass, it comes late and the one after is back on the period
+    if(heater.isRelayOn() && (next - start - PASSLAG) % HEATERWINDOW == (unsigned int)(DUTYOUTPUT * HEATERWINDOW)) {
+      advanceTo(next + late);
+      heater.update(0);
+      next += CONTROLPERIOD;
+    }
+    advanceTo(next);
+  }
+  onTime = heater.getOnTime() - onTime;
+  heater.off();
+  return (float)onTime / (DUTYWINDOWS * HEATERWINDOW);
+}
+
+void print(const char *name, const result &r) {
+  char settled[32];
+
+  // Still leaving the band in the last minute counts as never settling
+  if(r.settling * 1000 >= HOLDTIME - 60000) {
+    snprintf(settled, sizeof(settled), "never");
+  }
+  else {
+    snprintf(settled, sizeof(settled), "after %.0f s", r.settling);
+  }
+  printf("%-10s overshoot %4.1f F (cavity %4.1f F), within %.0f F %s, ripple %4.1f F, %u relay cycles\n", name,
+         r.overshoot, r.cavityOvershoot, SETTLEBAND, settled, r.ripple, r.cycles);
+}
+
+}
+
+int main() {
+  pinMode(RELAY, OUTPUT);
+
+  // Old loop(): on while heating, then off at the setpoint and on again TEMPOFFSET below it
+  result bangBang = run(BANGBANGPERIOD, [](float temp, bool reached) {
+    if(!reached || temp < SETPOINT - TEMPOFFSET) {
+      digitalWrite(RELAY, HIGH);
+    }
+    else if(temp >= SETPOINT) {
+      digitalWrite(RELAY, LOW);
+    }
+  });
+
+  HeaterController heater(RELAY, HEATERKP, HEATERKI, HEATERKD, HEATERWINDOW, MINRELAYTIME);
+  heater.begin();
+  heater.setSetpoint(SETPOINT);
+  heater.setFeedForward(true, FEEDFORWARDBAND);
+  result pid = run(CONTROLPERIOD, [&heater](float temp, bool reached) {
+    if(reached) {
+      heater.setFeedForward(false, 0);
+    }
+    heater.update(temp);
+  });
+  heater.off();
+
+  print("bang-bang", bangBang);
+  print("PID", pid);
+
+  // The oven's lag is short enough that neither overshoots much, the PID holds the setpoint where
+  // bang-bang swings through TEMPOFFSET plus what the oven moves in one 6 s pass
+  CHECK(pid.overshoot <= SETTLEBAND);
+  CHECK(pid.ripple < bangBang.ripple / 2);
+  CHECK(pid.settling < bangBang.settling);
+  CHECK(pid.settling < 600);
+  // Time proportioning switches the relay at most once per window, more often than bang-bang
+  CHECK(pid.cycles <= pid.duration / HEATERWINDOW + 1);
+
+  // A turn off a few ms late pushes the next turn on into the minimum switch time, the relay comes
+  // on a pass later instead of sitting out the window
+  float onTime = lateOffDuty(0);
+  printf("duty at output %.2f: %.3f on time, ", DUTYOUTPUT, onTime);
+  CHECK(fabsf(onTime - DUTYOUTPUT) < 0.05);
+  for(unsigned int late = 10; late <= 30; late += 10) {
+    onTime = lateOffDuty(late);
+    printf("%.3f with the turn off %u ms late%s", onTime, late, late < 30 ? ", " : "\n");
+    CHECK(fabsf(onTime - DUTYOUTPUT) < 0.05);
+  }
+  return host::finish("HeaterOvershootTest");
+}
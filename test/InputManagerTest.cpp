@@ -0,0 +1,156 @@
+// Bounces a button and a door switch through the interrupt handlers and checks the events loop()
+// gets from the input manager, with loop() running every millisecond and with it stuck for seconds at
+// a time: presses and gestures come through either way, a glitch shorter than the debounce window
+// doesn't, and an edge queue overrun still ends on the level the pin settled at. The edge queue on
+// its own keeps order and its bound across the 16 bit wrap of its indexes.
+#include "Host.h"
+#include "HostTest.h"
+#include "InputManager.h"
+#include <string>
+
+namespace {
+
+const pin_t BUTTON = D2;
+const pin_t DOOR = D19;              // Hall sensor, LOW while the door is open
+const uint64_t MS = 1000;            // us
+
+InputManager inputs;
+int button, door;
+std::string events;
+
+// Level then n bounces back and forth a millisecond or two apart, ending on level
+void bounce(pin_t pin, int level, int n) {
+  for(int i = 0; i < n; i++) {
+    host::setPin(pin, !level);
+    host::advance(MS);
+    host::setPin(pin, level);
+    host::advance((i % 3) * MS);
+  }
+}
+
+// What loop() does, takes the events as "<input><type> "
+void pump() {
+  const char *types[] = {"A", "I", "C", "D", "L"};
+  inputEvent event;
+
+  inputs.update(millis());
+  while(inputs.getEvent(&event)) {
+    events += event.input == button ? "b" : "d";
+    events += types[event.type];
+    events += " ";
+  }
+}
+
+// ms of time passing, with loop() running every ms unless it is stalled
+void run(unsigned ms, bool stalled) {
+  for(unsigned i = 0; i < ms; i++) {
+    host::advance(MS);
+    if(!stalled) {
+      pump();
+    }
+  }
+}
+
+// Events since the last call are what was expected
+bool saw(const char *expected) {
+  bool match;
+
+  pump();
+  match = events == expected;
+  if(!match) {
+    printf("  expected [%s] got [%s]\n", expected, events.c_str());
+  }
+  events.clear();
+  return match;
+}
+
+}
+
+int main() {
+  SpscQueue<int, 8> queue;
+  int item;
+  bool ordered;
+
+  // The edge queue holds SIZE items, hands them back in order, and keeps doing so after its
+  // indexes wrap
+  for(int i = 0; i < 8; i++) {
+    CHECK(queue.push(i));
+  }
+  CHECK(!queue.push(8));
+  CHECK(queue.count() == 8);
+  ordered = true;
+  for(int i = 0; i < 8; i++) {
+    ordered = ordered && queue.pop(&item) && item == i;
+  }
+  CHECK(ordered);
+  CHECK(!queue.pop(&item));
+  for(int i = 0; i < 70000; i++) {
+    ordered = ordered && queue.push(i) && queue.push(i + 1) && queue.pop(&item) && item == i && queue.pop(&item) &&
+              item == i + 1;
+  }
+  CHECK(ordered);
+  CHECK(queue.count() == 0);
+
+  host::setPin(DOOR, HIGH);
+  button = inputs.addInput(BUTTON, INPUT_PULLDOWN, false, 30, 2000, 350);
+  door = inputs.addInput(DOOR, INPUT, true, 100);
+  inputs.begin();
+  CHECK(!inputs.isActive(button) && !inputs.isActive(door));
+
+  // A click while loop() is stuck for 6 s
+  bounce(BUTTON, HIGH, 6);
+  run(120, true);
+  bounce(BUTTON, LOW, 6);
+  run(6000, true);
+  CHECK(saw("bA bI bC "));
+
+  // Double click with loop() running, then inside a stall
+  for(int stalled = 0; stalled < 2; stalled++) {
+    bounce(BUTTON, HIGH, 5);
+    run(80, stalled);
+    bounce(BUTTON, LOW, 5);
+    run(150, stalled);
+    bounce(BUTTON, HIGH, 5);
+    run(80, stalled);
+    bounce(BUTTON, LOW, 5);
+    run(stalled ? 6000 : 1000, stalled);
+    CHECK(saw("bA bI bA bI bD "));
+  }
+
+  // A long press with the release inside a stall, no click after it
+  bounce(BUTTON, HIGH, 8);
+  run(2500, true);
+  bounce(BUTTON, LOW, 8);
+  run(1000, true);
+  CHECK(saw("bA bL bI "));
+
+  // The door opened with a lot of bounce and closed again
+  bounce(DOOR, LOW, 25);
+  run(3000, false);
+  CHECK(inputs.isActive(door));
+  bounce(DOOR, HIGH, 25);
+  run(500, false);
+  CHECK(saw("dA dI "));
+
+  // A glitch shorter than the debounce window is nothing
+  host::setPin(DOOR, LOW);
+  host::advance(20 * MS);
+  host::setPin(DOOR, HIGH);
+  run(500, false);
+  CHECK(saw(""));
+
+  // 300 edges while stuck overrun the queue, the door still ends up open
+  for(int i = 0; i < 150; i++) {
+    host::setPin(DOOR, LOW);
+    host::advance(MS);
+    host::setPin(DOOR, HIGH);
+    host::advance(MS);
+  }
+  host::setPin(DOOR, LOW);
+  run(6000, true);
+  CHECK(saw("dA "));
+  CHECK(inputs.overflows() > 0);
+  CHECK(inputs.eventsDropped() == 0);
+  printf("InputManager: %u edges, %u overflowed the queue\n", inputs.edges(), inputs.overflows());
+  return host::finish("InputManagerTest");
+}
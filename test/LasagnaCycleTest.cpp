@@ -0,0 +1,182 @@
+// Runs a whole Lasagna cook through the unmodified firmware: the recipe card is swiped, the oven
+// heats, the food goes in, cooks, cools and comes out, and the cooker goes to sleep. The oven model
+// stands in for the oven, feeding the thermocouples through SPI and following the relay and door,
+// and a user opens the door when the voice prompts ask. Runs in virtual time, well under a second.
+#include <algorithm>
+#include <chrono>
+#include "HostDevices.h"
+#include "HostTest.h"
+#include "OvenModel.h"
+#include "RecipeRecord.h"
+#include "Telemetry.h"
+
+void setup();
+void loop();
+extern Telemetry telemetry;
+
+namespace {
+
+const pin_t RELAY = D4;
+const pin_t DOOR = D19;              // Hall sensor, LOW while the door is open
+const pin_t THERMOCOUPLES[4] = {SS, D5, D6, D7};
+const int RINGPIXELS = 12;            // PIXELCOUNT, on SPI1
+const uint64_t LOOPSTEP = 1000;      // us of idle time between loop() passes
+const uint64_t SWIPEAT = 5000000;    // Card put on the reader this long after setup()
+const uint64_t SWIPETIME = 2000000;
+const uint64_t USERDELAY = 20000000; // The user gets to the oven this long after a prompt
+const uint64_t DOOROPEN = 5000000;
+const uint64_t RUNLIMIT = 3 * 3600000000ULL;
+const uint64_t STUCKLIMIT = 30000000; // One pass of loop() taking this long means it's stuck
+const int PROMPTHEATING = 1, PROMPTFOODIN = 2, PROMPTCOOKING = 3, PROMPTCOOLING = 4, PROMPTFOODOUT = 5;
+
+OvenModel oven;
+FakePN532 nfc;
+FakeDFPlayer player;
+FakeSSD1306 oled;
+FakeNeoPixelStrip strip;
+FakeMAX6675 thermocouples[4] = {{[]() { return oven.getFrame(0); }}, {[]() { return oven.getFrame(1); }},
+                                {[]() { return oven.getFrame(2); }}, {[]() { return oven.getFrame(3); }}};
+bool asleep;
+uint64_t sleptAt;
+bool relayAtSleep;
+bool ringBusyAtSleep;
+
+float toF(float c) {
+  return c * 9 / 5 + 32;
+}
+
+void writeCard() {
+  cookingInstructions ci = {"Lasagna", 0, 0, 0, 1, 0, {{375, 40}}, 165};
+  uint8_t record[RECIPERECORDSIZE];
+
+  encodeRecipe(&ci, record);
+  for(int i = 0; i < RECIPERECORDSIZE / 16; i++) {
+    nfc.writeBlock(4 + i, record + i * 16);
+  }
+}
+
+// Time of the first play of a track at or after from, 0 if it wasn't played
+uint64_t promptTime(int track, uint64_t from = 0) {
+  for(const FakeDFPlayer::play &p : player.plays) {
+    if(p.track == track && p.at >= from) {
+      return p.at;
+    }
+  }
+  return 0;
+}
+
+}
+
+int main() {
+  uint64_t start, passStart, maxPass, promptPass, doorAt, doorClose, foodInPrompt, foodOutPrompt;
+  unsigned passes;
+  size_t plays;
+  float peakOven, peakFood;
+  bool foodIn;
+
+  for(int zone = 0; zone < 4; zone++) {
+    host::attachSpi(HAL_SPI_INTERFACE1, THERMOCOUPLES[zone], &thermocouples[zone]);
+  }
+  host::attachI2C(0x24, &nfc);
+  host::attachI2C(0x3C, &oled);
+  host::attachSpi(HAL_SPI_INTERFACE2, PIN_INVALID, &strip);
+  host::attachSerial(1, &player);
+  host::setPin(DOOR, HIGH);
+  host::onSleep([](const SystemSleepConfiguration &config) {
+    (void)config;
+    asleep = true;
+    sleptAt = host::now();
+    relayAtSleep = host::getPin(RELAY);
+    ringBusyAtSleep = hal_spi_is_dma_busy(HAL_SPI_INTERFACE2);
+    return SystemSleepWakeupReason::BY_GPIO;
+  });
+  writeCard();
+
+  auto wallStart = std::chrono::steady_clock::now();
+  host::setDeadline(STUCKLIMIT);
+  setup();
+  start = host::now();
+
+  maxPass = promptPass = 0;
+  passes = 0;
+  peakOven = peakFood = 0;
+  doorAt = doorClose = 0;
+  foodInPrompt = foodOutPrompt = 0;
+  foodIn = false;
+  while(!asleep && host::now() - start < RUNLIMIT) {
+    // The outside world catches up with the time loop() took
+    oven.update(host::now() / 1000, host::getPin(RELAY), host::getPin(DOOR) == LOW);
+    peakOven = max(peakOven, oven.getOvenTemp());
+    peakFood = max(peakFood, oven.getFoodTemp());
+    nfc.setCard(host::now() - start >= SWIPEAT && host::now() - start < SWIPEAT + SWIPETIME);
+
+    // Open the door a little after being asked to put the food in or take it out
+    if(foodInPrompt == 0 && (foodInPrompt = promptTime(PROMPTFOODIN)) != 0) {
+      doorAt = foodInPrompt + USERDELAY;
+    }
+    if(foodOutPrompt == 0 && (foodOutPrompt = promptTime(PROMPTFOODOUT)) != 0) {
+      doorAt = foodOutPrompt + USERDELAY;
+    }
+    if(doorAt != 0 && host::now() >= doorAt) {
+      host::setPin(DOOR, LOW);
+      if(!foodIn) {
+        oven.loadFood();
+        foodIn = true;
+      }
+      doorClose = host::now() + DOOROPEN;
+      doorAt = 0;
+    }
+    if(doorClose != 0 && host::now() >= doorClose) {
+      host::setPin(DOOR, HIGH);
+      doorClose = 0;
+    }
+
+    passStart = host::now();
+    host::setDeadline(passStart + STUCKLIMIT);
+    plays = player.plays.size();
+    loop();
+    maxPass = max(maxPass, host::now() - passStart);
+    if(player.plays.size() != plays) {
+      promptPass = max(promptPass, host::now() - passStart);
+    }
+    passes++;
+    host::advance(LOOPSTEP);
+  }
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+  printf("Lasagna cycle: %.1f min virtual in %.0f ms wall, %u loop passes, longest pass %.1f ms, %.1f ms starting a prompt\n",
+         (host::now() - start) / 60e6, wall * 1000, passes, maxPass / 1000.0, promptPass / 1000.0);
+  printf("  card read %s, heating %.1f min, cooking %.1f min, cooling %.1f min, food out %.1f min\n",
+         host::serialContains("Recipe Name: Lasagna") ? "ok" : "failed",
+         (promptTime(PROMPTFOODIN) - promptTime(PROMPTHEATING)) / 60e6,
+         (promptTime(PROMPTCOOLING) - promptTime(PROMPTCOOKING)) / 60e6,
+         (promptTime(PROMPTFOODOUT) - promptTime(PROMPTCOOLING)) / 60e6,
+         (sleptAt - promptTime(PROMPTFOODOUT)) / 60e6);
+  printf("  peak oven %.0f F, peak food %.0f F, %u card scans, %u OLED bytes, %zu prompts\n",
+         toF(peakOven), toF(peakFood), nfc.scans(), oled.bytes, player.plays.size());
+
+  CHECK(host::serialContains("Recipe Name: Lasagna"));
+  CHECK(promptTime(PROMPTHEATING) != 0);
+  CHECK(promptTime(PROMPTFOODIN) > promptTime(PROMPTHEATING));
+  CHECK(promptTime(PROMPTCOOKING) > promptTime(PROMPTFOODIN));
+  CHECK(promptTime(PROMPTCOOLING) > promptTime(PROMPTCOOKING));
+  CHECK(promptTime(PROMPTFOODOUT) > promptTime(PROMPTCOOLING));
+  CHECK(asleep);
+  CHECK(!relayAtSleep);
+  // The last samples of the cook were closed into a frame rather than left waiting for more
+  CHECK(telemetry.filling() == 0 && telemetry.pending() > 0);
+  // The ring went dark, and the frame was all out before the clocks stopped
+  std::vector<uint8_t> ring;
+  CHECK(!ringBusyAtSleep);
+  CHECK(strip.decode(&ring) && ring.size() == RINGPIXELS * 3);
+  CHECK(std::all_of(ring.begin(), ring.end(), [](uint8_t b) { return b == 0; }));
+  // The food has to get to its core temperature, and the oven may not run away past the recipe
+  CHECK(toF(peakFood) >= 165);
+  CHECK(toF(peakOven) < 375 + 25);
+  // No single pass of loop() may hold up the heater control task
+  CHECK(maxPass < 250000);
+  // Starting a voice prompt doesn't hold loop() up, the way playClip()'s delay used to
+  CHECK(promptPass < 5000);
+  CHECK(wall < 1.0);
+  return host::finish("LasagnaCycleTest");
+}
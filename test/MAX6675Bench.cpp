@@ -0,0 +1,55 @@
+// Time to read one MAX6675 sample over hardware SPI at 1 and 4 MHz and bit-banged over GPIO, from
+// getReadTime(). The bit-banged loop is 50 GPIO calls and the hardware transfer 2 plus the clocks, so
+// both are given for a range of GPIO call costs: the host can't know what one costs on the Photon 2.
+// Virtual time, so these come out the same every run. Each includes a micros() read (1 us).
+#include "HostDevices.h"
+#include "MAX6675.h"
+
+namespace {
+
+const pin_t HWSELECT = D5;
+const pin_t SWCLOCK = D10, SWSELECT = D11, SWMISO = D12;
+const uint16_t FRAME = 401 << 3;      // 100.25 C
+const int READS = 100;
+
+// Mean us per read, 0 if a read came back wrong
+double readTime(MAX6675 &chip) {
+  uint64_t us = 0;
+
+  for(int i = 0; i < READS; i++) {
+    if(chip.read() != STATUS_OK || chip.getRawData() != FRAME) {
+      return 0;
+    }
+    us += chip.getReadTime();
+  }
+  return (double)us / READS;
+}
+
+}
+
+int main() {
+  FakeMAX6675 hwChip([]() { return FRAME; });
+  FakeMAX6675 swChip([]() { return FRAME; });
+  MAX6675 hw, sw;
+
+  host::attachSpi(HAL_SPI_INTERFACE1, HWSELECT, &hwChip);
+  host::attachSoftSpi(SWCLOCK, SWSELECT, SWMISO, &swChip);
+  hw.begin(HWSELECT);
+  sw.begin(SWCLOCK, SWSELECT, SWMISO);
+
+  for(unsigned gpioNs : {100, 250, 500, 1000}) {
+    host::setGpioCost(gpioNs);
+    hw.setSPIspeed(1000000);
+    double hw1 = readTime(hw);
+    hw.setSPIspeed(4000000);
+    double hw4 = readTime(hw);
+    double bitBanged = readTime(sw);
+
+    printf("MAX6675: %4u ns a GPIO call, hardware SPI %4.1f us at 1 MHz, %4.1f us at 4 MHz, bit-banged %4.1f us\n",
+           gpioNs, hw1, hw4, bitBanged);
+    if(hw1 == 0 || hw4 == 0 || bitBanged == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
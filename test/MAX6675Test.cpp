@@ -0,0 +1,79 @@
+// Reads one MAX6675 frame over hardware SPI and over bit-banged GPIO and gets the same temperature and
+// status either way, with getReadTime() matching what each transfer costs: 16 clocks at the SPI speed
+// against three GPIO calls a bit. A frame source times its call too rather than leaving the last SPI
+// time behind. The offset trims whatever the calibration table gives and is all that's left once the
+// table is cleared.
+#include "HostDevices.h"
+#include "HostTest.h"
+#include "MAX6675.h"
+
+namespace {
+
+const pin_t HWSELECT = D5;
+const pin_t SWCLOCK = D10, SWSELECT = D11, SWMISO = D12;
+const unsigned GPIOCOST = 500;        // ns per digitalWrite() or digitalRead()
+const uint16_t FRAME = 401 << 3;      // 100.25 C
+const uint16_t OPEN = FRAME | 0x04;   // Thermocouple input open
+
+uint16_t frame = FRAME;
+
+uint16_t slowSource() {
+  host::advance(40);
+  return FRAME;
+}
+
+bool near(float a, float b) {
+  return fabsf(a - b) < 0.01f;
+}
+
+}
+
+int main() {
+  FakeMAX6675 hwChip([]() { return frame; });
+  FakeMAX6675 swChip([]() { return frame; });
+  MAX6675 hw, sw;
+
+  host::attachSpi(HAL_SPI_INTERFACE1, HWSELECT, &hwChip);
+  host::attachSoftSpi(SWCLOCK, SWSELECT, SWMISO, &swChip);
+  host::setGpioCost(GPIOCOST);
+  hw.begin(HWSELECT);
+  sw.begin(SWCLOCK, SWSELECT, SWMISO);
+
+  // Same frame both ways
+  CHECK(hw.read() == STATUS_OK && sw.read() == STATUS_OK);
+  CHECK(hw.getRawData() == FRAME && sw.getRawData() == FRAME);
+  CHECK(near(hw.getTemperature(), 100.25f) && near(sw.getTemperature(), 100.25f));
+  frame = OPEN;
+  CHECK(hw.read() == STATUS_ERROR && sw.read() == STATUS_ERROR);
+  frame = FRAME;
+
+  // Hardware: select, 16 clocks at 1 MHz, deselect. Software: select, three calls a bit, deselect, and
+  // a 2 us delay a bit adds 32 us. Each also pays for its two micros() reads.
+  hw.read();
+  sw.read();
+  printf("MAX6675: hardware SPI %lu us, bit-banged %lu us at %u ns a GPIO call\n", hw.getReadTime(),
+         sw.getReadTime(), GPIOCOST);
+  CHECK(hw.getReadTime() >= 16 && hw.getReadTime() <= 16 + 3);
+  CHECK(sw.getReadTime() >= (2 + 16 * 3) * GPIOCOST / 1000 && sw.getReadTime() <= (2 + 16 * 3) * GPIOCOST / 1000 + 3);
+  uint32_t undelayed = sw.getReadTime();
+  sw.setSWSPIdelay(2);
+  CHECK(sw.read() == STATUS_OK && sw.getRawData() == FRAME);
+  CHECK(sw.getReadTime() >= undelayed + 31 && sw.getReadTime() <= undelayed + 33);
+
+  // A frame source's own time, not the last SPI transfer's
+  hw.setFrameSource(slowSource);
+  CHECK(hw.read() == STATUS_OK && near(hw.getTemperature(), 100.25f));
+  CHECK(hw.getReadTime() >= 40 && hw.getReadTime() <= 42);
+  hw.setFrameSource(NULL);
+
+  // The offset on its own, then on top of a table that reads 10% high, then on its own again
+  const float measured[] = {0, 100}, actual[] = {0, 110};
+  hw.read();
+  hw.setOffset(-2);
+  CHECK(near(hw.getTemperature(), 98.25f));
+  CHECK(hw.setCalibration(measured, actual, 2));
+  CHECK(near(hw.getTemperature(), 110.275f - 2));
+  CHECK(hw.setCalibration(measured, actual, 0));
+  CHECK(near(hw.getTemperature(), 98.25f));
+  return host::finish("MAX6675Test");
+}
@@ -0,0 +1,139 @@
+// Incoming MQTT throughput: messages a second through readFullPacket() and dispatchPackets() to a
+// subscription callback, for 8, 64 and 400 byte payloads, the broker queueing 8 at a time. Wall time
+// and the fake broker's share is in it, so only the comparison between sizes means much.
+// Then QoS 1 publishes a second and p99 publish to PUBACK latency, one at a time waiting on each
+// PUBACK and through publish windows of 1, 4 and 8 batched once a millisecond, against a broker 20 to
+// 50 ms away. Virtual time and a seeded jitter, so these come out the same every run.
+#include "HostDevices.h"
+#include "Adafruit_MQTT_SPARK.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <random>
+
+namespace {
+
+const int MESSAGES = 200000;
+const int BURST = 8;
+const char *TOPIC = "user/feeds/smartcooker";
+const char *STATUSFEED = "user/feeds/smartcookerstatus";
+const int PUBLISHES = 2000;
+const unsigned BROKERLATENCY = 20000;  // us
+const unsigned JITTER = 30000;         // us, on top of BROKERLATENCY
+const uint64_t POLL = 1000;            // us between windowed passes
+
+FakeMqttBroker broker;
+TCPClient client;
+Adafruit_MQTT_SPARK mqtt(&client, "io.adafruit.com", 1883, "user", "key");
+Adafruit_MQTT_Subscribe remote(&mqtt, TOPIC);
+unsigned received;
+size_t receivedBytes;
+
+void onMessage(char *payload, uint16_t length) {
+  (void)payload;
+  received++;
+  receivedBytes += length;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct publishRate {
+  double perSecond;
+  double p99ms;
+};
+
+// Sends PUBLISHES QoS 1 publishes, window 0 blocking on each PUBACK, and times each to its PUBACK
+publishRate publishes(uint8_t window) {
+  Adafruit_MQTT_Publish status(&mqtt, STATUSFEED, MQTT_QOS_1);
+  std::deque<uint64_t> sentAt;
+  std::vector<uint64_t> latencies;
+  std::mt19937 rng(14);
+  uint32_t acked = mqtt.acked();
+  uint64_t start = host::now();
+  int sent = 0;
+
+  mqtt.setPublishWindow(window);
+  while(latencies.size() < (size_t)PUBLISHES && mqtt.connected()) {
+    broker.latency = BROKERLATENCY + rng() % JITTER;
+    if(window == 0) {
+      uint64_t at = host::now();
+      if(!status.publish("72.5")) {
+        break;
+      }
+      latencies.push_back(host::now() - at);
+      continue;
+    }
+    // PUBACKs come back in the order the publishes went out
+    mqtt.dispatchPackets();
+    for(; mqtt.acked() > acked; acked++) {
+      latencies.push_back(host::now() - sentAt.front());
+      sentAt.pop_front();
+    }
+    mqtt.beginBatch();
+    while(sent < PUBLISHES && mqtt.inflight() < window) {
+      sentAt.push_back(host::now());
+      if(!status.publish("72.5")) {
+        sentAt.pop_back();
+        break;
+      }
+      sent++;
+    }
+    mqtt.endBatch();
+    host::advance(POLL);
+  }
+  if(latencies.size() < (size_t)PUBLISHES) {
+    return {0, 0};
+  }
+  double seconds = (host::now() - start) / 1e6;
+  std::sort(latencies.begin(), latencies.end());
+  return {PUBLISHES / seconds, latencies[PUBLISHES * 99 / 100] / 1000.0};
+}
+
+}
+
+int main() {
+  remote.setCallback(onMessage);
+  mqtt.subscribe(&remote);
+  host::attachTcp(&broker);
+  broker.latency = 0;
+  for(int i = 0; i < 1000 && !mqtt.Update(); i++) {
+    host::advance(100000);
+  }
+  if(mqtt.getState() != MQTT_STATE_CONNECTED) {
+    printf("MQTT: never connected\n");
+    return 1;
+  }
+
+  for(size_t size : {8, 64, 400}) {
+    std::string payload(size, 'p');
+
+    received = 0;
+    receivedBytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(int sent = 0; sent < MESSAGES; sent += BURST) {
+      for(int i = 0; i < BURST; i++) {
+        broker.publish(TOPIC, payload);
+      }
+      while(mqtt.dispatchPackets() > 0);
+    }
+    double seconds = secondsSince(start);
+    printf("MQTT: %3zu byte payloads, %.2f M messages/s, %.1f MB/s of payload (%u of %d received)\n", size,
+           received / seconds / 1e6, receivedBytes / seconds / 1e6, received, MESSAGES);
+    if(received != (unsigned)MESSAGES || receivedBytes != MESSAGES * size) {
+      return 1;
+    }
+  }
+
+  for(uint8_t window : {0, 1, 4, 8}) {
+    publishRate rate = publishes(window);
+    printf("MQTT: QoS 1 %-13s %6.1f publishes/s, p99 latency %5.1f ms\n",
+           window == 0 ? "blocking," : ("window " + std::to_string(window) + ",").c_str(), rate.perSecond,
+           rate.p99ms);
+    if(rate.perSecond == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,184 @@
+// Feeds readFullPacket() malformed packets from the fake broker: remaining lengths that run past four
+// bytes or stop part way, bodies cut short at every byte, topics and packet ids that run past the
+// packet, packets bigger than the buffer, and thousands of random mutations of a good PUBLISH. A
+// packet that can't be framed drops the connection, one that frames but makes no sense is ignored,
+// and either way no garbage reaches a callback and the next good message arrives whole.
+#include "HostDevices.h"
+#include "HostTest.h"
+#include "Adafruit_MQTT_SPARK.h"
+#include <random>
+
+namespace {
+
+const uint64_t TASKPERIOD = 100000;   // us, NETWORKPERIOD
+const uint8_t PUBACK = 4;
+const char *TOPIC = "user/feeds/smartcooker";
+
+FakeMqttBroker broker;
+TCPClient client;
+Adafruit_MQTT_SPARK mqtt(&client, "io.adafruit.com", 1883, "user", "key");
+Adafruit_MQTT_Subscribe remote(&mqtt, TOPIC);
+std::vector<std::string> messages;
+
+void onMessage(char *payload, uint16_t length) {
+  messages.push_back(std::string(payload, length));
+}
+
+void pass() {
+  uint64_t start = host::now();
+
+  if(mqtt.Update()) {
+    mqtt.dispatchPackets();
+  }
+  host::advance(TASKPERIOD - min(TASKPERIOD, host::now() - start));
+}
+
+void run(uint64_t ms) {
+  for(uint64_t i = 0; i < ms * 1000 / TASKPERIOD; i++) {
+    pass();
+  }
+}
+
+bool reconnect() {
+  for(int i = 0; i < 1000 && !mqtt.Update(); i++) {
+    pass();
+  }
+  return mqtt.getState() == MQTT_STATE_CONNECTED;
+}
+
+// A PUBLISH to topic with the remaining length encoded the way MQTT does
+std::vector<uint8_t> publish(const std::string &topic, const std::string &payload, uint8_t flags = 0) {
+  size_t length = 2 + topic.size() + ((flags & 0x06) ? 2 : 0) + payload.size();
+  std::vector<uint8_t> p = {(uint8_t)(0x30 | flags)};
+
+  do {
+    p.push_back((length & 0x7F) | (length > 0x7F ? 0x80 : 0));
+    length >>= 7;
+  } while(length > 0);
+  p.push_back(topic.size() >> 8);
+  p.push_back(topic.size() & 0xFF);
+  p.insert(p.end(), topic.begin(), topic.end());
+  if(flags & 0x06) {
+    p.insert(p.end(), {0x12, 0x34});
+  }
+  p.insert(p.end(), payload.begin(), payload.end());
+  return p;
+}
+
+// Sends bytes, lets the client chew on them for a second, and reports whether it kept the connection
+// and what reached the callback. A good message afterwards, over a new connection if need be, must
+// arrive whole.
+struct outcome {
+  bool kept;
+  std::vector<std::string> messages;
+  bool framed;
+};
+
+outcome feed(const std::vector<uint8_t> &bytes) {
+  outcome result;
+  uint16_t failures = mqtt.getFailures();
+
+  messages.clear();
+  broker.inject(bytes);
+  run(1000);
+  result.kept = mqtt.getFailures() == failures;
+  result.messages = messages;
+  messages.clear();
+  reconnect();
+  broker.publish(TOPIC, "ok");
+  run(300);
+  result.framed = messages.size() == 1 && messages[0] == "ok";
+  return result;
+}
+
+bool dropped(const std::vector<uint8_t> &bytes) {
+  outcome result = feed(bytes);
+  return !result.kept && result.messages.empty() && result.framed;
+}
+
+bool ignored(const std::vector<uint8_t> &bytes) {
+  outcome result = feed(bytes);
+  return result.kept && result.messages.empty() && result.framed;
+}
+
+}
+
+int main() {
+  std::mt19937_64 rng(13);
+  std::vector<uint8_t> good = publish(TOPIC, "42");
+  outcome result;
+  bool all;
+
+  remote.setCallback(onMessage);
+  mqtt.subscribe(&remote);
+  host::attachTcp(&broker);
+  broker.latency = 0;
+  CHECK(reconnect());
+
+  // Remaining lengths: five bytes, stopping after a continuation bit, and the largest there is with
+  // nothing behind it
+  CHECK(dropped({0x30, 0xFF, 0xFF, 0xFF, 0xFF, 0x7F}));
+  CHECK(dropped({0x30, 0x80}));
+  CHECK(dropped({0x30, 0xFF, 0xFF, 0xFF, 0x7F, 'x'}));
+
+  // Cut short after every byte of a good PUBLISH
+  all = true;
+  for(size_t n = 1; n < good.size(); n++) {
+    all = dropped(std::vector<uint8_t>(good.begin(), good.begin() + n)) && all;
+  }
+  CHECK(all);
+
+  // Framed but nonsense: empty, a topic longer than the packet, QoS 1 without room for its packet id
+  // (and not acknowledged with whatever the buffer held), and packets the client doesn't expect
+  unsigned pubacks = broker.packets[PUBACK];
+  CHECK(ignored({0x30, 0x00}));
+  CHECK(ignored({0x30, 0x04, 0x00, 0x40, 'u', 's'}));
+  std::vector<uint8_t> noId = publish(TOPIC, "", 0x02);
+  noId[1] -= 2;
+  noId.resize(noId.size() - 2);
+  CHECK(ignored(noId));
+  CHECK(broker.packets[PUBACK] == pubacks);
+  CHECK(ignored({0xF0, 0x00}));
+  CHECK(ignored({0x00, 0x00}));
+  CHECK(ignored({0x40, 0x03, 0x00, 0x01, 0x02}));
+  CHECK(ignored({0x90, 0x03, 0x00, 0x01, 0x00}));
+
+  // The biggest PUBLISH the buffer holds arrives whole, a bigger one is cut to fit and the rest
+  // skipped, the stream stays framed either way
+  size_t largest = MAXBUFFERSIZE - 1 - 3 - 2 - strlen(TOPIC);
+  result = feed(publish(TOPIC, std::string(largest, 'a')));
+  CHECK(result.kept && result.framed && result.messages.size() == 1 && result.messages[0].size() == largest);
+  result = feed(publish(TOPIC, std::string(largest - 1, 'b') + std::string(1000, 'c')));
+  CHECK(result.kept && result.framed && result.messages.size() == 1);
+  CHECK(result.messages[0] == std::string(largest - 1, 'b') + "c");
+
+  // Random damage to a good PUBLISH: bytes flipped, cut short, garbage after it. Whatever happens
+  // the client comes back and the next message gets through.
+  int kept = 0, lost = 0;
+  all = true;
+  for(int i = 0; i < 2000; i++) {
+    std::vector<uint8_t> bytes = publish(TOPIC, std::string(rng() % 40, 'x'), rng() % 2 ? 0x02 : 0);
+    int damage = rng() % 3;
+    if(damage == 0 || bytes.size() < 4) {
+      for(int flips = 1 + rng() % 3; flips > 0; flips--) {
+        bytes[rng() % bytes.size()] ^= 1 << (rng() % 8);
+      }
+    }
+    else if(damage == 1) {
+      bytes.resize(1 + rng() % (bytes.size() - 1));
+    }
+    else {
+      for(int extra = 1 + rng() % 8; extra > 0; extra--) {
+        bytes.push_back(rng());
+      }
+    }
+    result = feed(bytes);
+    kept += result.kept;
+    lost += !result.kept;
+    all = result.framed && all;
+  }
+  printf("MqttFuzz: 2000 mutated packets, %d read with the connection kept, %d dropped it\n", kept, lost);
+  CHECK(all);
+  CHECK(reconnect());
+  return host::finish("MqttFuzzTest");
+}
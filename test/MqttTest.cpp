@@ -0,0 +1,182 @@
+// Drives the MQTT connection manager the way the network task does, every 100 ms, against a fake
+// broker behind a slow DNS lookup and a slow TCP connect. No call may hold up the loop while the
+// lookup and connect run, the address is looked up once, messages the broker sends ahead of the
+// SUBACK reach their callback, the keepalive ping finds a dead broker, a 10 minute outage only costs
+// reconnect attempts, a packet cut short drops the connection instead of desyncing the stream, a
+// publish that can't be written fails and is counted, and one too big for the publish window is
+// refused without blocking.
+#include "HostDevices.h"
+#include "HostTest.h"
+#include "Adafruit_MQTT_SPARK.h"
+
+namespace {
+
+const uint64_t TASKPERIOD = 100000;   // us, NETWORKPERIOD
+const unsigned RESOLVETIME = 2000;    // ms
+const unsigned CONNECTTIME = 5000;    // ms
+const uint64_t TASKLIMIT = 50000;     // us, longest a network pass may take
+const uint8_t PINGREQ = 12;
+const uint8_t PUBLISH = 3;
+
+FakeMqttBroker broker;
+TCPClient client;
+Adafruit_MQTT_SPARK mqtt(&client, "io.adafruit.com", 1883, "user", "key");
+Adafruit_MQTT_Subscribe remote(&mqtt, "user/feeds/smartcooker");
+std::vector<uint32_t> commands;
+uint64_t longestPass;
+
+void onCommand(uint32_t value) {
+  commands.push_back(value);
+}
+
+// One network task pass, then idle to the next one
+bool pass() {
+  uint64_t start = host::now();
+  bool connected = mqtt.Update();
+
+  if(connected) {
+    mqtt.dispatchPackets();
+  }
+  longestPass = max(longestPass, host::now() - start);
+  host::advance(TASKPERIOD - min(TASKPERIOD, host::now() - start));
+  return connected;
+}
+
+// Runs passes for up to ms, until connected if untilConnected. Returns the ms it took.
+uint64_t run(uint64_t ms, bool untilConnected) {
+  uint64_t start = host::now();
+
+  while(host::now() - start < ms * 1000) {
+    if(pass() && untilConnected) {
+      break;
+    }
+  }
+  return (host::now() - start) / 1000;
+}
+
+}
+
+int main() {
+  uint64_t took;
+  uint16_t failures;
+  unsigned connects, pings;
+
+  remote.setCallback(onCommand);
+  mqtt.subscribe(&remote);
+  host::attachTcp(&broker);
+  host::setNetworkDelays(RESOLVETIME, CONNECTTIME);
+  broker.early = {"42"};
+
+  // First connect, the lookup and the connect run while the loop keeps going
+  longestPass = 0;
+  took = run(30000, true);
+  printf("MQTT: connected in %llu ms, longest pass %.1f ms\n", (unsigned long long)took, longestPass / 1000.0);
+  CHECK(mqtt.getState() == MQTT_STATE_CONNECTED);
+  CHECK(took >= RESOLVETIME + CONNECTTIME);
+  CHECK(longestPass < TASKLIMIT);
+  // Published before the SUBACK and held until connected rather than dropped
+  CHECK(commands.size() == 1 && commands[0] == 42);
+  CHECK(mqtt.getFailures() == 0);
+
+  // The broker drops the connection, the reconnect skips the lookup
+  broker.early.clear();
+  broker.drop();
+  longestPass = 0;
+  took = run(MQTT_BACKOFF_MAX_MS, true);
+  printf("  reconnect in %llu ms, %lu ms resolving since boot\n", (unsigned long long)took,
+         (unsigned long)mqtt.getStateTime(MQTT_STATE_RESOLVE));
+  CHECK(mqtt.getState() == MQTT_STATE_CONNECTED);
+  CHECK(mqtt.getStateTime(MQTT_STATE_RESOLVE) < 2 * RESOLVETIME);
+  CHECK(longestPass < TASKLIMIT);
+  CHECK(mqtt.getFailures() == 1);
+
+  // Keepalive, answered pings keep the connection
+  pings = broker.packets[PINGREQ];
+  connects = broker.connects;
+  run(3 * MQTT_PING_INTERVAL_MS, false);
+  printf("  %u pings in %d s\n", broker.packets[PINGREQ] - pings, 3 * MQTT_PING_INTERVAL_MS / 1000);
+  CHECK(broker.packets[PINGREQ] - pings >= 2);
+  CHECK(broker.connects == connects);
+  CHECK(mqtt.getFailures() == 1);
+
+  // A broker that stops answering is found by the next ping and the connection is made again
+  broker.answerPings = false;
+  run(MQTT_PING_INTERVAL_MS + MQTT_PINGRESP_TIMEOUT_MS + 1000, false);
+  CHECK(mqtt.getFailures() == 2);
+  broker.answerPings = true;
+  run(MQTT_BACKOFF_MAX_MS, true);
+  CHECK(mqtt.getState() == MQTT_STATE_CONNECTED);
+  CHECK(broker.connects == connects + 1);
+
+  // Ten minute outage, the loop keeps its cadence and the client keeps trying at the backoff pace
+  failures = mqtt.getFailures();
+  broker.up = false;
+  broker.drop();
+  longestPass = 0;
+  run(10 * 60 * 1000, false);
+  printf("  10 min outage: %u failed attempts, longest pass %.1f ms\n", mqtt.getFailures() - failures,
+         longestPass / 1000.0);
+  CHECK(mqtt.getState() != MQTT_STATE_CONNECTED);
+  CHECK(mqtt.getFailures() - failures >= 8);
+  CHECK(mqtt.getFailures() - failures <= 10 * 60 * 2000 / MQTT_BACKOFF_MAX_MS + 8);
+  CHECK(longestPass < TASKLIMIT);
+
+  // Back up, connected within one backoff window and the lookup and connect
+  broker.up = true;
+  took = run(MQTT_BACKOFF_MAX_MS + RESOLVETIME + CONNECTTIME + 1000, true);
+  printf("  back in %llu ms after the broker came up\n", (unsigned long long)took);
+  CHECK(mqtt.getState() == MQTT_STATE_CONNECTED);
+  CHECK(longestPass < TASKLIMIT);
+
+  // A message while connected still goes straight through
+  broker.publish("user/feeds/smartcooker", "7");
+  run(1000, false);
+  CHECK(commands.size() == 2 && commands[1] == 7);
+  CHECK(broker.packets[PUBLISH] == 0);
+
+  // A PUBLISH that claims 32 bytes and stops after 3 can't be read past, the connection goes
+  failures = mqtt.getFailures();
+  connects = broker.connects;
+  broker.inject({0x30, 0x20, 0x00, 0x16, 'u'});
+  run(1000, false);
+  CHECK(mqtt.getFailures() == failures + 1);
+  CHECK(commands.size() == 2);
+  run(MQTT_BACKOFF_MAX_MS, true);
+  CHECK(mqtt.getState() == MQTT_STATE_CONNECTED);
+  CHECK(broker.connects == connects + 1);
+
+  // A windowed publish that can't be written says so, is counted, and isn't kept for a resend
+  Adafruit_MQTT_Publish status(&mqtt, "user/feeds/smartcookerstatus", MQTT_QOS_1);
+  mqtt.setPublishWindow(4);
+  CHECK(status.publish("ready"));
+  run(1000, false);
+  CHECK(mqtt.acked() == 1 && mqtt.inflight() == 0);
+  failures = mqtt.getFailures();
+  broker.drop();
+  CHECK(!status.publish("cooking"));
+  CHECK(mqtt.getWriteFailures() == 1);
+  CHECK(mqtt.getFailures() == failures + 1);
+  CHECK(mqtt.inflight() == 0);
+  mqtt.beginBatch();
+  CHECK(status.publish("cooking"));
+  CHECK(!mqtt.endBatch());
+  CHECK(mqtt.getWriteFailures() == 2);
+
+  // One too big to keep for a resend is refused on the spot instead of waiting out a PUBACK, and
+  // the rest of the batch goes out as usual
+  run(MQTT_BACKOFF_MAX_MS, true);
+  CHECK(mqtt.getState() == MQTT_STATE_CONNECTED);
+  run(1000, false);
+  CHECK(mqtt.inflight() == 0);
+  unsigned publishes = broker.received.size();
+  mqtt.beginBatch();
+  uint64_t start = host::now();
+  CHECK(!status.publish(std::string(MQTT_INFLIGHT_PACKETSIZE, 'x').c_str()));
+  CHECK(host::now() - start < 1000);
+  CHECK(status.publish("done"));
+  CHECK(mqtt.endBatch());
+  run(1000, false);
+  CHECK(broker.received.size() == publishes + 1 && broker.received.back().payload == "done");
+  CHECK(mqtt.inflight() == 0);
+  return host::finish("MqttTest");
+}
@@ -0,0 +1,159 @@
+// The NeoPixel ring on SPI1, in two parts.
+// Bytes on the wire per status change for a 12 LED ring: the old pixelFill(), which called show()
+// after each setPixelColor(), against fill() and one show(), including a change to the colour the
+// ring already shows. From the strip's frame counters, with the time the frames take on the wire at
+// 3.125 MHz.
+// Encode throughput per LED: the old branching bit encoder against the nibble lookup table the
+// driver uses, both checked against the bitstream the driver sends, then whole show() calls with
+// every byte changed for strips of 12 to 1024 LEDs. Wall time, and show() includes the host SPI stub
+// copying the frame, so only the comparisons mean much.
+#include "neopixel.h"
+#include "HostDevices.h"
+#include <chrono>
+
+namespace {
+
+const int RINGPIXELS = 12;          // PIXELCOUNT
+const size_t RESETBYTES = 120;      // 300 us of zeros on each end at 3.125 MHz
+const int ENCODELEDS = 1 << 18;
+const int SHOWBYTES = 1 << 24;      // Pixel bytes encoded per strip length
+
+// The encoder before the lookup table, a branch per bit
+void branchEncode(uint8_t *out, uint8_t p) {
+  const uint8_t PIX_HI = 6, PIX_LO = 4;
+
+  out[0] = ((0x80 & p) ? (PIX_HI << 5) : (PIX_LO << 5)) + ((0x40 & p) ? (PIX_HI << 2) : (PIX_LO << 2)) +
+           ((0x20 & p) ? 3 : 2);
+  out[1] = ((0x10 & p) ? (PIX_HI << 4) : (PIX_LO << 4)) + ((0x08 & p) ? (PIX_HI << 1) : (PIX_LO << 1)) + 1;
+  out[2] = ((0x04 & p) ? (2 << 6) : 0) + ((0x02 & p) ? (PIX_HI << 3) : (PIX_LO << 3)) + ((0x01 & p) ? PIX_HI : PIX_LO);
+}
+
+// The driver's lookup table, a nibble at a time
+const uint16_t nibbleBits[16] = {
+  0x924, 0x926, 0x934, 0x936, 0x9A4, 0x9A6, 0x9B4, 0x9B6,
+  0xD24, 0xD26, 0xD34, 0xD36, 0xDA4, 0xDA6, 0xDB4, 0xDB6
+};
+
+void tableEncode(uint8_t *out, uint8_t v) {
+  uint32_t bits = ((uint32_t)nibbleBits[v >> 4] << 12) | nibbleBits[v & 0x0F];
+  out[0] = bits >> 16;
+  out[1] = bits >> 8;
+  out[2] = bits;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Waits out the DMA the way the next show() would, returns the us it took
+uint64_t drain(const Adafruit_NeoPixel &pixels) {
+  uint64_t start = host::now();
+
+  while(!pixels.canShow()) {
+    host::advance(1);
+  }
+  return host::now() - start;
+}
+
+struct change {
+  uint32_t frames, bytes;
+  uint64_t us;
+};
+
+// One status change to color, through a show() per pixel or fill() and one show()
+change statusChange(Adafruit_NeoPixel &pixels, uint32_t color, bool perPixel) {
+  uint32_t frames = pixels.getFramesSent(), bytes = pixels.getBytesSent();
+  uint64_t us = 0;
+
+  if(perPixel) {
+    for(int i = 0; i < RINGPIXELS; i++) {
+      pixels.setPixelColor(i, color);
+      pixels.show();
+      us += drain(pixels);
+    }
+  }
+  else {
+    pixels.fill(color);
+    pixels.show();
+    us += drain(pixels);
+  }
+  return {pixels.getFramesSent() - frames, pixels.getBytesSent() - bytes, us};
+}
+
+// ns per LED encoding n LEDs (3 bytes each) with encode
+template <typename Encode> double encodeNs(Encode encode, const uint8_t *pixels, uint8_t *out) {
+  auto start = std::chrono::steady_clock::now();
+  for(int i = 0; i < ENCODELEDS * 3; i++) {
+    encode(out + i * 3, pixels[i]);
+  }
+  return secondsSince(start) * 1e9 / ENCODELEDS;
+}
+
+}
+
+int main() {
+  FakeNeoPixelStrip strip;
+  const uint32_t statuses[] = {0x00FF00, 0xFF0000, 0xFF8000, 0x0000FF, 0x0000FF, 0x000000};
+  const char *names[] = {"ready", "heating", "cooking", "cooling", "cooling again", "off"};
+
+  host::attachSpi(HAL_SPI_INTERFACE2, PIN_INVALID, &strip);
+  for(bool perPixel : {true, false}) {
+    Adafruit_NeoPixel pixels(RINGPIXELS, SPI1, WS2812B);
+    pixels.begin();
+    for(size_t s = 0; s < sizeof(statuses) / sizeof(statuses[0]); s++) {
+      change c = statusChange(pixels, statuses[s], perPixel);
+      printf("NeoPixel: %-14s %-13s %2u frames, %5u bytes, %5.2f ms on the wire\n",
+             perPixel ? "show per pixel" : "one frame", names[s], c.frames, c.bytes, c.us / 1000.0);
+      if(!perPixel && c.frames != (s == 4 ? 0u : 1u)) {
+        return 1;
+      }
+    }
+  }
+
+  // Both encoders, every byte value, against what the driver put on the wire
+  Adafruit_NeoPixel all(86, SPI1, WS2812B);
+  all.begin();
+  for(int i = 0; i < 86 * 3; i++) {
+    all.getPixels()[i] = i;
+  }
+  all.show();
+  drain(all);
+  for(int v = 0; v < 256; v++) {
+    uint8_t branch[3], table[3];
+    branchEncode(branch, v);
+    tableEncode(table, v);
+    if(memcmp(branch, table, 3) != 0 || memcmp(table, &strip.lastFrame[RESETBYTES + v * 3], 3) != 0) {
+      printf("NeoPixel: encoders disagree on %d\n", v);
+      return 1;
+    }
+  }
+
+  std::vector<uint8_t> pixels(ENCODELEDS * 3), out(ENCODELEDS * 9);
+  for(size_t i = 0; i < pixels.size(); i++) {
+    pixels[i] = i * 37;
+  }
+  double branch = encodeNs(branchEncode, pixels.data(), out.data());
+  double table = encodeNs(tableEncode, pixels.data(), out.data());
+  printf("NeoPixel: encode %.2f ns per LED branching, %.2f ns with the nibble table (%.1fx), check %u\n", branch,
+         table, branch / table, out[12345]);
+
+  for(int leds : {12, 144, 300, 1024}) {
+    Adafruit_NeoPixel chain(leds, SPI1, WS2812B);
+    int frames = SHOWBYTES / (leds * 3);
+    // Straight to the end of the frame rather than a microsecond at a time
+    uint64_t frameUs = (leds * 9 + 2 * RESETBYTES) * 8 * 1000000ULL / host::getSpiClock(HAL_SPI_INTERFACE2);
+
+    chain.begin();
+    auto start = std::chrono::steady_clock::now();
+    for(int f = 0; f < frames; f++) {
+      memset(chain.getPixels(), f & 1 ? 0x5A : 0xA5, leds * 3);
+      chain.show();
+      host::advance(frameUs);
+      drain(chain);
+    }
+    double seconds = secondsSince(start);
+    printf("NeoPixel: show() with every LED changed, %4d LEDs, %.2f ns per LED\n", leds,
+           seconds * 1e9 / ((double)frames * leds));
+  }
+  return 0;
+}
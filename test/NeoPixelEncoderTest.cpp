@@ -0,0 +1,100 @@
+// Sends frames through the NeoPixel driver on SPI1 and decodes the bitstream that reaches the strip:
+// every byte value encodes to its WS2812B bits, a frame that changes a few pixels re-encodes just
+// those and still decodes whole, an unchanged frame isn't sent, and show() hands the frame to the DMA
+// and returns with the strip busy until the last bit is out.
+#include "neopixel.h"
+#include "HostDevices.h"
+#include "HostTest.h"
+#include <algorithm>
+
+namespace {
+
+const int LEDS = 86;                 // 258 bytes, every byte value fits
+const size_t RESETBYTES = 120;       // 300 us of zeros on each end at 3.125 MHz
+
+FakeNeoPixelStrip strip;
+
+bool sent(const Adafruit_NeoPixel &pixels) {
+  std::vector<uint8_t> bytes;
+
+  return strip.decode(&bytes) && bytes.size() == pixels.numPixels() * 3u &&
+         std::equal(bytes.begin(), bytes.end(), pixels.getPixels());
+}
+
+// Waits out the DMA the way the next show() would, a microsecond at a time
+uint64_t drain(const Adafruit_NeoPixel &pixels) {
+  uint64_t start = host::now();
+
+  while(!pixels.canShow()) {
+    host::advance(1);
+  }
+  return host::now() - start;
+}
+
+}
+
+int main() {
+  Adafruit_NeoPixel pixels(LEDS, SPI1, WS2812B);
+  uint8_t *raw;
+  uint64_t took, frameTime;
+
+  host::attachSpi(HAL_SPI_INTERFACE2, PIN_INVALID, &strip);
+  pixels.begin();
+  raw = pixels.getPixels();
+
+  // Every byte value, written straight into the buffer
+  for(int i = 0; i < LEDS * 3; i++) {
+    raw[i] = i;
+  }
+  pixels.show();
+  CHECK(strip.frames == 1);
+  CHECK(strip.lastFrame.size() == LEDS * 9 + 2 * RESETBYTES);
+  CHECK(sent(pixels));
+  CHECK(pixels.getBytesSent() == strip.lastFrame.size());
+
+  // show() returned with the frame still going out, it takes as long as its bits do
+  CHECK(!pixels.canShow());
+  took = drain(pixels);
+  frameTime = strip.lastFrame.size() * 8 * 1000000ULL / host::getSpiClock(HAL_SPI_INTERFACE2);
+  printf("NeoPixelEncoder: %zu byte frame, %.2f ms on the wire at %u Hz\n", strip.lastFrame.size(), took / 1000.0,
+         host::getSpiClock(HAL_SPI_INTERFACE2));
+  CHECK(took > 0 && took <= frameTime + 1);
+
+  // A few pixels changed through setPixelColor, only they are encoded again and the frame still
+  // decodes to the whole buffer
+  pixels.setPixelColor(0, 255, 0, 0);
+  pixels.setPixelColor(LEDS / 2, 0, 255, 0);
+  pixels.setPixelColor(LEDS - 1, 0, 0, 0);
+  pixels.show();
+  CHECK(strip.frames == 2);
+  CHECK(raw[0] == 0 && raw[1] == 255 && raw[2] == 0);
+  CHECK(sent(pixels));
+  drain(pixels);
+
+  // Brightness scales what goes out
+  pixels.setBrightness(64);
+  pixels.setPixelColor(1, 200, 100, 40);
+  pixels.show();
+  CHECK(raw[3] == 25 && raw[4] == 50 && raw[5] == 10);
+  CHECK(sent(pixels));
+  drain(pixels);
+
+  // The same frame again never reaches the strip
+  pixels.show();
+  CHECK(strip.frames == 3);
+  CHECK(pixels.getFramesSkipped() == 1);
+  CHECK(pixels.canShow());
+
+  // Setting a pixel to the colour it already has leaves the same frame
+  pixels.setPixelColor(1, 200, 100, 40);
+  pixels.show();
+  CHECK(strip.frames == 3);
+
+  // All off, every zero byte still goes out as 100 bits and decodes
+  pixels.clear();
+  pixels.show();
+  CHECK(sent(pixels));
+  CHECK(strip.frames == 4 && pixels.getFramesSent() == 4);
+  drain(pixels);
+  return host::finish("NeoPixelEncoderTest");
+}
@@ -0,0 +1,131 @@
+// Reads through the DFRobot PN532 driver against the fake reader: the response frames have to fit
+// what each command reads back, a 7 byte UID and a full 16 byte READ included. A legacy card read
+// block by block and in one session is timed with the driver's counters, then read again with the
+// reader signalling each frame on its IRQ line instead of being polled.
+#include "DFRobot_PN532.h"
+#include "HostDevices.h"
+#include "HostTest.h"
+
+namespace {
+
+const pin_t IRQPIN = 2;              // PN532_IRQ
+
+struct swipe {
+  uint64_t us;
+  unsigned requests;
+  DFRobot_PN532::sTiming_t timing;
+};
+
+// What nfcRead() does with a legacy card: block 4, then the name and temperature in blocks 1 and 2
+bool readLegacy(DFRobot_PN532_IIC &reader, FakePN532 &card, uint8_t *blocks, swipe *measured) {
+  uint64_t start = host::now();
+  unsigned requests = card.requests();
+  bool ok;
+
+  reader.resetTiming();
+  ok = reader.beginSession() && reader.readBlocks(blocks, 4, 1) && reader.readBlocks(blocks + 16, 1, 2);
+  reader.endSession();
+  measured->us = host::now() - start;
+  measured->requests = card.requests() - requests;
+  measured->timing = reader.getTiming();
+  return ok;
+}
+
+}
+
+int main() {
+  const uint8_t sevenByteUid[7] = {0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+  uint8_t block[16], page[4], blocks[48];
+  FakePN532 card;
+  DFRobot_PN532_IIC reader(2, 0);
+
+  for(int i = 0; i < 16; i++) {
+    block[i] = 0xA0 + i;
+  }
+  card.writeBlock(4, block);
+  card.writeBlock(5, block);
+  card.writeBlock(6, block);
+  host::attachI2C(0x24, &card);
+  CHECK(reader.begin());
+
+  // No card on the reader
+  CHECK(!reader.scan());
+
+  // MIFARE Classic 1k, 4 byte UID, authenticated reads
+  card.setCard(true);
+  CHECK(reader.scan());
+  CHECK(reader.nfcUid[0] == 0xDE && reader.nfcUid[3] == 0xEF);
+  CHECK(reader.readData(4, 16) == 0xAF);
+  CHECK(reader.beginSession());
+  memset(blocks, 0, sizeof(blocks));
+  CHECK(reader.readBlocks(blocks, 4, 3));
+  CHECK(memcmp(blocks + 32, block, 16) == 0);
+  reader.endSession();
+  DFRobot_PN532::sCard_t info = reader.getInformation();
+  CHECK(info.uidlenght == 4);
+  CHECK(memcmp(info.uid, "\xDE\xAD\xBE\xEF", 4) == 0);
+
+  // Ultralight, 7 byte UID: the InListPassiveTarget reply and the 16 byte READ reply are the
+  // longest frames these commands return
+  card.setUid(sevenByteUid, sizeof(sevenByteUid));
+  CHECK(reader.scan());
+  CHECK(memcmp(reader.nfcUid, sevenByteUid, 4) == 0);
+  CHECK(reader.readUltralight(page, 4) == 1);
+  CHECK(memcmp(page, block, 4) == 0);
+  info = reader.getInformation();
+  CHECK(memcmp(info.uid, sevenByteUid, 7) == 0);
+
+  card.setCard(false);
+  CHECK(!reader.scan());
+  CHECK(reader.readUltralight(page, 4) != 1);
+
+  // A legacy card the old way, a select and an authentication for every block, against one session
+  const uint8_t classicUid[4] = {0xDE, 0xAD, 0xBE, 0xEF};
+  uint8_t perBlock[48];
+  swipe polled, irq;
+  card.setUid(classicUid, sizeof(classicUid));
+  card.setCard(true);
+  for(int i = 0; i < 16; i++) {
+    block[i] = 0x30 + i;
+  }
+  card.writeBlock(1, block);
+  card.writeBlock(2, block + 1);
+  uint64_t start = host::now();
+  unsigned scans = card.scans();
+  CHECK(reader.readData(perBlock, 4) == 1 && reader.readData(perBlock + 16, 1) == 1 &&
+        reader.readData(perBlock + 32, 2) == 1);
+  uint64_t perBlockUs = host::now() - start;
+  CHECK(card.scans() - scans == 3);
+  memset(blocks, 0, sizeof(blocks));
+  CHECK(readLegacy(reader, card, blocks, &polled));
+  CHECK(memcmp(blocks, perBlock, sizeof(blocks)) == 0);
+  CHECK(polled.timing.scanCount == 1 && polled.timing.authCount == 2 && polled.timing.readCount == 3);
+  // The counters account for the whole swipe bar the bookkeeping between commands
+  uint32_t counted = polled.timing.scanTime + polled.timing.authTime + polled.timing.readTime;
+  CHECK(counted <= polled.us && counted + 100 > polled.us);
+  CHECK(polled.us * 4 < perBlockUs * 3);
+
+  // The same swipe with the reader signalling on IRQ: two reads per command, the ACK and the
+  // response, and no slower than polling
+  DFRobot_PN532_IIC irqReader(IRQPIN, 1);
+  card.setIrq(IRQPIN);
+  CHECK(irqReader.begin());
+  memset(blocks, 0, sizeof(blocks));
+  CHECK(readLegacy(irqReader, card, blocks, &irq));
+  CHECK(memcmp(blocks, perBlock, sizeof(blocks)) == 0);
+  CHECK(irq.timing.scanCount == 1 && irq.timing.authCount == 2 && irq.timing.readCount == 3);
+  CHECK(irq.requests == 2 * 6);
+  CHECK(irq.us <= polled.us && irq.requests < polled.requests);
+  printf("PN532: legacy card per block %.1f ms, in one session %.1f ms\n", perBlockUs / 1000.0, polled.us / 1000.0);
+  printf("PN532: session select %u us, %u auths %u us, %u reads %u us\n", polled.timing.scanTime,
+         polled.timing.authCount, polled.timing.authTime, polled.timing.readCount, polled.timing.readTime);
+  printf("PN532: session polled %.1f ms (%u I2C reads), on IRQ %.1f ms (%u I2C reads)\n", polled.us / 1000.0,
+         polled.requests, irq.us / 1000.0, irq.requests);
+
+  // No card, the IRQ reader gets its answer and doesn't wait out the timeout
+  card.setCard(false);
+  start = host::now();
+  CHECK(!irqReader.beginSession());
+  CHECK(host::now() - start < 20000);
+  return host::finish("PN532Test");
+}
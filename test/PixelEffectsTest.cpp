@@ -0,0 +1,197 @@
+// Renders each ring effect a frame per PIXELFRAMEPERIOD onto strips of 12 (the ring), 60, 144 and 300
+// pixels on SPI1 and checks what it draws: a solid ring only goes out when it changes, the pulse
+// breathes with its period, the chase steps round with its tail, the progress arc grows with a partly
+// lit leading pixel, the gradient follows the temperature, and off() clears the ring at once. Then
+// times rendering the pulse, chase and progress at each length, wall time so only the growth with
+// length means much.
+#include "PixelEffects.h"
+#include "HostDevices.h"
+#include "HostTest.h"
+#include <chrono>
+
+namespace {
+
+const int LENGTHS[] = {12, 60, 144, 300};   // PIXELCOUNT first
+const int TIMEDFRAMES = 2000;
+const uint32_t ORANGE = 0xFFA500;
+const uint32_t PURPLE = 0x4B0082;
+
+FakeNeoPixelStrip strip;
+
+// One scheduler frame
+void frame(PixelEffects *ring) {
+  ring->render();
+  host::advance(PIXELFRAMEPERIOD * 1000);
+}
+
+bool all(const Adafruit_NeoPixel &pixels, uint32_t color) {
+  for(int i = 0; i < pixels.numPixels(); i++) {
+    if(pixels.getPixelColor(i) != color) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int lit(const Adafruit_NeoPixel &pixels) {
+  int count = 0;
+
+  for(int i = 0; i < pixels.numPixels(); i++) {
+    count += pixels.getPixelColor(i) != 0;
+  }
+  return count;
+}
+
+// us of wall time per frame rendering whatever effect ring has, step(i) runs before frame i
+template <typename Step> double renderTime(PixelEffects *ring, Step step) {
+  double seconds = 0;
+
+  for(int i = 0; i < TIMEDFRAMES; i++) {
+    step(i);
+    auto start = std::chrono::steady_clock::now();
+    ring->render();
+    seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    host::advance(PIXELFRAMEPERIOD * 1000);
+  }
+  return seconds * 1e6 / TIMEDFRAMES;
+}
+
+void effects(int leds) {
+  Adafruit_NeoPixel pixels(leds, SPI1, WS2812B);
+  PixelEffects ring(&pixels);
+  unsigned frames;
+  int head;
+  bool moved, even;
+
+  pixels.begin();
+
+  // A solid ring is drawn once, later frames send nothing
+  ring.solid(ORANGE);
+  frame(&ring);
+  CHECK(all(pixels, ORANGE));
+  frames = strip.frames;
+  for(int i = 0; i < 10; i++) {
+    frame(&ring);
+  }
+  CHECK(strip.frames == frames);
+  ring.solid(ORANGE);
+  frame(&ring);
+  CHECK(strip.frames == frames);
+
+  // The pulse lights the whole ring evenly and comes back round every PULSEFRAMES frames
+  ring.pulse(PURPLE);
+  frame(&ring);
+  uint32_t first = pixels.getPixelColor(0);
+  uint32_t brightest = 0;
+  CHECK(all(pixels, first));
+  CHECK(first != 0 && first < PURPLE);
+  even = true;
+  for(int i = 1; i < PULSEFRAMES; i++) {
+    frame(&ring);
+    even = even && all(pixels, pixels.getPixelColor(0));
+    brightest = max(brightest, pixels.getPixelColor(0));
+  }
+  CHECK(even);
+  CHECK(brightest == PURPLE);
+  frame(&ring);
+  CHECK(all(pixels, first));
+
+  // The chase head is at full colour with CHASETAIL - 1 dimmer pixels behind it, and steps one
+  // pixel every CHASEFRAMES frames
+  ring.chase(ORANGE);
+  head = -1;
+  moved = even = true;
+  for(int step = 0; step < 2 * leds; step++) {
+    frame(&ring);
+    even = even && lit(pixels) == CHASETAIL && pixels.getPixelColor(step % leds) == ORANGE;
+    if(head >= 0) {
+      moved = moved && (head + 1) % leds == step % leds;
+    }
+    head = step % leds;
+    for(int i = 1; i < CHASEFRAMES; i++) {
+      frame(&ring);
+    }
+  }
+  CHECK(even);
+  CHECK(moved);
+
+  // Progress, whole pixels lit for the part done and the next one partly
+  ring.progress(ORANGE);
+  ring.setProgress(0, 100);
+  frame(&ring);
+  CHECK(lit(pixels) == 0);
+  ring.setProgress(1, 4);
+  frame(&ring);
+  CHECK(lit(pixels) == leds / 4);
+  CHECK(pixels.getPixelColor(leds / 4 - 1) == ORANGE);
+  ring.setProgress(3, 2 * leds);
+  frame(&ring);
+  CHECK(lit(pixels) == 2);
+  CHECK(pixels.getPixelColor(0) == ORANGE);
+  CHECK(pixels.getPixelColor(1) != 0 && pixels.getPixelColor(1) < ORANGE);
+  ring.setProgress(100, 100);
+  frame(&ring);
+  CHECK(all(pixels, ORANGE));
+  frames = strip.frames;
+  ring.setProgress(200, 100);
+  frame(&ring);
+  CHECK(strip.frames == frames);
+
+  // The gradient goes from blue through green to red, and holds at the ends
+  ring.gradient();
+  ring.setTemperature(50, 100, 500);
+  frame(&ring);
+  CHECK(all(pixels, 0x0000FF));
+  ring.setTemperature(300, 100, 500);
+  frame(&ring);
+  CHECK(all(pixels, 0x00FF00));
+  ring.setTemperature(500, 100, 500);
+  frame(&ring);
+  CHECK(all(pixels, 0xFF0000));
+  ring.setTemperature(900, 100, 500);
+  frame(&ring);
+  CHECK(all(pixels, 0xFF0000));
+
+  // Off goes out straight away, without waiting for a frame, and is on the wire until the DMA is done
+  frames = strip.frames;
+  ring.off();
+  CHECK(ring.getEffect() == EFFECT_OFF);
+  CHECK(all(pixels, 0));
+  CHECK(strip.frames == frames + 1);
+  CHECK(!pixels.canShow());
+  host::advance(PIXELFRAMEPERIOD * 1000);
+
+  // Render time with every frame changing, the progress arc creeping round
+  ring.pulse(PURPLE);
+  double pulse = renderTime(&ring, [](int i) { (void)i; });
+  ring.chase(ORANGE);
+  double chase = renderTime(&ring, [](int i) { (void)i; });
+  ring.progress(ORANGE);
+  double progress = renderTime(&ring, [&](int i) { ring.setProgress(i, TIMEDFRAMES); });
+  printf("PixelEffects: %3d LEDs, %u frames sent, %u skipped, render pulse %.2f us, chase %.2f us, progress %.2f us\n",
+         leds, pixels.getFramesSent(), pixels.getFramesSkipped(), pulse, chase, progress);
+  ring.off();
+  host::advance(PIXELFRAMEPERIOD * 1000);
+}
+
+}
+
+int main() {
+  bool moved;
+
+  host::attachSpi(HAL_SPI_INTERFACE2, PIN_INVALID, &strip);
+
+  // Gamma scaling keeps full and zero, and never gets dimmer as the level goes up
+  CHECK(PixelEffects::scale(0xFFFFFF, 255) == 0xFFFFFF);
+  CHECK(PixelEffects::scale(0xFFFFFF, 0) == 0);
+  moved = true;
+  for(int level = 1; level < 256; level++) {
+    moved = moved && (PixelEffects::scale(0xFF0000, level) >= PixelEffects::scale(0xFF0000, level - 1));
+  }
+  CHECK(moved);
+
+  for(int leds : LENGTHS) {
+    effects(leds);
+  }
+  return host::finish("PixelEffectsTest");
+}
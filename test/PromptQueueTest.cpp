@@ -0,0 +1,104 @@
+// Plays prompts through the queue and the DFPlayer library against the fake player: one clip at a
+// time, no repeats of a queued prompt, the doubled finished message can't cut the next clip short,
+// a prompt asked for every pass is held off, and no pass of update() holds loop() up for more than
+// 5 ms, the one that starts a clip included.
+#include "DFRobotDFPlayerMini.h"
+#include "HostDevices.h"
+#include "HostTest.h"
+#include "PromptQueue.h"
+
+namespace {
+
+const unsigned CLIPLENGTH = 3000;    // ms
+const uint64_t PASSLIMIT = 5000;     // us, longest update() may take
+
+FakeDFPlayer player;
+DFRobotDFPlayerMini dfPlayer;
+uint64_t longestPass;
+
+// One pass of loop(), timed
+void pass(PromptQueue *prompts) {
+  uint64_t start = host::now();
+
+  prompts->update();
+  longestPass = max(longestPass, host::now() - start);
+  host::advance(1000);
+}
+
+// Runs the queue for ms, a pass every millisecond
+void run(PromptQueue *prompts, unsigned ms) {
+  for(unsigned i = 0; i < ms; i++) {
+    pass(prompts);
+  }
+}
+
+// Time between the starts of the first plays of two tracks, ms
+int64_t gap(int first, int second) {
+  uint64_t a = 0, b = 0;
+
+  for(const FakeDFPlayer::play &p : player.plays) {
+    if(a == 0 && p.track == first) {
+      a = p.at;
+    }
+    if(b == 0 && p.track == second) {
+      b = p.at;
+    }
+  }
+  return ((int64_t)b - (int64_t)a) / 1000;
+}
+
+}
+
+int main() {
+  host::attachSerial(1, &player);
+  player.setClipLength(CLIPLENGTH);
+  Serial1.begin(9600);
+  CHECK(dfPlayer.begin(Serial1));
+  PromptQueue prompts(&dfPlayer);
+
+  // Clips play one after the other, each once the previous one finished
+  CHECK(prompts.enqueue(1));
+  CHECK(prompts.enqueue(2));
+  CHECK(prompts.enqueue(3));
+  // Already queued, not only the last one in the queue
+  CHECK(!prompts.enqueue(1));
+  CHECK(!prompts.enqueue(2));
+  run(&prompts, 1);
+  CHECK(prompts.isPlaying());
+  CHECK(player.playing() == 1);
+  // Playing or queued, either way a repeat is dropped
+  CHECK(!prompts.enqueue(1));
+  CHECK(!prompts.enqueue(3));
+  run(&prompts, 3 * CLIPLENGTH + 500);
+  CHECK(player.count(1) == 1 && player.count(2) == 1 && player.count(3) == 1);
+  // The player sends the finished message twice, the second one is for the clip that already ended
+  // and may not end the next clip early
+  CHECK(gap(1, 2) >= (int64_t)CLIPLENGTH);
+  CHECK(gap(2, 3) >= (int64_t)CLIPLENGTH);
+  CHECK(!prompts.isPlaying());
+
+  // A prompt asked for every pass plays at most once per holdoff
+  player.plays.clear();
+  for(int i = 0; i < 40000; i++) {
+    prompts.enqueue(6, 15000);
+    pass(&prompts);
+  }
+  CHECK(player.count(6) == 3);
+  // Other prompts still get in between
+  CHECK(prompts.enqueue(5));
+  run(&prompts, CLIPLENGTH + 500);
+  CHECK(player.count(5) == 1);
+
+  // The queue holds PROMPTQUEUESIZE tracks, the rest are dropped and counted
+  prompts.clear();
+  for(int track = 1; track <= PROMPTQUEUESIZE + 2; track++) {
+    prompts.enqueue(track);
+  }
+  CHECK(prompts.pending() == PROMPTQUEUESIZE);
+  CHECK(prompts.dropped() == 2);
+
+  // Every pass, the ones that started a clip or took a finished message included, was quick
+  printf("PromptQueue: longest update() %.3f ms over %zu clips\n", longestPass / 1000.0, player.plays.size());
+  CHECK(longestPass < PASSLIMIT);
+  return host::finish("PromptQueueTest");
+}
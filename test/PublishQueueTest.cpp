@@ -0,0 +1,131 @@
+// Queues status and temperature records through the publish queue and forwards them the way the
+// network task does, against a fake broker. A record queued before Time is synced is filed under
+// 2026 once it is, not 1970, and goes out as a plain value while the clock is still unset. Then the
+// broker drops the connection over and over while records keep coming: every record reaches it
+// once, in order, the only repeats being QoS 1 retransmissions of a packet id it already has.
+#include "HostDevices.h"
+#include "HostTest.h"
+#include "Adafruit_MQTT_SPARK.h"
+#include "PublishQueue.h"
+#include <random>
+#include <set>
+
+namespace {
+
+const uint64_t TASKPERIOD = 100000;   // us, NETWORKPERIOD
+const int BATCH = 4;                  // PUBLISHBATCH
+const int WINDOW = 4;                 // PUBLISHWINDOW
+const uint64_t MS = 1000;             // us
+const char *STATUSFEED = "user/feeds/smartcookerstatus";
+const char *TEMPFEED = "user/feeds/smartcookertemp";
+
+FakeMqttBroker broker;
+TCPClient client;
+Adafruit_MQTT_SPARK mqtt(&client, "io.adafruit.com", 1883, "user", "key");
+Adafruit_MQTT_Publish status(&mqtt, STATUSFEED, MQTT_QOS_1);
+Adafruit_MQTT_Publish temp(&mqtt, TEMPFEED, MQTT_QOS_1);
+PublishQueue outbox;
+
+// One network task pass: keep the connection up, pick up PUBACKs, forward a batch
+void pass() {
+  uint64_t start = host::now();
+
+  if(mqtt.Update()) {
+    mqtt.dispatchPackets();
+    mqtt.beginBatch();
+    outbox.drain(BATCH);
+    mqtt.endBatch();
+  }
+  host::advance(TASKPERIOD - min(TASKPERIOD, host::now() - start));
+}
+
+// Runs passes until the queue and the publish window are empty, or ms have gone by
+void settle(uint64_t ms) {
+  uint64_t start = host::now();
+
+  while(host::now() - start < ms * MS && (outbox.pending() > 0 || mqtt.inflight() > 0)) {
+    pass();
+  }
+}
+
+}
+
+int main() {
+  std::mt19937_64 rng(12);
+  std::vector<std::string> expected, delivered;
+  std::set<uint16_t> ids;
+  unsigned retransmits, drops;
+
+  mqtt.setPublishWindow(WINDOW);
+  host::attachTcp(&broker);
+
+  // Queued at power on before the clock is synced, sent 30 s later once it is
+  host::setTimeValid(false);
+  broker.up = false;
+  outbox.enqueue(&status, 1);
+  host::advance(30000 * MS);
+  host::setTimeValid(true);
+  broker.up = true;
+  settle(10000);
+  CHECK(broker.received.size() == 1);
+  printf("PublishQueue: queued before the clock was set, sent as %s\n", broker.received[0].payload.c_str());
+  CHECK(broker.received[0].payload.find("\"value\":1,\"created_at\":\"2026-01-01T00:00:0") != std::string::npos);
+
+  // Late but the clock still isn't set, a plain value that Adafruit IO stamps when it arrives
+  broker.drop();
+  broker.up = false;
+  host::setTimeValid(false);
+  outbox.enqueue(&temp, 72.5, 1);
+  host::advance(20000 * MS);
+  broker.up = true;
+  settle(10000);
+  CHECK(broker.received.size() == 2 && broker.received[1].payload == "72.5");
+  host::setTimeValid(true);
+
+  // Ten minutes of a record a second, alternating feeds, while the broker drops the connection 0.3 to
+  // 3 s after each reconnect and refuses connects for up to 4 s, never long enough for the ring to fill
+  broker.received.clear();
+  drops = 0;
+  uint64_t end = host::now() + 600000 * MS;
+  uint64_t dropAt = 0;
+  int seq = 0;
+  while(host::now() < end) {
+    if(dropAt == 0 && mqtt.getState() == MQTT_STATE_CONNECTED) {
+      dropAt = host::now() + (300 + rng() % 2700) * MS;
+    }
+    if(dropAt != 0 && host::now() >= dropAt) {
+      broker.drop();
+      broker.up = false;
+      drops++;
+      host::schedule(host::now() + (500 + rng() % 3500) * MS, []() { broker.up = true; });
+      dropAt = 0;
+    }
+    if(host::now() / TASKPERIOD % 10 == 0) {
+      outbox.enqueue(seq % 2 ? &temp : &status, seq, 0);
+      expected.push_back(std::string(seq % 2 ? TEMPFEED : STATUSFEED) + " " + std::to_string(seq));
+      seq++;
+    }
+    pass();
+  }
+  settle(60000);
+
+  // Drop retransmissions of a packet id the broker already has, what's left is what was queued
+  retransmits = 0;
+  for(const FakeMqttBroker::message &m : broker.received) {
+    if(m.dup && ids.count(m.id)) {
+      retransmits++;
+      continue;
+    }
+    ids.insert(m.id);
+    delivered.push_back(m.topic + " " + m.payload);
+  }
+  printf("PublishQueue: %d records through %u drops, %zu publishes, %u retransmitted, high water %u\n", seq,
+         drops, broker.received.size(), retransmits, outbox.highWater());
+  CHECK(drops > 100);
+  CHECK(outbox.pending() == 0 && mqtt.inflight() == 0);
+  CHECK(outbox.dropped() == 0 && outbox.coalesced() == 0);
+  CHECK(outbox.highWater() < PUBLISHQUEUESIZE);
+  CHECK(delivered.size() == expected.size());
+  CHECK(delivered == expected);
+  return host::finish("PublishQueueTest");
+}
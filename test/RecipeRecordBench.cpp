@@ -0,0 +1,96 @@
+// Time and heap allocations per card scan for the binary and legacy recipe decoders, against the old
+// nfcRead() parse into a String with atoi(). Every operator new in the process is counted, the
+// decoders must not make any.
+#include "RecipeRecord.h"
+#include <chrono>
+#include <new>
+
+namespace {
+
+const int SCANS = 1000000;
+
+unsigned long allocations;
+
+double nsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(const char *name, double ns, unsigned long allocs) {
+  printf("RecipeRecord: %-28s %6.1f ns/scan, %.2f allocations/scan\n", name, ns / SCANS, (double)allocs / SCANS);
+}
+
+}
+
+void *operator new(size_t size) {
+  void *p;
+
+  allocations++;
+  p = malloc(size ? size : 1);
+  if(p == NULL) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept {
+  free(p);
+}
+
+void operator delete(void *p, size_t size) noexcept {
+  (void)size;
+  free(p);
+}
+
+int main() {
+  cookingInstructions recipe = {"Salsbury Steak & Mac Cheese", 0, 0, 0, 2, 0, {{375, 30}, {325, 10}}, 160};
+  cookingInstructions decoded;
+  uint8_t card[RECIPERECORDSIZE], name[16], temp[16], time[16];
+  unsigned long before, binaryAllocs, legacyAllocs, oldAllocs;
+  volatile int sink = 0;
+  double ns;
+
+  encodeRecipe(&recipe, card);
+  memset(name, 0, sizeof(name));
+  memcpy(name, "Salsbury Steak &", 16);
+  memset(temp, 0, sizeof(temp));
+  memcpy(temp, "350", 3);
+  memset(time, 0, sizeof(time));
+  memcpy(time, "35", 2);
+
+  before = allocations;
+  auto start = std::chrono::steady_clock::now();
+  for(int i = 0; i < SCANS; i++) {
+    sink += decodeRecipe(card, &decoded) + decoded.cookTemp;
+  }
+  ns = nsSince(start);
+  binaryAllocs = allocations - before;
+  report("binary record", ns, binaryAllocs);
+
+  before = allocations;
+  start = std::chrono::steady_clock::now();
+  for(int i = 0; i < SCANS; i++) {
+    sink += decodeLegacyRecipe(name, temp, time, &decoded) + decoded.cookTemp;
+  }
+  ns = nsSince(start);
+  legacyAllocs = allocations - before;
+  report("legacy ASCII blocks", ns, legacyAllocs);
+
+  // What nfcRead() did before, the name assigned to a String and the numbers through atoi(). On the
+  // device every String allocates, here only a name too long for std::string's small buffer does.
+  before = allocations;
+  start = std::chrono::steady_clock::now();
+  for(int i = 0; i < SCANS; i++) {
+    char nameCopy[17];
+    memcpy(nameCopy, name, 16);
+    nameCopy[16] = 0;
+    String recipeName;
+    recipeName = nameCopy;
+    sink += atoi((char *)temp) - 150 + atoi((char *)time) * 60000 + recipeName.length();
+  }
+  ns = nsSince(start);
+  oldAllocs = allocations - before;
+  report("String and atoi (old)", ns, oldAllocs);
+
+  (void)sink;
+  return (binaryAllocs == 0 && legacyAllocs == 0) ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+// Decodes recipe cards, binary and legacy ASCII: a record round trips through encode and decode, a
+// damaged one is turned away by its CRC, each field out of range gets its own error and leaves the
+// instructions alone, an old card keeps its 150 F offset, and a recipe started from the dashboard
+// heats to the temperature on the recipe.
+#include "HostTest.h"
+#include "RecipeRecord.h"
+
+void remoteCommand(uint32_t value);
+extern cookingInstructions ci;
+
+namespace {
+
+const uint32_t REMOTELASAGNA = 16;   // LASAGNA on the dashboard
+
+uint8_t card[RECIPERECORDSIZE];
+
+// Encodes a one stage card, then lets edit change the record and puts a good CRC back
+template <typename Edit> void makeCard(Edit edit) {
+  cookingInstructions recipe = {"Lasagna", 0, 0, 0, 1, 0, {{375, 40}}, 165};
+  recipeRecord record;
+
+  encodeRecipe(&recipe, card);
+  memcpy(&record, card, RECIPERECORDSIZE);
+  edit(&record);
+  memcpy(card, &record, RECIPERECORDSIZE);
+  record.crc = recipeCRC(card, RECIPERECORDSIZE - sizeof(record.crc));
+  memcpy(card, &record, RECIPERECORDSIZE);
+}
+
+// Decodes into instructions that were already filled in, the error or RECIPE_OK, and whether a
+// failed decode left them alone
+template <typename Edit> recipeError decodeCard(Edit edit, bool *untouched) {
+  cookingInstructions before, after;
+
+  makeCard(edit);
+  memset(&before, 0x5A, sizeof(before));
+  after = before;
+  recipeError error = decodeRecipe(card, &after);
+  *untouched = memcmp(&before, &after, sizeof(before)) == 0;
+  return error;
+}
+
+void block(uint8_t *data, const char *text) {
+  memset(data, 0, 16);
+  memcpy(data, text, strnlen(text, 16));
+}
+
+}
+
+int main() {
+  cookingInstructions decoded;
+  bool untouched, allUntouched;
+  uint8_t name[16], temp[16], time[16];
+
+  // Three stages and a core target round trip, the current stage is the first with its offset
+  cookingInstructions roast = {"Roast Chicken", 0, 0, -10, 3, 0, {{450, 15}, {350, 45}, {300, 10}}, 166};
+  encodeRecipe(&roast, card);
+  CHECK(decodeRecipe(card, &decoded) == RECIPE_OK);
+  CHECK(strcmp(decoded.recipeName, "Roast Chicken") == 0);
+  CHECK(decoded.stageCount == 3 && decoded.stage == 0);
+  CHECK(decoded.stages[1].cookTemp == 350 && decoded.stages[2].cookMinutes == 10);
+  CHECK(decoded.cookTemp == 440 && decoded.cookTime == 15 * 60000);
+  CHECK(decoded.coreTemp == 166 && decoded.calOffset == -10);
+
+  // Stages past the count come back zeroed, not whatever was on the stack
+  memset(&decoded, 0x5A, sizeof(decoded));
+  makeCard([](recipeRecord *r) { (void)r; });
+  CHECK(decodeRecipe(card, &decoded) == RECIPE_OK);
+  CHECK(decoded.stages[1].cookTemp == 0 && decoded.stages[2].cookMinutes == 0);
+
+  // A flipped bit anywhere after the magic and version is caught by the CRC
+  allUntouched = true;
+  for(int i = 2; i < RECIPERECORDSIZE; i++) {
+    cookingInstructions before, after;
+    makeCard([](recipeRecord *r) { (void)r; });
+    card[i] ^= 0x10;
+    memset(&before, 0x5A, sizeof(before));
+    after = before;
+    allUntouched = allUntouched && decodeRecipe(card, &after) == RECIPE_BADCRC &&
+                   memcmp(&before, &after, sizeof(before)) == 0;
+  }
+  CHECK(allUntouched);
+
+  // Each field out of range, with a good CRC, has its own error and changes nothing
+  CHECK(decodeCard([](recipeRecord *r) { r->magic = 'L'; }, &untouched) == RECIPE_BADMAGIC && untouched);
+  CHECK(decodeCard([](recipeRecord *r) { r->version = 2; }, &untouched) == RECIPE_BADVERSION && untouched);
+  CHECK(decodeCard([](recipeRecord *r) { r->stageCount = 0; }, &untouched) == RECIPE_BADSTAGECOUNT && untouched);
+  CHECK(decodeCard([](recipeRecord *r) { r->stageCount = MAXSTAGES + 1; }, &untouched) == RECIPE_BADSTAGECOUNT &&
+        untouched);
+  CHECK(decodeCard([](recipeRecord *r) { r->stages[0].cookTemp = MINCOOKTEMP - 1; }, &untouched) == RECIPE_BADTEMP &&
+        untouched);
+  CHECK(decodeCard([](recipeRecord *r) { r->stages[0].cookTemp = MAXCOOKTEMP + 1; }, &untouched) == RECIPE_BADTEMP &&
+        untouched);
+  CHECK(decodeCard([](recipeRecord *r) { r->stages[0].cookMinutes = 0; }, &untouched) == RECIPE_BADTIME && untouched);
+  CHECK(decodeCard([](recipeRecord *r) { r->stages[0].cookMinutes = MAXCOOKMINUTES + 1; }, &untouched) ==
+        RECIPE_BADTIME && untouched);
+  // The second stage is checked too
+  CHECK(decodeCard([](recipeRecord *r) { r->stageCount = 2; }, &untouched) == RECIPE_BADTEMP && untouched);
+  CHECK(decodeCard([](recipeRecord *r) { r->coreTemp = (MINCORETEMP - 2) / 2; }, &untouched) ==
+        RECIPE_BADCORETEMP && untouched);
+  CHECK(decodeCard([](recipeRecord *r) { r->coreTemp = (MAXCORETEMP + 2) / 2; }, &untouched) ==
+        RECIPE_BADCORETEMP && untouched);
+  CHECK(decodeCard([](recipeRecord *r) { r->recipeName[0] = 0; }, &untouched) == RECIPE_BADNAME && untouched);
+  CHECK(decodeCard([](recipeRecord *r) { r->recipeName[3] = '\n'; }, &untouched) == RECIPE_BADNAME && untouched);
+  CHECK(decodeCard([](recipeRecord *r) { memset(r->recipeName, 'x', RECIPENAMESIZE); }, &untouched) ==
+        RECIPE_BADNAME && untouched);
+  // No core target is fine, the stage cooks for its full time
+  CHECK(decodeCard([](recipeRecord *r) { r->coreTemp = 0; }, &untouched) == RECIPE_OK);
+
+  // An old card in ASCII blocks keeps the 150 F offset the faulty thermocouple needed
+  block(name, "Lasagna");
+  block(temp, "375");
+  block(time, "40");
+  memset(&decoded, 0x5A, sizeof(decoded));
+  CHECK(decodeLegacyRecipe(name, temp, time, &decoded) == RECIPE_OK);
+  CHECK(strcmp(decoded.recipeName, "Lasagna") == 0);
+  CHECK(decoded.stageCount == 1 && decoded.calOffset == LEGACYCALOFFSET && decoded.coreTemp == 0);
+  CHECK(decoded.cookTemp == 375 + LEGACYCALOFFSET && decoded.cookTime == 40 * 60000);
+  CHECK(decoded.stages[1].cookTemp == 0 && decoded.stages[2].cookMinutes == 0);
+  // A name that fills its block has no terminator and is still whole
+  memcpy(name, "Salsbury Steak12", 16);
+  CHECK(decodeLegacyRecipe(name, temp, time, &decoded) == RECIPE_OK &&
+        strcmp(decoded.recipeName, "Salsbury Steak12") == 0);
+  block(name, "Lasagna");
+  block(temp, "hot");
+  CHECK(decodeLegacyRecipe(name, temp, time, &decoded) == RECIPE_BADTEMP);
+  block(temp, "900");
+  CHECK(decodeLegacyRecipe(name, temp, time, &decoded) == RECIPE_BADTEMP);
+  block(temp, "375");
+  block(time, "0");
+  CHECK(decodeLegacyRecipe(name, temp, time, &decoded) == RECIPE_BADTIME);
+  block(time, "40");
+  block(name, "");
+  CHECK(decodeLegacyRecipe(name, temp, time, &decoded) == RECIPE_BADNAME);
+
+  // Lasagna from the dashboard heats to 375 F, as it always has, not to the old cards' 225 F
+  remoteCommand(REMOTELASAGNA);
+  printf("RecipeRecord: remote Lasagna at %d F for %d min\n", ci.cookTemp, ci.cookTime / 60000);
+  CHECK(strcmp(ci.recipeName, "Lasagna") == 0);
+  CHECK(ci.cookTemp == 375 && ci.cookTime == 40 * 60000);
+  return host::finish("RecipeRecordTest");
+}
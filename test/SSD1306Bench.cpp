@@ -0,0 +1,110 @@
+// Bus time per OLED frame with 16 byte, 32 byte and full page (128 byte) I2C bursts: the first frame
+// sent as one window, a full screen redraw going out a page per flush(), and a changed line of text.
+// Virtual time from the host I2C model at 400 kHz. It counts the address and control byte each
+// transaction adds but not the start, stop and driver overhead, so the device gains more than this.
+// Then characters per second drawing a full 21x8 screen of size 1 text through the SSD1306 glyph fast
+// path and through Adafruit_GFX a pixel at a time, page aligned and 3 pixels down. Wall time, so only
+// the ratio means much.
+#include "Adafruit_SSD1306.h"
+#include "HostDevices.h"
+#include <chrono>
+
+namespace {
+
+const int FRAMES = 100;
+const int WIREBUFFER = SSD1306_LCDWIDTH + 1;   // What the app asks acquireWireBuffer() for
+const int SCREENS = 20000;
+const int COLUMNS = SSD1306_LCDWIDTH / 6, ROWS = SSD1306_LCDHEIGHT / 8;
+
+struct frameCost {
+  double ms;
+  double transactions;
+};
+
+// Sends frames from draw and averages getFrameTime() and the transactions each took
+template <typename Draw> frameCost run(Adafruit_SSD1306 &display, FakeSSD1306 &panel, int frames, Draw draw) {
+  uint64_t us = 0;
+  unsigned transactions = panel.transactions;
+
+  for(int i = 0; i < frames; i++) {
+    draw(i);
+    display.display();
+    us += display.getFrameTime();
+  }
+  return {us / 1000.0 / frames, (double)(panel.transactions - transactions) / frames};
+}
+
+// Characters per second filling the screen SCREENS times, through the fast path or Adafruit_GFX's
+double charsPerSecond(Adafruit_SSD1306 &display, int16_t yOffset, bool fast) {
+  auto start = std::chrono::steady_clock::now();
+  for(int screen = 0; screen < SCREENS; screen++) {
+    for(int row = 0; row < ROWS; row++) {
+      for(int column = 0; column < COLUMNS; column++) {
+        unsigned char c = ' ' + (screen + row * COLUMNS + column) % 95;
+        if(fast) {
+          display.drawChar(column * 6, row * 8 + yOffset, c, WHITE, BLACK, 1);
+        }
+        else {
+          display.Adafruit_GFX::drawChar(column * 6, row * 8 + yOffset, c, WHITE, BLACK, 1);
+        }
+      }
+    }
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return (double)SCREENS * ROWS * COLUMNS / seconds;
+}
+
+}
+
+hal_i2c_config_t acquireWireBuffer() {
+  hal_i2c_config_t config = {
+    .size = sizeof(hal_i2c_config_t),
+    .version = HAL_I2C_CONFIG_VERSION_1,
+    .rx_buffer = new uint8_t[WIREBUFFER],
+    .rx_buffer_size = WIREBUFFER,
+    .tx_buffer = new uint8_t[WIREBUFFER],
+    .tx_buffer_size = WIREBUFFER
+  };
+  return config;
+}
+
+int main() {
+  for(int burst : {16, 32, SSD1306_LCDWIDTH}) {
+    FakeSSD1306 panel;
+    Adafruit_SSD1306 display(-1);
+    frameCost first, redraw, text;
+
+    host::attachI2C(0x3C, &panel);
+    display.begin(SSD1306_SWITCHCAPVCC, 0x3C);
+    display.setBurstSize(burst, Wire.bufferSize());
+    display.setTextColor(WHITE, BLACK);
+
+    first = run(display, panel, 1, [&](int i) {
+      (void)i;
+      display.clearDisplay();
+      display.fillRect(0, 0, SSD1306_LCDWIDTH, 16, WHITE);
+    });
+    redraw = run(display, panel, FRAMES, [&](int i) {
+      display.fillScreen(i % 2 ? BLACK : WHITE);
+    });
+    display.clearDisplay();
+    display.display();
+    text = run(display, panel, FRAMES, [&](int i) {
+      display.setCursor(0, 24);
+      display.printf("Oven %3d F", 100 + i);
+    });
+
+    printf("SSD1306: burst %3d, first frame %5.2f ms (%4.1f transactions), full redraw %5.2f ms (%4.1f), "
+           "text line %4.2f ms (%4.1f)\n", display.getBurstSize(), first.ms, first.transactions, redraw.ms,
+           redraw.transactions, text.ms, text.transactions);
+  }
+
+  Adafruit_SSD1306 display(-1);
+  for(int16_t yOffset : {0, 3}) {
+    double fast = charsPerSecond(display, yOffset, true);
+    double pixels = charsPerSecond(display, yOffset, false);
+    printf("SSD1306: %dx%d text %d px down, glyph fast path %.2f M chars/s, pixel path %.2f M chars/s (%.1fx)\n",
+           COLUMNS, ROWS, yOffset, fast / 1e6, pixels / 1e6, fast / pixels);
+  }
+  return 0;
+}
@@ -0,0 +1,143 @@
+// Draws through the SSD1306 driver onto the fake panel: the frames that reach the panel match what was
+// drawn, a frame latched by displayAsync() goes out a page per flush() while the next one is drawn,
+// the burst size never outgrows the Wire buffer, and text drawn through the glyph fast path shows the
+// same pixels as Adafruit_GFX drawing it a pixel at a time.
+#include "Adafruit_SSD1306.h"
+#include "HostDevices.h"
+#include "HostTest.h"
+
+namespace {
+
+FakeSSD1306 panel;
+unsigned mismatches;
+
+// True if the panel shows exactly a filled rectangle
+bool showsRect(int x0, int y0, int w, int h) {
+  for(int y = 0; y < SSD1306_LCDHEIGHT; y++) {
+    for(int x = 0; x < SSD1306_LCDWIDTH; x++) {
+      bool inside = x >= x0 && x < x0 + w && y >= y0 && y < y0 + h;
+      if(panel.pixel(x, y) != inside) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Puts a diagonal stripe pattern on the panel, so a glyph has lit and dark pixels under it, and
+// nothing is left to send that the glyph doesn't mark dirty itself
+void stripes(Adafruit_SSD1306 &display) {
+  for(int y = 0; y < SSD1306_LCDHEIGHT; y++) {
+    for(int x = 0; x < SSD1306_LCDWIDTH; x++) {
+      display.drawPixel(x, y, (x + 2 * y) % 5 < 2 ? WHITE : BLACK);
+    }
+  }
+  display.display();
+}
+
+// Draws c over the stripes through the SSD1306 drawChar() and through Adafruit_GFX's, and compares
+// what reaches the panel
+bool sameGlyph(Adafruit_SSD1306 &display, int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg,
+               uint8_t size) {
+  uint8_t fast[8][128];
+
+  stripes(display);
+  display.drawChar(x, y, c, color, bg, size);
+  display.display();
+  memcpy(fast, panel.ram, sizeof(fast));
+  stripes(display);
+  display.Adafruit_GFX::drawChar(x, y, c, color, bg, size);
+  display.display();
+  if(memcmp(fast, panel.ram, sizeof(fast)) != 0) {
+    if(mismatches++ < 5) {
+      printf("  char %d at %d,%d color %d bg %d size %d differs\n", c, x, y, color, bg, size);
+    }
+    return false;
+  }
+  return true;
+}
+
+}
+
+int main() {
+  Adafruit_SSD1306 display(-1);
+  unsigned flushes;
+
+  host::attachI2C(0x3C, &panel);
+  display.begin(SSD1306_SWITCHCAPVCC, 0x3C);
+
+  // Without acquireWireBuffer() Wire holds 32 bytes, one of them the control byte
+  display.setBurstSize(128);
+  CHECK(display.getBurstSize() == 31);
+  display.setBurstSize(128, 129);
+  CHECK(display.getBurstSize() == 128);
+  display.setBurstSize(0);
+  CHECK(display.getBurstSize() == 1);
+  display.setBurstSize(128, Wire.bufferSize());
+  CHECK(display.getBurstSize() == Wire.bufferSize() - 1);
+
+  // The first frame goes out whole
+  display.clearDisplay();
+  display.fillRect(10, 4, 20, 12, WHITE);
+  display.display();
+  CHECK(!display.isFlushing());
+  CHECK(showsRect(10, 4, 20, 12));
+  CHECK(panel.largest <= Wire.bufferSize());
+
+  // A latched frame is sent from the front buffer, drawing the next one in the back buffer
+  // doesn't reach the panel, a cleared buffer in particular never shows as a blank frame
+  display.clearDisplay();
+  display.fillRect(40, 30, 8, 30, WHITE);
+  display.displayAsync();
+  CHECK(display.isFlushing());
+  CHECK(showsRect(10, 4, 20, 12));
+  display.clearDisplay();
+  display.fillRect(100, 0, 4, 4, WHITE);
+  flushes = 0;
+  while(!display.flush()) {
+    flushes++;
+    CHECK(flushes < SSD1306_LCDPAGES);
+  }
+  // One page per call, pages 0 to 1 for the old rectangle and 3 to 7 for the new one
+  CHECK(flushes == 7 - 1);
+  CHECK(showsRect(40, 30, 8, 30));
+  CHECK(display.getFrameBytes() > 0);
+
+  // Latching again while a frame is still going out merges the windows
+  display.displayAsync();
+  display.flush();
+  display.clearDisplay();
+  display.fillRect(0, 56, 128, 8, WHITE);
+  display.displayAsync();
+  while(!display.flush());
+  CHECK(showsRect(0, 56, 128, 8));
+
+  // Nothing changed, nothing to send
+  unsigned before = panel.bytes;
+  display.displayAsync();
+  CHECK(!display.isFlushing());
+  CHECK(display.flush());
+  CHECK(panel.bytes == before);
+  CHECK(panel.largest <= Wire.bufferSize());
+
+  // Glyphs clipped at every edge, above the top, on and off page boundaries, in each color pair with
+  // bg == color drawing no background, match the pixel path at size 1 and go through it above
+  const int16_t xs[] = {-6, -5, -1, 0, 1, 61, 122, 123, 127, 128};
+  const int16_t ys[] = {-8, -7, -3, -1, 0, 1, 7, 8, 29, 56, 57, 60, 63, 64};
+  const unsigned char chars[] = {'A', 'g', '#', 0xDB};
+  const uint16_t colors[][2] = {{WHITE, BLACK}, {BLACK, WHITE}, {WHITE, WHITE}, {BLACK, BLACK}};
+  for(uint8_t size = 1; size <= 2; size++) {
+    bool same = true;
+    for(int16_t x : xs) {
+      for(int16_t y : ys) {
+        for(unsigned char c : chars) {
+          for(const uint16_t *pair : colors) {
+            same = sameGlyph(display, x * size, y * size, c, pair[0], pair[1], size) && same;
+          }
+        }
+      }
+    }
+    CHECK(same);
+  }
+  return host::finish("SSD1306Test");
+}
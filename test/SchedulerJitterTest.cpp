@@ -0,0 +1,125 @@
+// Runs the cooker's task set through the Scheduler on a virtual clock, each task costing its measured
+// worst case, and reports the worst start jitter per task. Running only the highest priority due
+// task per pass means a task waits for at most one run of a lower priority task that already started,
+// plus one run of each higher priority task that comes due meanwhile.
+#include "HostTest.h"
+#include "PixelEffects.h"
+#include "Scheduler.h"
+#include "TemperatureProbe.h"
+
+namespace {
+
+uint64_t virtualUs;          // The scheduler's clock, only the tasks and the loop move it
+
+system_tick_t virtualMillis() {
+  return virtualUs / 1000;
+}
+
+system_tick_t virtualMicros() {
+  return virtualUs;
+}
+
+struct taskSpec {
+  const char *name;
+  unsigned int period;       // ms
+  unsigned int cost;         // us per run
+  unsigned int slowCost;     // us every slowEvery runs, a network reconnect or a full OLED frame
+  unsigned int slowEvery;
+  unsigned int runs;
+};
+
+// In priority order, as setup() adds them
+taskSpec specs[] = {
+  {"sensor", MAX6675CONVERSION, 300, 300, 1, 0},
+  {"control", 250, 800, 800, 1, 0},
+  {"network", 100, 400, 15000, 50, 0},
+  {"nfc", 500, 2000, 12000, 10, 0},
+  {"ui", 1000, 1500, 23000, 5, 0},
+  {"pixels", PIXELFRAMEPERIOD, 200, 200, 1, 0},
+  {"telemetry", 10000, 1000, 1000, 1, 0},
+};
+const int TASKCOUNT = sizeof(specs) / sizeof(specs[0]);
+const uint64_t LOOPCOST = 300;      // us for the rest of loop(): inputs, timers, prompts
+
+template <int N> void task() {
+  taskSpec *spec = &specs[N];
+
+  spec->runs++;
+  virtualUs += (spec->runs % spec->slowEvery == 0) ? spec->slowCost : spec->cost;
+}
+
+const taskFunction FUNCTIONS[] = {task<0>, task<1>, task<2>, task<3>, task<4>, task<5>, task<6>};
+
+// Worst start jitter the scheduler allows task n, ms
+unsigned int jitterBound(int n) {
+  unsigned int blocking = 0, preempting = 0;
+
+  for(int i = 0; i < TASKCOUNT; i++) {
+    if(i > n) {
+      blocking = max(blocking, max(specs[i].cost, specs[i].slowCost));
+    }
+    else if(i < n) {
+      preempting += max(specs[i].cost, specs[i].slowCost) + LOOPCOST;
+    }
+  }
+  // Plus the rest of the loop pass and a millisecond of clock granularity
+  return (blocking + preempting + LOOPCOST) / 1000 + 1;
+}
+
+void runFor(Scheduler *scheduler, uint64_t us) {
+  uint64_t end = virtualUs + us;
+
+  while(virtualUs < end) {
+    virtualUs += LOOPCOST;
+    scheduler->run();
+  }
+}
+
+}
+
+int main() {
+  const uint64_t DURATION = 600 * 1000000ULL;
+  const schedulerTask *stats;
+
+  virtualUs = 1000000;
+  Scheduler scheduler(virtualMillis, virtualMicros);
+  for(int i = 0; i < TASKCOUNT; i++) {
+    CHECK(scheduler.addTask(specs[i].name, FUNCTIONS[i], specs[i].period) == i);
+  }
+  runFor(&scheduler, DURATION);
+
+  printf("%-10s %6s %6s %8s %10s %6s %9s\n", "task", "period", "runs", "max run", "max jitter", "bound", "overruns");
+  for(int i = 0; i < TASKCOUNT; i++) {
+    stats = scheduler.getTask(i);
+    printf("%-10s %4ums %6u %6uus %8ums %4ums %9u\n", stats->name, stats->period, stats->runs, stats->maxRunTime,
+           stats->maxJitter, jitterBound(i), stats->overruns);
+    CHECK(stats->maxJitter <= jitterBound(i));
+    // Fixed cadence: no drift and no runs lost when every task fits its period
+    CHECK(stats->runs >= DURATION / 1000 / stats->period - 1 && stats->runs <= DURATION / 1000 / stats->period + 1);
+    CHECK(stats->maxRunTime == max(specs[i].cost, specs[i].slowCost));
+    // The last interval is the period give or take the jitter of the two runs either side of it
+    CHECK(stats->lastInterval + jitterBound(i) >= stats->period && stats->lastInterval <= stats->period + jitterBound(i));
+  }
+  // The heater control task, the one that matters, is held up by no more than the slowest UI frame
+  CHECK(scheduler.getTask(1)->maxJitter <= jitterBound(1));
+  CHECK(jitterBound(1) <= 25);
+  CHECK(scheduler.getTask(1)->overruns == 0);
+
+  // A task that takes longer than its period is counted as overrunning and starts again from now
+  // rather than bursting to catch up, and the higher priority tasks still get their turn
+  for(taskSpec &spec : specs) {
+    spec.runs = 0;
+  }
+  specs[4].cost = specs[4].slowCost = 1200000;
+  scheduler.resetStats();
+  runFor(&scheduler, DURATION / 10);
+  stats = scheduler.getTask(4);
+  printf("ui at %uus a run: runs %u, overruns %u, control max jitter %ums\n", specs[4].cost, stats->runs,
+         stats->overruns, scheduler.getTask(1)->maxJitter);
+  CHECK(stats->overruns == stats->runs);
+  CHECK(stats->runs <= DURATION / 10 / specs[4].cost + 1);
+  CHECK(scheduler.getTask(1)->maxJitter <= specs[4].cost / 1000 + 1);
+  CHECK(scheduler.getTask(1)->runs + 1 >= stats->runs);
+  CHECK(stats->lastInterval >= specs[4].cost / 1000);
+  return host::finish("SchedulerJitterTest");
+}
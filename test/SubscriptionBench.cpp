@@ -0,0 +1,139 @@
+// Cost of finding the subscription for an incoming topic against the number of topics subscribed, 1
+// to MAXSUBSCRIPTIONS, through the hash table and the way the old readSubscription() did it, strlen()
+// and strncasecmp() down the whole subscription list. Every topic shares the feed prefix, the way
+// Adafruit IO names them. Then the whole dispatch, broker to callback through dispatchPackets(), where
+// framing the packet and the fake broker's share outweigh the lookup. Wall time, so only how each
+// grows with the topic count means much.
+#include "HostDevices.h"
+#include "Adafruit_MQTT_SPARK.h"
+#include <chrono>
+#include <memory>
+#include <random>
+#include <strings.h>
+
+namespace {
+
+const int MESSAGES = 400000;
+const int BURST = 8;
+const int LOOKUPS = 4000000;
+
+unsigned received;
+volatile int found;
+
+// Makes the lookup callable from here
+class Client : public Adafruit_MQTT_SPARK {
+ public:
+  Client(TCPClient *client) : Adafruit_MQTT_SPARK(client, "io.adafruit.com", 1883, "user", "key") {}
+  using Adafruit_MQTT::findSubscription;
+};
+
+void onMessage(char *payload, uint16_t length) {
+  (void)payload;
+  (void)length;
+  received++;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::vector<std::string> feeds(int count) {
+  std::vector<std::string> topics;
+
+  for(int i = 0; i < count; i++) {
+    topics.push_back("user/feeds/smartcooker" + std::to_string(i));
+  }
+  return topics;
+}
+
+struct dispatchCost {
+  double lookupNs, dispatchNs;
+};
+
+// ns per hash table lookup and per message from the broker through dispatchPackets() to a callback,
+// 0 if a lookup missed or a message went missing
+dispatchCost hashed(int count) {
+  std::vector<std::string> topics = feeds(count);
+  FakeMqttBroker broker;
+  TCPClient client;
+  Client mqtt(&client);
+  std::vector<std::unique_ptr<Adafruit_MQTT_Subscribe>> subscriptions;
+  std::mt19937 rng(15);
+  dispatchCost cost;
+
+  for(const std::string &topic : topics) {
+    subscriptions.emplace_back(new Adafruit_MQTT_Subscribe(&mqtt, topic.c_str()));
+    subscriptions.back()->setCallback(onMessage);
+    mqtt.subscribe(subscriptions.back().get());
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for(int n = 0; n < LOOKUPS; n++) {
+    const std::string &topic = topics[rng() % count];
+    found = mqtt.findSubscription(topic.c_str(), topic.size());
+    if(found < 0) {
+      return {0, 0};
+    }
+  }
+  cost.lookupNs = secondsSince(start) * 1e9 / LOOKUPS;
+
+  host::attachTcp(&broker);
+  broker.latency = 0;
+  for(int i = 0; i < 1000 && !mqtt.Update(); i++) {
+    host::advance(100000);
+  }
+  if(mqtt.getState() != MQTT_STATE_CONNECTED) {
+    return {0, 0};
+  }
+
+  received = 0;
+  start = std::chrono::steady_clock::now();
+  for(int sent = 0; sent < MESSAGES; sent += BURST) {
+    for(int i = 0; i < BURST; i++) {
+      broker.publish(topics[(sent + i) % count], "42");
+    }
+    while(mqtt.dispatchPackets() > 0);
+  }
+  cost.dispatchNs = secondsSince(start) * 1e9 / MESSAGES;
+  host::attachTcp(nullptr);
+  return received == (unsigned)MESSAGES ? cost : dispatchCost{0, 0};
+}
+
+// ns per lookup scanning the subscription list the way readSubscription() used to
+double linearNs(int count) {
+  std::vector<std::string> topics = feeds(count);
+  const char *list[MAXSUBSCRIPTIONS] = {};
+  std::mt19937 rng(15);
+
+  for(int i = 0; i < count; i++) {
+    list[i] = topics[i].c_str();
+  }
+  auto start = std::chrono::steady_clock::now();
+  for(int n = 0; n < LOOKUPS; n++) {
+    const std::string &topic = topics[rng() % count];
+    int i;
+    for(i = 0; i < MAXSUBSCRIPTIONS; i++) {
+      if(list[i] && strlen(list[i]) == topic.size() && strncasecmp(topic.c_str(), list[i], topic.size()) == 0) {
+        break;
+      }
+    }
+    found = i;
+  }
+  return secondsSince(start) * 1e9 / LOOKUPS;
+}
+
+}
+
+int main() {
+  for(int count : {1, 4, 8, MAXSUBSCRIPTIONS}) {
+    dispatchCost cost = hashed(count);
+    double linear = linearNs(count);
+
+    printf("Subscription: %2d topics, lookup %4.1f ns hashed, %5.1f ns linear, %3.0f ns per dispatched message\n",
+           count, cost.lookupNs, linear, cost.dispatchNs);
+    if(cost.dispatchNs == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
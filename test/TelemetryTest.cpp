@@ -0,0 +1,164 @@
+// Records samples into telemetry frames and decodes them back the way tools/decode_telemetry.py
+// does: base64, then varint deltas from zero at the start of each frame. A cook's worth of samples
+// comes back as recorded, to 0.1 F and whole setpoint degrees, including temperatures below zero and
+// fields that go down, which zigzag encoding keeps to a byte or two. A part filled frame stays put
+// until flush() closes it at the end of the cook, and flushing again adds nothing.
+#include "HostTest.h"
+#include "Telemetry.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+const char BASE64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+std::vector<uint8_t> unbase64(const std::string &text) {
+  std::vector<uint8_t> bytes;
+  uint32_t bits = 0;
+  int count = 0;
+
+  for(char c : text) {
+    const char *at = strchr(BASE64, c);
+    if(c == '=' || at == nullptr) {
+      break;
+    }
+    bits = (bits << 6) | (at - BASE64);
+    count += 6;
+    if(count >= 8) {
+      count -= 8;
+      bytes.push_back(bits >> count);
+    }
+  }
+  return bytes;
+}
+
+uint32_t varint(const std::vector<uint8_t> &frame, size_t *at) {
+  uint32_t value = 0;
+
+  for(int shift = 0; *at < frame.size(); shift += 7) {
+    uint8_t b = frame[(*at)++];
+    value |= (uint32_t)(b & 0x7F) << shift;
+    if(!(b & 0x80)) {
+      break;
+    }
+  }
+  return value;
+}
+
+int32_t zigzag(const std::vector<uint8_t> &frame, size_t *at) {
+  uint32_t value = varint(frame, at);
+  return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+// Appends the samples in one frame to out, false if the frame doesn't parse to its end
+bool decode(const std::vector<uint8_t> &frame, std::vector<telemetrySample> *out) {
+  telemetrySample last = {};
+  int32_t temp = 0, setpoint = 0;
+  size_t at = 2;
+
+  if(frame.size() < 2 || frame[0] != TELEMETRYVERSION) {
+    return false;
+  }
+  for(int i = 0; i < frame[1]; i++) {
+    last.timestamp += varint(frame, &at);
+    temp += zigzag(frame, &at);
+    setpoint += zigzag(frame, &at);
+    last.tempF = temp / 10.0f;
+    last.setpointF = setpoint;
+    last.relayOn = varint(frame, &at);
+    last.dutySeconds += varint(frame, &at);
+    last.controlPeriod += zigzag(frame, &at);
+    last.nfcErrors += varint(frame, &at);
+    last.mqttFailures += varint(frame, &at);
+    out->push_back(last);
+  }
+  return at == frame.size();
+}
+
+// Decodes and pops every completed frame, false if one didn't parse
+bool drain(Telemetry *telemetry, std::vector<telemetrySample> *out, std::vector<std::vector<uint8_t>> *frames) {
+  char text[TELEMETRYFRAMESIZE * 4 / 3 + 4];
+  bool ok = true;
+
+  while(telemetry->peek(text, sizeof(text))) {
+    frames->push_back(unbase64(text));
+    ok = decode(frames->back(), out) && ok;
+    telemetry->pop();
+  }
+  return ok;
+}
+
+bool same(const telemetrySample &a, const telemetrySample &b) {
+  return a.timestamp == b.timestamp && lroundf(a.tempF * 10) == lroundf(b.tempF * 10) &&
+         lroundf(a.setpointF) == lroundf(b.setpointF) && a.relayOn == b.relayOn &&
+         a.dutySeconds == b.dutySeconds && a.controlPeriod == b.controlPeriod && a.nfcErrors == b.nfcErrors &&
+         a.mqttFailures == b.mqttFailures;
+}
+
+}
+
+int main() {
+  std::vector<telemetrySample> recorded, decoded;
+  std::vector<std::vector<uint8_t>> frames;
+  char text[TELEMETRYFRAMESIZE * 4 / 3 + 4];
+
+  // A frozen dish going into a cold oven, heated, cooked, and the setpoint dropped for cooling,
+  // the control interval wandering either side of 1 s
+  Telemetry telemetry;
+  telemetrySample sample = {1767225600, -5.3f, 375, true, 0, 1000, 0, 0};
+  for(int i = 0; i < 20; i++) {
+    recorded.push_back(sample);
+    telemetry.record(sample);
+    sample.timestamp += 10;
+    sample.tempF += (i < 12) ? 31.7f : -42.1f;
+    sample.setpointF = (i < 14) ? 375 : 165;
+    sample.relayOn = i % 3 != 0;
+    sample.dutySeconds += sample.relayOn ? 10 : 0;
+    sample.controlPeriod = 1000 + ((i * 37) % 21) - 10;
+    sample.nfcErrors += i == 7;
+    sample.mqttFailures += i % 9 == 0;
+  }
+  CHECK(telemetry.pending() == 20 / TELEMETRYSAMPLES);
+  CHECK(telemetry.filling() == 20 % TELEMETRYSAMPLES);
+
+  // End of the cook closes the part filled frame, a second flush has nothing to close
+  telemetry.flush();
+  CHECK(telemetry.filling() == 0 && telemetry.pending() == 20 / TELEMETRYSAMPLES + 1);
+  telemetry.flush();
+  CHECK(telemetry.pending() == 20 / TELEMETRYSAMPLES + 1);
+  CHECK(drain(&telemetry, &decoded, &frames));
+  CHECK(frames.back()[1] == 20 % TELEMETRYSAMPLES);
+  CHECK(decoded.size() == recorded.size());
+  bool all = decoded.size() == recorded.size();
+  for(size_t i = 0; all && i < recorded.size(); i++) {
+    all = same(decoded[i], recorded[i]);
+  }
+  CHECK(all);
+  size_t bytes = 0;
+  for(const std::vector<uint8_t> &frame : frames) {
+    bytes += frame.size();
+  }
+  printf("Telemetry: %zu samples in %zu frames, %zu bytes, %.1f bytes a sample\n", recorded.size(), frames.size(),
+         bytes, (double)bytes / recorded.size());
+
+  // Zigzag: a drop of 0.1 F and of 1 F setpoint take a byte each, 1 and 2 for +-1, and -64 still fits
+  // in one where +64 needs two
+  Telemetry small;
+  small.record({1, -0.1f, -1, false, 0, 0, 0, 0});
+  small.record({2, -6.5f, 63, false, 0, 0, 0, 0});
+  small.flush();
+  CHECK(small.peek(text, sizeof(text)));
+  std::vector<uint8_t> frame = unbase64(text);
+  std::vector<uint8_t> expected = {TELEMETRYVERSION, 2, 1, 1, 1, 0, 0, 0, 0, 0, 1, 127, 0x80, 0x01, 0, 0, 0, 0, 0};
+  CHECK(frame == expected);
+  decoded.clear();
+  CHECK(decode(frame, &decoded) && decoded.size() == 2);
+  CHECK(decoded.size() == 2 && lroundf(decoded[1].tempF * 10) == -65 && decoded[1].setpointF == 63);
+
+  // Nothing recorded, nothing to flush or peek, and too small a buffer is refused
+  Telemetry empty;
+  empty.flush();
+  CHECK(empty.pending() == 0 && !empty.peek(text, sizeof(text)));
+  CHECK(!small.peek(text, 8));
+  return host::finish("TelemetryTest");
+}
@@ -0,0 +1,104 @@
+// Feeds the probe pipeline conversions the way the sensor task does and checks what gets through:
+// the filter follows a heating ramp, glitches and flagged frames are dropped, a run of them latches
+// the fault, and a step the estimate lost track of is picked up again once frames agree on it.
+#include "HostTest.h"
+#include "TemperatureProbe.h"
+
+namespace {
+
+unsigned int now;
+
+// One conversion period later
+void feed(TemperatureProbe *probe, float reading, uint8_t status = STATUS_OK) {
+  now += MAX6675CONVERSION;
+  probe->update(status, reading, now);
+}
+
+}
+
+int main() {
+  now = 0;
+
+  // Settles on a steady oven and tracks a 1 C/s ramp with the rate
+  TemperatureProbe probe;
+  CHECK(!probe.isValid());
+  for(int i = 0; i < 50; i++) {
+    feed(&probe, 100);
+  }
+  CHECK(probe.isValid());
+  CHECK(fabsf(probe.getTemperature() - 100) < 0.1);
+  CHECK(fabsf(probe.getTemperatureF() - 212) < 0.2);
+  for(int i = 1; i <= 300; i++) {
+    feed(&probe, 100 + i * MAX6675CONVERSION / 1000.0);
+  }
+  printf("TemperatureProbe: ramp at %.2f C/s, %.1f C behind\n", probe.getRate(),
+         100 + 300 * MAX6675CONVERSION / 1000.0 - probe.getTemperature());
+  CHECK(fabsf(probe.getRate() - 1.0) < 0.1);
+  CHECK(fabsf(probe.getTemperature() - (100 + 300 * MAX6675CONVERSION / 1000.0)) < 2);
+
+  // Single glitches, a jump and an impossible reading, don't move the estimate
+  TemperatureProbe glitch;
+  for(int i = 0; i < 20; i++) {
+    feed(&glitch, 180);
+  }
+  feed(&glitch, 400);
+  feed(&glitch, 180);
+  feed(&glitch, 1020);
+  feed(&glitch, 180);
+  CHECK(fabsf(glitch.getTemperature() - 180) < 0.5);
+  CHECK(glitch.getBadFrames() == 2);
+  CHECK(!glitch.isFaulted());
+  CHECK(glitch.getReseeds() == 0);
+
+  // A run of open thermocouple frames latches the fault until it is cleared
+  TemperatureProbe open;
+  for(int i = 0; i < 20; i++) {
+    feed(&open, 180);
+  }
+  for(int i = 0; i < PROBEFAULTLIMIT - 1; i++) {
+    feed(&open, 0, STATUS_ERROR);
+  }
+  CHECK(!open.isFaulted());
+  feed(&open, 0, STATUS_ERROR);
+  CHECK(open.isFaulted());
+  CHECK(!open.isValid());
+  CHECK(open.getFaultStatus() == STATUS_ERROR);
+  feed(&open, 180);
+  CHECK(open.isFaulted());
+  open.clearFault();
+  feed(&open, 60);
+  CHECK(open.isValid());
+  CHECK(fabsf(open.getTemperature() - 60) < 0.1);
+
+  // The probe comes back from a few bad frames to an oven that moved on, the jump is real and the
+  // estimate starts again there instead of rejecting every frame until the fault latches
+  TemperatureProbe step;
+  for(int i = 0; i < 20; i++) {
+    feed(&step, 100);
+  }
+  for(int i = 0; i < 2; i++) {
+    feed(&step, 0, STATUS_ERROR);
+  }
+  for(int i = 0; i < 20; i++) {
+    feed(&step, 160 + i * 0.2);
+  }
+  printf("  step to 160 C: %u reseeds, %u bad frames, estimate %.1f C\n", step.getReseeds(), step.getBadFrames(),
+         step.getTemperature());
+  CHECK(!step.isFaulted());
+  CHECK(step.getReseeds() == 1);
+  CHECK(step.getBadFrames() == 2 + PROBERESEED - 1);
+  CHECK(fabsf(step.getTemperature() - 163.8) < 1);
+
+  // Jumps that don't agree with each other are noise, they never restart the estimate
+  TemperatureProbe noisy;
+  for(int i = 0; i < 20; i++) {
+    feed(&noisy, 100);
+  }
+  for(int i = 0; i < PROBEFAULTLIMIT; i++) {
+    feed(&noisy, (i % 2) ? 300 : 500);
+  }
+  CHECK(noisy.getReseeds() == 0);
+  CHECK(noisy.isFaulted());
+  CHECK(fabsf(noisy.getTemperature() - 100) < 0.5);
+  return host::finish("TemperatureProbeTest");
+}
@@ -0,0 +1,88 @@
+// Cost per 1 ms tick of the timer wheel against polling every timer each tick, the way the IoTTimer
+// instances were checked from loop(), for 4, 40 and 400 timers restarting with random periods up to
+// two hours. Wall time, so only the ratio between the two means much.
+#include "TimerWheel.h"
+#include <array>
+#include <chrono>
+#include <random>
+#include <utility>
+
+namespace {
+
+const int MAXTIMERS = 400;
+const uint64_t TICKS = 3600000;      // An hour of 1 ms ticks
+const uint64_t LONGEST = 2 * 3600000;
+
+TimerWheel *wheel;
+WheelTimer timers[MAXTIMERS];
+unsigned fires;
+std::mt19937_64 rng(7);
+
+uint64_t period() {
+  return 1000 + rng() % LONGEST;
+}
+
+template<int I>
+void expired() {
+  fires++;
+  wheel->start(&timers[I], period(), expired<I>);
+}
+
+template<size_t... I>
+std::array<timerFunction, sizeof...(I)> functions(std::index_sequence<I...>) {
+  return {expired<I>...};
+}
+
+const std::array<timerFunction, MAXTIMERS> callbacks = functions(std::make_index_sequence<MAXTIMERS>());
+
+struct polledTimer {
+  uint64_t start, period;
+} polled[MAXTIMERS];
+
+double nsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+int main() {
+  for(int count : {4, 40, 400}) {
+    TimerWheel timerWheel;
+    unsigned polledFires;
+    double wheelNs, pollNs;
+
+    wheel = &timerWheel;
+    fires = 0;
+    timerWheel.begin(1);
+    for(int i = 0; i < count; i++) {
+      timerWheel.start(&timers[i], period(), callbacks[i]);
+    }
+    auto start = std::chrono::steady_clock::now();
+    for(uint64_t tick = 2; tick < TICKS + 2; tick++) {
+      timerWheel.update(tick);
+    }
+    wheelNs = nsSince(start);
+    for(int i = 0; i < count; i++) {
+      timerWheel.stop(&timers[i]);
+    }
+
+    polledFires = 0;
+    for(int i = 0; i < count; i++) {
+      polled[i] = {0, period()};
+    }
+    start = std::chrono::steady_clock::now();
+    for(uint64_t tick = 0; tick < TICKS; tick++) {
+      for(int i = 0; i < count; i++) {
+        if(tick - polled[i].start >= polled[i].period) {
+          polledFires++;
+          polled[i] = {tick, period()};
+        }
+      }
+    }
+    pollNs = nsSince(start);
+
+    printf("TimerWheel: %3d timers, wheel %.2f ns/tick (%u expiries), polling %.2f ns/tick (%u)\n", count,
+           wheelNs / TICKS, fires, pollNs / TICKS, polledFires);
+  }
+  return 0;
+}
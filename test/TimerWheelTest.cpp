@@ -0,0 +1,184 @@
+// Runs timers on the wheel from a fake millisecond clock and checks each one runs out on the tick it
+// is due: either side of every level boundary and past the top of the wheel, stopped and restarted,
+// paused and resumed with the time left, across a rebase after sleep, and through twelve hours of
+// random timers restarting themselves from their callbacks while the clock stalls and jumps.
+#include "HostTest.h"
+#include "TimerWheel.h"
+#include <array>
+#include <random>
+#include <utility>
+
+namespace {
+
+const int TIMERS = 64;
+const uint64_t STEP = 1000;          // ms per update(), the most update() steps tick by tick
+const uint64_t EPOCH = 1000000000000ULL;
+
+TimerWheel wheel;
+WheelTimer timers[TIMERS];
+uint64_t due[TIMERS];
+unsigned fires[TIMERS];
+unsigned late;
+bool churn;
+std::mt19937_64 rng(1);
+
+uint64_t between(uint64_t low, uint64_t high) {
+  return low + rng() % (high - low + 1);
+}
+
+// Counts the expiry and checks it came on time, then under churn starts the timer again, some of
+// them further out than the wheel reaches
+template<int I>
+void expired() {
+  fires[I]++;
+  if(wheel.now() != due[I]) {
+    if(late < 5) {
+      printf("  timer %d ran out at %llu, due %llu\n", I, (unsigned long long)(wheel.now() - EPOCH),
+             (unsigned long long)(due[I] - EPOCH));
+    }
+    late++;
+  }
+  if(churn) {
+    uint64_t msec = between(0, I % 3 == 0 ? 20000000 : 300000);
+    due[I] = wheel.now() + msec;
+    wheel.start(&timers[I], msec, expired<I>);
+  }
+}
+
+template<size_t... I>
+std::array<timerFunction, sizeof...(I)> functions(std::index_sequence<I...>) {
+  return {expired<I>...};
+}
+
+const std::array<timerFunction, TIMERS> callbacks = functions(std::make_index_sequence<TIMERS>());
+
+void start(int i, uint64_t msec) {
+  due[i] = wheel.now() + msec;
+  wheel.start(&timers[i], msec, callbacks[i]);
+}
+
+// Moves the clock to time, STEP ms per update()
+void runTo(uint64_t time) {
+  while(wheel.now() + STEP < time) {
+    wheel.update(wheel.now() + STEP);
+  }
+  wheel.update(time);
+}
+
+}
+
+int main() {
+  const uint64_t distances[] = {0, 1, 63, 64, 65, 4095, 4096, 4097, 262143, 262144, 262145,
+                                WHEELRANGE - 1, WHEELRANGE, WHEELRANGE + 1, 3 * WHEELRANGE + 7};
+  const int COUNT = sizeof(distances) / sizeof(distances[0]);
+  uint64_t paused;
+  unsigned before, after;
+  int i;
+  bool once;
+
+  wheel.begin(EPOCH);
+
+  // Either side of each level and past the top, every timer runs out on its own tick and only once
+  for(int i = 0; i < COUNT; i++) {
+    start(i, distances[i]);
+  }
+  CHECK(wheel.running() == COUNT);
+  CHECK(wheel.getRemaining(&timers[COUNT - 1]) == distances[COUNT - 1]);
+  runTo(EPOCH + 4 * WHEELRANGE);
+  once = true;
+  for(int i = 0; i < COUNT; i++) {
+    once = once && fires[i] == 1 && timers[i].isExpired();
+  }
+  CHECK(once);
+  CHECK(late == 0);
+  CHECK(wheel.running() == 0);
+  CHECK(wheel.rebases() == 0);
+
+  // Stopped and restarted timers
+  start(0, 500);
+  start(1, 500);
+  wheel.stop(&timers[0]);
+  runTo(wheel.now() + 100);
+  start(1, 500);
+  runTo(wheel.now() + 499);
+  CHECK(fires[0] == 1 && fires[1] == 1);
+  CHECK(timers[0].getState() == TIMER_IDLE && timers[1].isRunning());
+  runTo(wheel.now() + 1);
+  CHECK(fires[1] == 2);
+
+  // Paused for longer than it had left, it still has the same time to go once resumed
+  start(2, 3000);
+  runTo(wheel.now() + 1000);
+  wheel.pause(&timers[2]);
+  CHECK(timers[2].isPaused() && wheel.getRemaining(&timers[2]) == 2000);
+  runTo(wheel.now() + 10000);
+  CHECK(fires[2] == 1 && wheel.getRemaining(&timers[2]) == 2000);
+  wheel.resume(&timers[2]);
+  due[2] = wheel.now() + 2000;
+  runTo(wheel.now() + 2000);
+  CHECK(fires[2] == 2);
+
+  // Asleep for an hour, a timer due in the meantime runs out on the first update after the rebase,
+  // one due later keeps its time
+  start(3, 60000);
+  start(4, 2 * 3600000);
+  wheel.rebase(wheel.now() + 3600000);
+  due[3] = wheel.now();
+  CHECK(wheel.getRemaining(&timers[4]) == 3600000);
+  wheel.update(wheel.now());
+  CHECK(fires[3] == 2);
+  runTo(due[4]);
+  CHECK(fires[4] == 2);
+  CHECK(wheel.rebases() == 1);
+  CHECK(late == 0);
+
+  // Twelve hours of churn at 1 ms updates with stalls, jumps and pauses thrown in
+  churn = true;
+  before = 0;
+  for(int i = 0; i < TIMERS; i++) {
+    before += fires[i];
+    start(i, between(0, 5000000));
+  }
+  uint64_t end = wheel.now() + 12 * 3600000ULL;
+  while(wheel.now() < end) {
+    int roll = rng() % 1000000;
+    i = rng() % TIMERS;
+    if(roll == 0) {
+      // A stall, the next update() steps through it
+      wheel.update(wheel.now() + between(2, WHEELREBASE));
+    }
+    else if(roll == 1) {
+      // A jump, everything overdue runs out at the new time
+      uint64_t now = wheel.now() + between(WHEELREBASE + 1, 300000);
+      for(int j = 0; j < TIMERS; j++) {
+        if(timers[j].isRunning() && due[j] < now) {
+          due[j] = now;
+        }
+      }
+      wheel.update(now);
+    }
+    else if(roll == 2 && timers[i].isRunning()) {
+      // Paused for a while, it has the same time left when it carries on
+      paused = wheel.getRemaining(&timers[i]);
+      late += paused != due[i] - wheel.now();
+      wheel.pause(&timers[i]);
+      runTo(wheel.now() + between(1, 50000));
+      late += wheel.getRemaining(&timers[i]) != paused;
+      due[i] = wheel.now() + paused;
+      wheel.resume(&timers[i]);
+    }
+    else {
+      wheel.update(wheel.now() + 1);
+    }
+  }
+  after = 0;
+  for(int i = 0; i < TIMERS; i++) {
+    after += fires[i];
+  }
+  printf("TimerWheel: %u expiries in 12 h of churn, %u rebases, %d running, %u late\n", after - before,
+         wheel.rebases(), wheel.running(), late);
+  CHECK(late == 0);
+  CHECK(after - before > 5000);
+  CHECK(wheel.running() == TIMERS);
+  return host::finish("TimerWheelTest");
+}
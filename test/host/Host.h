@@ -0,0 +1,100 @@
+// Controls the host build from a test: the virtual clock, pin levels, and the fakes sitting on the
+// other end of the buses. Nothing here exists on the device.
+#ifndef _HOST_H_
+#define _HOST_H_
+
+#include "Particle.h"
+#include <string>
+#include <vector>
+
+namespace host {
+
+// Virtual clock in us. Every millis()/micros() read or UART poll moves it on by the read cost (1 us by
+// default) so busy waits finish, and delay() moves it by the delay.
+uint64_t now();
+void advance(uint64_t us);
+void setReadCost(uint64_t us);
+// Aborts the run if the clock passes at, so firmware stuck in a loop fails instead of hanging
+void setDeadline(uint64_t at);
+
+// Whether Time has been synced, until it is Time.now() counts seconds from 1970. Synced at power on.
+void setTimeValid(bool valid);
+
+// Runs fn (an interrupt or a DMA completion) once the clock reaches at
+void schedule(uint64_t at, std::function<void()> fn);
+
+// Drives an input pin from outside and runs its interrupt handler on a matching edge
+void setPin(pin_t pin, int level);
+int getPin(pin_t pin);
+
+// Everything printed to Serial, a line at a time. Echoed to stdout when verbose, which V=1 in the
+// environment turns on.
+void setVerbose(bool verbose);
+const std::vector<std::string> &serialLines();
+bool serialContains(const char *text);
+void clearSerial();
+
+class I2CDevice {
+  public:
+    virtual ~I2CDevice() {}
+    // A write transaction, returns false to NACK it
+    virtual bool receive(const uint8_t *data, size_t length) = 0;
+    // A read transaction, fills up to length bytes and returns how many were sent
+    virtual size_t request(uint8_t *data, size_t length) = 0;
+};
+void attachI2C(uint8_t address, I2CDevice *device);
+
+class SpiDevice {
+  public:
+    virtual ~SpiDevice() {}
+    // One transfer while the device is selected, rx is NULL for a write only transfer
+    virtual void transfer(const uint8_t *tx, uint8_t *rx, size_t length) = 0;
+};
+// The device answers while its chip select is low, PIN_INVALID for a device that is always selected
+void attachSpi(int interface, pin_t select, SpiDevice *device);
+// SPI clock used to time DMA transfers
+unsigned getSpiClock(int interface);
+// A device read over bit-banged GPIO the way the MAX6675 is: the bytes of one transfer (up to 4) are
+// fetched when select goes low, the first bit is on miso straight away and each rising clock edge
+// moves to the next, MSB first
+void attachSoftSpi(pin_t clock, pin_t select, pin_t miso, SpiDevice *device);
+// What each digitalWrite() and digitalRead() costs on the device in ns, free by default
+void setGpioCost(unsigned ns);
+
+class SerialDevice {
+  public:
+    virtual ~SerialDevice() {}
+    virtual void receive(uint8_t c) = 0;
+    // Bytes the device has sent that are ready to read
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+void attachSerial(int index, SerialDevice *device);
+
+// TCP peer, a NULL peer or a refused connect leaves connect() returning false
+class TcpPeer {
+  public:
+    virtual ~TcpPeer() {}
+    virtual bool accept() = 0;
+    virtual void receive(const uint8_t *data, size_t length) = 0;
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual bool connected() = 0;
+    virtual void close() = 0;
+};
+void attachTcp(TcpPeer *peer);
+void setNetwork(bool wifiReady, IPAddress resolved);
+// Virtual time a DNS lookup and a TCP connect take
+void setNetworkDelays(unsigned resolveMs, unsigned connectMs);
+
+// System.sleep() calls fn and wakes for the reason it returns, by default wakes on the GPIO at once
+void onSleep(std::function<SystemSleepWakeupReason(const SystemSleepConfiguration &)> fn);
+unsigned sleepCount();
+
+// Puts the clock, pins, log and fakes back to power on
+void reset();
+
+}
+
+#endif // _HOST_H_
@@ -0,0 +1,569 @@
+#include "HostDevices.h"
+#include <algorithm>
+
+namespace {
+
+const uint8_t PN532ACK[6] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
+const unsigned PN532ACKTIME = 300;        // us from the command to the ACK being ready
+const unsigned PN532RESPONSETIME = 1000;  // us from the ACK to a response
+const unsigned PN532CARDTIME = 5000;      // us to select, authenticate or read a card
+const uint8_t PN532OK = 0x00;
+const uint8_t PN532TIMEOUT = 0x01;
+const uint8_t PN532AUTHERROR = 0x14;
+
+const unsigned DFPLAYERREPLYTIME = 20000; // us for the module to answer a command
+
+const uint8_t MQTTCONNECT = 1, MQTTCONNECTACK = 2, MQTTPUBLISH = 3, MQTTPUBACK = 4, MQTTSUBSCRIBE = 8, MQTTSUBACK = 9;
+const uint8_t MQTTPINGREQ = 12, MQTTPINGRESP = 13;
+
+}
+
+/**************************** PN532 ****************************/
+
+FakePN532::FakePN532() {
+  const uint8_t uid[4] = {0xDE, 0xAD, 0xBE, 0xEF};
+
+  _phase = IDLE;
+  _readyAt = 0;
+  _responseDelay = 0;
+  _cardPresent = false;
+  setUid(uid, sizeof(uid));
+  memset(_blocks, 0, sizeof(_blocks));
+  _authSector = -1;
+  _commands = _scans = _reads = _requests = 0;
+  _irq = PIN_INVALID;
+  _irqGeneration = 0;
+}
+
+void FakePN532::writeBlock(int block, const uint8_t *data) {
+  memcpy(_blocks[block], data, 16);
+}
+
+void FakePN532::setUid(const uint8_t *uid, size_t length) {
+  memcpy(_uid, uid, length);
+  _uidLength = length;
+}
+
+void FakePN532::setIrq(pin_t pin) {
+  _irq = pin;
+  host::setPin(_irq, HIGH);
+}
+
+// IRQ high now, then low once the next frame is ready
+void FakePN532::signal() {
+  unsigned generation;
+
+  if(_irq == PIN_INVALID) {
+    return;
+  }
+  host::setPin(_irq, HIGH);
+  generation = ++_irqGeneration;
+  if(_phase != IDLE) {
+    host::schedule(_readyAt, [this, generation]() {
+      if(generation == _irqGeneration) {
+        host::setPin(_irq, LOW);
+      }
+    });
+  }
+}
+
+// Frames the response as 00 00 FF LEN LCS D5 data DCS 00, it is ready once the ACK has been read
+void FakePN532::respond(const std::vector<uint8_t> &data, unsigned delayUs) {
+  uint8_t sum, len;
+
+  len = data.size() + 1;
+  sum = 0xD5;
+  _response.assign({0x00, 0x00, 0xFF, len, (uint8_t)(0x100 - len), 0xD5});
+  for(uint8_t b : data) {
+    _response.push_back(b);
+    sum += b;
+  }
+  _response.push_back((uint8_t)(0x100 - sum));
+  _response.push_back(0x00);
+  _responseDelay = delayUs;
+  _phase = ACKREADY;
+  _readyAt = host::now() + PN532ACKTIME;
+  signal();
+}
+
+void FakePN532::command(const uint8_t *data, size_t length) {
+  int block;
+
+  _commands++;
+  switch(data[0]) {
+    case 0x14:   // SAMConfiguration
+      respond({0x15}, PN532RESPONSETIME);
+      break;
+    case 0x4A:   // InListPassiveTarget, one 106 kbps type A target
+      _scans++;
+      _authSector = -1;
+      if(!_cardPresent) {
+        respond({0x4B, 0x00}, PN532RESPONSETIME);
+        break;
+      }
+      {
+        // Tg, SENS_RES, SEL_RES and the UID: 00 04 08 for a Classic 1k, 00 44 00 for an Ultralight
+        std::vector<uint8_t> reply = {0x4B, 0x01, 0x01, 0x00, (uint8_t)(_uidLength == 4 ? 0x04 : 0x44),
+                                      (uint8_t)(_uidLength == 4 ? 0x08 : 0x00), (uint8_t)_uidLength};
+        reply.insert(reply.end(), _uid, _uid + _uidLength);
+        respond(reply, PN532CARDTIME);
+      }
+      break;
+    case 0x40:   // InDataExchange, data[1] is the target and data[2] the MIFARE command
+      if(length < 4 || !_cardPresent) {
+        respond({0x41, PN532TIMEOUT}, PN532CARDTIME);
+        break;
+      }
+      block = data[3];
+      if((data[2] == 0x60 || data[2] == 0x61) && block < 64) {
+        // Key A or B followed by the UID, the fake card has the transport key FF FF FF FF FF FF
+        bool keyOk = length >= 14 && memcmp(data + 10, _uid, 4) == 0;
+        for(int i = 4; keyOk && i < 10; i++) {
+          keyOk = data[i] == 0xFF;
+        }
+        _authSector = keyOk ? block / 4 : -1;
+        respond({0x41, keyOk ? PN532OK : PN532AUTHERROR}, PN532CARDTIME);
+      }
+      else if(data[2] == 0x30 && block < 64 && (block / 4 == _authSector || _uidLength != 4)) {
+        std::vector<uint8_t> reply = {0x41, PN532OK};
+        reply.insert(reply.end(), _blocks[block], _blocks[block] + 16);
+        _reads++;
+        respond(reply, PN532CARDTIME);
+      }
+      else {
+        respond({0x41, PN532AUTHERROR}, PN532CARDTIME);
+      }
+      break;
+    default:
+      respond({(uint8_t)(data[0] + 1)}, PN532RESPONSETIME);
+      break;
+  }
+}
+
+bool FakePN532::receive(const uint8_t *data, size_t length) {
+  uint8_t len, sum;
+
+  // 00 00 FF LEN LCS D4 command... DCS 00
+  if(length < 8 || data[0] != 0x00 || data[1] != 0x00 || data[2] != 0xFF) {
+    return true;
+  }
+  len = data[3];
+  if((uint8_t)(len + data[4]) != 0 || (size_t)(len + 7) > length || data[5] != 0xD4) {
+    return true;
+  }
+  sum = 0;
+  for(int i = 5; i < 5 + len + 1; i++) {
+    sum += data[i];
+  }
+  if(sum == 0) {
+    command(data + 6, len - 1);
+  }
+  return true;
+}
+
+// Every read starts with the status byte, bit 0 set once the next frame is ready
+size_t FakePN532::request(uint8_t *data, size_t length) {
+  bool ready;
+  const uint8_t *frame;
+  size_t frameLength;
+
+  _requests++;
+  ready = _phase != IDLE && host::now() >= _readyAt;
+  data[0] = ready ? 0x01 : 0x00;
+  memset(data + 1, 0, length - 1);
+  if(!ready || length == 1) {
+    return length;
+  }
+  if(_phase == ACKREADY) {
+    frame = PN532ACK;
+    frameLength = sizeof(PN532ACK);
+  }
+  else {
+    frame = _response.data();
+    frameLength = _response.size();
+  }
+  memcpy(data + 1, frame, min(frameLength, length - 1));
+  if(_phase == ACKREADY) {
+    _phase = RESPONSEREADY;
+    _readyAt = host::now() + _responseDelay;
+  }
+  else {
+    _phase = IDLE;
+  }
+  signal();
+  return length;
+}
+
+/**************************** DFPlayer ****************************/
+
+FakeDFPlayer::FakeDFPlayer() {
+  _index = 0;
+  _clipLength = 3000;
+  _generation = 0;
+  _playing = 0;
+  _volume = 30;
+}
+
+// 7E FF 06 command 00 parameter checksum EF, the checksum is minus the sum of version to parameter
+void FakeDFPlayer::send(uint8_t command, uint16_t parameter) {
+  uint16_t sum;
+
+  sum = -(0xFF + 0x06 + command + 0x00 + (parameter >> 8) + (parameter & 0xFF));
+  for(uint8_t b : {(uint8_t)0x7E, (uint8_t)0xFF, (uint8_t)0x06, command, (uint8_t)0x00, (uint8_t)(parameter >> 8),
+                   (uint8_t)parameter, (uint8_t)(sum >> 8), (uint8_t)sum, (uint8_t)0xEF}) {
+    _rx.push_back(b);
+  }
+}
+
+void FakeDFPlayer::command(uint8_t command, uint16_t parameter, bool ack) {
+  unsigned generation;
+  int track;
+
+  if(ack) {
+    send(0x41, 0);
+  }
+  switch(command) {
+    case 0x03:   // Play track
+      track = parameter;
+      generation = ++_generation;
+      _playing = track;
+      plays.push_back({host::now(), track});
+      host::schedule(host::now() + _clipLength * 1000ULL, [this, generation, track]() {
+        if(generation != _generation) {
+          return;
+        }
+        _playing = 0;
+        send(0x3D, track);
+        send(0x3D, track);
+      });
+      break;
+    case 0x04:
+      _volume = min(_volume + 1, 30);
+      break;
+    case 0x05:
+      _volume = max(_volume - 1, 0);
+      break;
+    case 0x06:
+      _volume = parameter;
+      break;
+    case 0x0C:   // Reset, the SD card comes back online a little later
+      _generation++;
+      _playing = 0;
+      host::schedule(host::now() + DFPLAYERREPLYTIME, [this]() {
+        send(0x3F, 0x02);
+      });
+      break;
+    case 0x0E:   // Pause
+    case 0x16:   // Stop
+      _generation++;
+      _playing = 0;
+      break;
+    default:
+      break;
+  }
+}
+
+void FakeDFPlayer::receive(uint8_t c) {
+  uint16_t sum;
+
+  if(_index == 0 && c != 0x7E) {
+    return;
+  }
+  _frame[_index++] = c;
+  if(_index < 10) {
+    return;
+  }
+  _index = 0;
+  sum = 0;
+  for(int i = 1; i < 7; i++) {
+    sum += _frame[i];
+  }
+  if(_frame[9] != 0xEF || (uint16_t)(sum + ((_frame[7] << 8) | _frame[8])) != 0) {
+    return;
+  }
+  command(_frame[3], (_frame[5] << 8) | _frame[6], _frame[4] != 0);
+}
+
+int FakeDFPlayer::read() {
+  int c;
+
+  if(_rx.empty()) {
+    return -1;
+  }
+  c = _rx.front();
+  _rx.pop_front();
+  return c;
+}
+
+int FakeDFPlayer::count(int track) {
+  int n = 0;
+
+  for(const play &p : plays) {
+    n += (p.track == track);
+  }
+  return n;
+}
+
+/**************************** SSD1306 ****************************/
+
+FakeSSD1306::FakeSSD1306() {
+  _command = 0;
+  _parameters = 0;
+  _colStart = _col = 0;
+  _colEnd = 127;
+  _pageStart = _page = 0;
+  _pageEnd = 7;
+  memset(ram, 0, sizeof(ram));
+}
+
+// Commands and their parameters each come as a byte after a 0x00 control byte
+void FakeSSD1306::command(uint8_t c) {
+  if(_parameters > 0) {
+    _parameter[_command == 0x21 || _command == 0x22 ? 2 - _parameters : 0] = c;
+    if(--_parameters > 0) {
+      return;
+    }
+    if(_command == 0x21) {
+      _colStart = _col = _parameter[0] & 0x7F;
+      _colEnd = _parameter[1] & 0x7F;
+    }
+    else if(_command == 0x22) {
+      _pageStart = _page = _parameter[0] & 0x07;
+      _pageEnd = _parameter[1] & 0x07;
+    }
+    return;
+  }
+  _command = c;
+  switch(c) {
+    case 0x21:   // Column address, start and end
+    case 0x22:   // Page address, start and end
+      _parameters = 2;
+      break;
+    case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3: case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+      _parameters = 1;
+      break;
+    default:
+      break;
+  }
+}
+
+bool FakeSSD1306::receive(const uint8_t *data, size_t length) {
+  transactions++;
+  bytes += length;
+  largest = max(largest, length);
+  if(length < 2) {
+    return true;
+  }
+  if(data[0] == 0x00) {
+    for(size_t i = 1; i < length; i++) {
+      command(data[i]);
+    }
+  }
+  else if(data[0] == 0x40) {
+    // Horizontal addressing, wraps to the next page at the end of the column window
+    for(size_t i = 1; i < length; i++) {
+      ram[_page][_col] = data[i];
+      if(++_col > _colEnd) {
+        _col = _colStart;
+        if(++_page > _pageEnd) {
+          _page = _pageStart;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/**************************** MAX6675 ****************************/
+
+void FakeMAX6675::transfer(const uint8_t *tx, uint8_t *rx, size_t length) {
+  uint16_t frame;
+
+  (void)tx;
+  if(rx == NULL) {
+    return;
+  }
+  frame = _source();
+  for(size_t i = 0; i < length; i++) {
+    rx[i] = (i == 0) ? frame >> 8 : (i == 1) ? frame & 0xFF : 0;
+  }
+}
+
+/**************************** NeoPixel strip ****************************/
+
+void FakeNeoPixelStrip::transfer(const uint8_t *tx, uint8_t *rx, size_t length) {
+  (void)rx;
+  lastFrame.assign(tx, tx + length);
+  frames++;
+}
+
+bool FakeNeoPixelStrip::decode(std::vector<uint8_t> *bytes) {
+  size_t first, last;
+  int bit, count;
+  uint8_t value, pattern;
+
+  bytes->clear();
+  // The latch padding on both ends is all zeros, a zero pixel byte still has a one in every bit
+  first = 0;
+  while(first < lastFrame.size() && lastFrame[first] == 0) {
+    first++;
+  }
+  last = lastFrame.size();
+  while(last > first && lastFrame[last - 1] == 0) {
+    last--;
+  }
+  if((last - first) % 3 != 0) {
+    return false;
+  }
+  value = 0;
+  count = 0;
+  pattern = 0;
+  bit = 0;
+  for(size_t i = first; i < last; i++) {
+    for(int b = 7; b >= 0; b--) {
+      pattern = (pattern << 1) | ((lastFrame[i] >> b) & 1);
+      if(++bit < 3) {
+        continue;
+      }
+      bit = 0;
+      if((pattern & 0x07) != 0x06 && (pattern & 0x07) != 0x04) {
+        return false;
+      }
+      value = (value << 1) | ((pattern & 0x07) == 0x06);
+      pattern = 0;
+      if(++count == 8) {
+        bytes->push_back(value);
+        value = 0;
+        count = 0;
+      }
+    }
+  }
+  return true;
+}
+
+/**************************** MQTT broker ****************************/
+
+bool FakeMqttBroker::accept() {
+  if(!up) {
+    return false;
+  }
+  _rx.clear();
+  _tx.clear();
+  _connected = true;
+  connects++;
+  return true;
+}
+
+void FakeMqttBroker::close() {
+  _connected = false;
+  _rx.clear();
+  _tx.clear();
+}
+
+// TCP keeps order, a byte never arrives ahead of the one before it even if the latency drops
+void FakeMqttBroker::send(const std::vector<uint8_t> &packet) {
+  uint64_t at = host::now() + latency;
+
+  if(!_tx.empty()) {
+    at = max(at, _tx.back().first);
+  }
+  for(uint8_t b : packet) {
+    _tx.push_back({at, b});
+  }
+}
+
+void FakeMqttBroker::publish(const std::string &topic, const std::string &payload) {
+  size_t length = 2 + topic.size() + payload.size();
+  std::vector<uint8_t> p = {MQTTPUBLISH << 4};
+
+  do {
+    p.push_back((length & 0x7F) | (length > 0x7F ? 0x80 : 0));
+    length >>= 7;
+  } while(length > 0);
+  p.push_back(topic.size() >> 8);
+  p.push_back(topic.size() & 0xFF);
+  p.insert(p.end(), topic.begin(), topic.end());
+  p.insert(p.end(), payload.begin(), payload.end());
+  send(p);
+}
+
+void FakeMqttBroker::packet(const uint8_t *data) {
+  uint8_t type = data[0] >> 4;
+  size_t header = 2;
+
+  while(data[header - 1] & 0x80) {
+    header++;
+  }
+  packets[type]++;
+  switch(type) {
+    case MQTTCONNECT:
+      send({MQTTCONNECTACK << 4, 2, 0, 0});
+      break;
+    case MQTTSUBSCRIBE: {
+      std::string topic((const char *)data + header + 4, (data[header + 2] << 8) | data[header + 3]);
+      for(const std::string &payload : early) {
+        publish(topic, payload);
+      }
+      send({MQTTSUBACK << 4, 3, data[header], data[header + 1], 0});
+      break;
+    }
+    case MQTTPUBLISH: {
+      size_t remaining = 0, topicLength = (data[header] << 8) | data[header + 1];
+      size_t id = header + 2 + topicLength, payload = id;
+      for(size_t i = 1; i < header; i++) {
+        remaining |= (size_t)(data[i] & 0x7F) << (7 * (i - 1));
+      }
+      if(data[0] & 0x06) {
+        payload += 2;
+        send({MQTTPUBACK << 4, 2, data[id], data[id + 1]});
+      }
+      received.push_back({std::string((const char *)data + header + 2, topicLength),
+                          std::string((const char *)data + payload, header + remaining - payload),
+                          (uint16_t)((data[0] & 0x06) ? (data[id] << 8) | data[id + 1] : 0), (data[0] & 0x08) != 0});
+      break;
+    }
+    case MQTTPINGREQ:
+      if(answerPings) {
+        send({MQTTPINGRESP << 4, 0});
+      }
+      break;
+  }
+}
+
+void FakeMqttBroker::receive(const uint8_t *data, size_t length) {
+  _rx.insert(_rx.end(), data, data + length);
+  // Takes every whole packet, a write can hold several or end part way through one
+  while(_rx.size() >= 2) {
+    size_t header = 1, remaining = 0;
+    int shift = 0;
+    do {
+      if(header >= _rx.size()) {
+        return;
+      }
+      remaining |= (size_t)(_rx[header] & 0x7F) << shift;
+      shift += 7;
+    } while(_rx[header++] & 0x80);
+    if(_rx.size() < header + remaining) {
+      return;
+    }
+    packet(_rx.data());
+    _rx.erase(_rx.begin(), _rx.begin() + header + remaining);
+  }
+}
+
+int FakeMqttBroker::available() {
+  uint64_t now = host::now();
+
+  return std::upper_bound(_tx.begin(), _tx.end(), now, [](uint64_t t, const std::pair<uint64_t, uint8_t> &b) {
+    return t < b.first;
+  }) - _tx.begin();
+}
+
+int FakeMqttBroker::read() {
+  if(_tx.empty() || _tx.front().first > host::now()) {
+    return -1;
+  }
+  uint8_t b = _tx.front().second;
+  _tx.pop_front();
+  return b;
+}
@@ -0,0 +1,171 @@
+// Fakes for the parts on the Smart Cooker board, each speaking the wire protocol its driver expects
+#ifndef _HOSTDEVICES_H_
+#define _HOSTDEVICES_H_
+
+#include "Host.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+// PN532 on I2C with a MIFARE Classic 1k card that can be put on and taken off the reader, or with a
+// 7 byte UID an Ultralight that reads without authentication. Every command is ACKed, the response
+// frame becomes ready a little later, as on the chip.
+class FakePN532 : public host::I2CDevice {
+  enum phase { IDLE, ACKREADY, RESPONSEREADY };
+
+  phase _phase;
+  uint64_t _readyAt;
+  std::vector<uint8_t> _response;
+  unsigned _responseDelay;     // us from the ACK being read to the response being ready
+  bool _cardPresent;
+  uint8_t _uid[10];
+  size_t _uidLength;
+  uint8_t _blocks[64][16];
+  int _authSector;
+  unsigned _commands, _scans, _reads, _requests;
+  pin_t _irq;
+  unsigned _irqGeneration;     // Bumped whenever IRQ goes high, a pending fall for an older frame is dropped
+
+  void respond(const std::vector<uint8_t> &data, unsigned delayUs);
+  void signal();
+  void command(const uint8_t *data, size_t length);
+
+  public:
+    FakePN532();
+
+    bool receive(const uint8_t *data, size_t length) override;
+    size_t request(uint8_t *data, size_t length) override;
+
+    void setCard(bool present) { _cardPresent = present; };
+    void writeBlock(int block, const uint8_t *data);
+    void setUid(const uint8_t *uid, size_t length);
+    // Drives IRQ on pin, low while a frame is ready to read, the way the module does
+    void setIrq(pin_t pin);
+    bool cardPresent() { return _cardPresent; };
+    unsigned scans() { return _scans; };
+    unsigned reads() { return _reads; };
+    // I2C read transactions, status polls included
+    unsigned requests() { return _requests; };
+};
+
+// DFPlayer Mini on a UART. ACKs every command, reports the SD card on reset, and sends the play
+// finished message twice once a clip has run its length, the way the module does.
+class FakeDFPlayer : public host::SerialDevice {
+  uint8_t _frame[10];
+  int _index;
+  std::deque<uint8_t> _rx;
+  unsigned _clipLength;
+  unsigned _generation;        // Bumped by every play, a finish for an older clip is dropped
+  int _playing;
+  int _volume;
+
+  void send(uint8_t command, uint16_t parameter);
+  void command(uint8_t command, uint16_t parameter, bool ack);
+
+  public:
+    struct play {
+      uint64_t at;             // us
+      int track;
+    };
+
+    std::vector<play> plays;
+
+    FakeDFPlayer();
+
+    void receive(uint8_t c) override;
+    int available() override { return _rx.size(); };
+    int read() override;
+    int peek() override { return _rx.empty() ? -1 : _rx.front(); };
+
+    void setClipLength(unsigned ms) { _clipLength = ms; };
+    int playing() { return _playing; };
+    int volume() { return _volume; };
+    int count(int track);
+};
+
+// SSD1306 OLED on I2C, 128x64. Follows the column and page address window and writes data into its
+// display RAM in horizontal addressing mode, and counts the transactions and bytes.
+class FakeSSD1306 : public host::I2CDevice {
+  uint8_t _command;            // Command waiting for its parameters
+  int _parameters;
+  uint8_t _parameter[2];
+  int _colStart, _colEnd, _pageStart, _pageEnd;
+  int _col, _page;
+
+  void command(uint8_t c);
+
+  public:
+    uint8_t ram[8][128];
+    unsigned transactions = 0;
+    unsigned bytes = 0;
+    size_t largest = 0;
+
+    FakeSSD1306();
+
+    bool receive(const uint8_t *data, size_t length) override;
+    size_t request(uint8_t *data, size_t length) override { (void)data; (void)length; return 0; };
+
+    bool pixel(int x, int y) { return (ram[y / 8][x] >> (y % 8)) & 1; };
+};
+
+// MAX6675 on a chip select, shifts out whatever 16 bit frame the source gives it
+class FakeMAX6675 : public host::SpiDevice {
+  std::function<uint16_t()> _source;
+
+  public:
+    FakeMAX6675(std::function<uint16_t()> source) : _source(source) {}
+    void transfer(const uint8_t *tx, uint8_t *rx, size_t length) override;
+};
+
+// Keeps the last bitstream sent to a NeoPixel strip over MOSI only SPI
+class FakeNeoPixelStrip : public host::SpiDevice {
+  public:
+    std::vector<uint8_t> lastFrame;
+    unsigned frames = 0;
+
+    void transfer(const uint8_t *tx, uint8_t *rx, size_t length) override;
+
+    // Decodes the WS2812B bits (110 for one, 100 for zero) back into bytes, false if a bit is malformed
+    bool decode(std::vector<uint8_t> *bytes);
+};
+
+// MQTT broker at the other end of the TCP connection. Accepts while it is up, answers CONNECT,
+// SUBSCRIBE, PINGREQ and QoS 1 PUBLISH a round trip later, and counts what the client sent by type.
+class FakeMqttBroker : public host::TcpPeer {
+  std::vector<uint8_t> _rx;                        // From the client, taken a packet at a time
+  std::deque<std::pair<uint64_t, uint8_t>> _tx;    // To the client, with the time each byte arrives
+  bool _connected = false;
+
+  void send(const std::vector<uint8_t> &packet);
+  void packet(const uint8_t *data);
+
+  public:
+    bool up = true;
+    bool answerPings = true;
+    unsigned latency = 20000;  // us
+    unsigned connects = 0;
+    unsigned packets[16] = {}; // By MQTT control packet type
+    std::vector<std::string> early;  // Payloads published to every subscription before its SUBACK
+
+    struct message {
+      std::string topic, payload;
+      uint16_t id;             // 0 for QoS 0
+      bool dup;
+    };
+    std::vector<message> received;   // Every PUBLISH from the client, retransmissions included
+
+    bool accept() override;
+    void receive(const uint8_t *data, size_t length) override;
+    int available() override;
+    int read() override;
+    bool connected() override { return _connected; };
+    void close() override;
+
+    void publish(const std::string &topic, const std::string &payload);
+    // Sends raw bytes, for packets that are malformed or cut short
+    void inject(const std::vector<uint8_t> &bytes) { send(bytes); };
+    // Drops the connection from the broker side
+    void drop() { close(); };
+};
+
+#endif // _HOSTDEVICES_H_
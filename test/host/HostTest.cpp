@@ -0,0 +1,26 @@
+#include "HostTest.h"
+#include <stdio.h>
+
+namespace {
+
+int checks, failures;
+
+}
+
+namespace host {
+
+bool check(bool ok, const char *what, const char *file, int line) {
+  checks++;
+  if(!ok) {
+    failures++;
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+  }
+  return ok;
+}
+
+int finish(const char *name) {
+  printf("%s: %d checks, %d failed\n", name, checks, failures);
+  return failures == 0 ? 0 : 1;
+}
+
+}
@@ -0,0 +1,16 @@
+// Minimal checks for the host tests, a failed check is reported and the test carries on
+#ifndef _HOSTTEST_H_
+#define _HOSTTEST_H_
+
+#define CHECK(condition) host::check((condition), #condition, __FILE__, __LINE__)
+
+namespace host {
+
+bool check(bool ok, const char *what, const char *file, int line);
+
+// Prints the tally, returns the exit code for main()
+int finish(const char *name);
+
+}
+
+#endif // _HOSTTEST_H_
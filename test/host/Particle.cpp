@@ -0,0 +1,961 @@
+#include "Host.h"
+#include <random>
+
+USBSerial Serial;
+USARTSerial Serial1(1);
+Logger Log;
+TwoWire Wire;
+SPIClass SPI(HAL_SPI_INTERFACE1);
+SPIClass SPI1(HAL_SPI_INTERFACE2);
+TimeClass Time;
+CloudClass Particle;
+WiFiClass WiFi;
+SystemClass System;
+EEPROMClass EEPROM;
+
+// Only one of the main thread and a Thread runs at a time, running says whose turn it is
+struct hostThread {
+  std::thread worker;
+  std::mutex lock;
+  std::condition_variable turn;
+  bool running = false;
+  bool done = false;
+
+  // From the main thread, lets the thread run until it delays or returns
+  void resume();
+  // From the thread, hands the clock back and waits to be resumed once us have passed
+  void sleep(uint64_t us);
+};
+
+namespace {
+
+const time32_t EPOCH = 1767225600;   // 2026-01-01 00:00:00 UTC, the clock starts here
+const unsigned I2CBITTIME = 25;      // ns per bit at 400 kHz, times ten
+
+struct scheduledEvent {
+  uint64_t at;
+  std::function<void()> fn;
+};
+
+struct pinState {
+  PinMode mode;
+  int level;
+  bool driven;                 // Set from outside with host::setPin()
+  void (*handler)();
+  InterruptMode edge;
+};
+
+struct spiAttachment {
+  int interface;
+  pin_t select;
+  host::SpiDevice *device;
+};
+
+struct softSpiAttachment {
+  pin_t clock, select, miso;
+  host::SpiDevice *device;
+  uint8_t bytes[4];
+  int bit;
+};
+
+uint64_t clockUs, readCost, deadline;
+std::vector<scheduledEvent> events;
+uint64_t nextEvent;
+pinState pins[TOTAL_PINS];
+std::vector<std::string> lines;
+bool verbose;
+host::I2CDevice *i2cDevices[128];
+std::vector<spiAttachment> spiDevices;
+std::vector<softSpiAttachment> softSpiDevices;
+unsigned gpioCost, gpioNs;
+unsigned spiClock[HAL_PLATFORM_SPI_NUM];
+bool dmaBusy[HAL_PLATFORM_SPI_NUM];
+host::SerialDevice *serialDevices[2];
+host::TcpPeer *tcpPeer;
+bool wifiReady;
+IPAddress resolvedAddress;
+unsigned resolveDelay, connectDelay;
+std::function<SystemSleepWakeupReason(const SystemSleepConfiguration &)> sleepHook;
+unsigned sleeps;
+bool timeValid;
+std::minstd_rand randomSource;
+thread_local hostThread *currentThread;   // NULL on the main thread
+
+void runEvents() {
+  // A thread's wake up is one of the events, they only run on the main thread
+  if(currentThread != NULL) {
+    return;
+  }
+  while(clockUs >= nextEvent) {
+    size_t due = 0;
+    for(size_t i = 1; i < events.size(); i++) {
+      if(events[i].at < events[due].at) {
+        due = i;
+      }
+    }
+    std::function<void()> fn = events[due].fn;
+    events.erase(events.begin() + due);
+    nextEvent = UINT64_MAX;
+    for(size_t i = 0; i < events.size(); i++) {
+      nextEvent = min(nextEvent, events[i].at);
+    }
+    fn();
+  }
+}
+
+void addLine(const std::string &line) {
+  lines.push_back(line);
+  if(verbose) {
+    printf("%10.3f  %s\n", clockUs / 1e6, line.c_str());
+  }
+}
+
+void logLine(const char *level, const char *fmt, va_list args) {
+  char buffer[256];
+  vsnprintf(buffer, sizeof(buffer), fmt, args);
+  addLine(std::string(level) + buffer);
+}
+
+void gpioCall() {
+  gpioNs += gpioCost;
+  if(gpioNs >= 1000) {
+    host::advance(gpioNs / 1000);
+    gpioNs %= 1000;
+  }
+}
+
+// Bit-banged devices see the edge, a selected one puts its next bit on MISO
+void softSpiEdge(pin_t pin, int from, int to) {
+  static const uint8_t zeros[sizeof(softSpiAttachment::bytes)] = {};
+
+  for(softSpiAttachment &attached : softSpiDevices) {
+    if(pin == attached.select && from && !to) {
+      memset(attached.bytes, 0, sizeof(attached.bytes));
+      attached.device->transfer(zeros, attached.bytes, sizeof(attached.bytes));
+      attached.bit = 0;
+    }
+    else if(pin == attached.clock && !from && to && pins[attached.select].level == LOW) {
+      attached.bit++;
+    }
+    else {
+      continue;
+    }
+    int bit = attached.bit;
+    pins[attached.miso].level = bit < 32 ? (attached.bytes[bit / 8] >> (7 - bit % 8)) & 1 : LOW;
+  }
+}
+
+void fireEdge(pin_t pin, int from, int to) {
+  pinState *state = &pins[pin];
+  if(state->handler == NULL || from == to) {
+    return;
+  }
+  if(state->edge == CHANGE || (state->edge == RISING && to) || (state->edge == FALLING && !to)) {
+    state->handler();
+  }
+}
+
+}
+
+/**************************** Host control ****************************/
+
+namespace host {
+
+uint64_t now() {
+  return clockUs;
+}
+
+void advance(uint64_t us) {
+  // Time only passes for a thread in delay(), which hands the clock back to the main thread
+  if(currentThread != NULL) {
+    return;
+  }
+  clockUs += us;
+  if(clockUs > deadline) {
+    fprintf(stderr, "Virtual clock ran past %.3f s, the firmware looks stuck\n", deadline / 1e6);
+    for(size_t i = lines.size() > 10 ? lines.size() - 10 : 0; i < lines.size(); i++) {
+      fprintf(stderr, "  %s\n", lines[i].c_str());
+    }
+    abort();
+  }
+  runEvents();
+}
+
+void setReadCost(uint64_t us) {
+  readCost = us;
+}
+
+void setDeadline(uint64_t at) {
+  deadline = at;
+}
+
+void setTimeValid(bool valid) {
+  timeValid = valid;
+}
+
+void schedule(uint64_t at, std::function<void()> fn) {
+  events.push_back({at, fn});
+  nextEvent = min(nextEvent, at);
+  runEvents();
+}
+
+void setPin(pin_t pin, int level) {
+  int from = pins[pin].level;
+  pins[pin].level = level ? HIGH : LOW;
+  pins[pin].driven = true;
+  fireEdge(pin, from, pins[pin].level);
+}
+
+int getPin(pin_t pin) {
+  return pins[pin].level;
+}
+
+void setVerbose(bool on) {
+  verbose = on;
+}
+
+const std::vector<std::string> &serialLines() {
+  return lines;
+}
+
+bool serialContains(const char *text) {
+  for(const std::string &line : lines) {
+    if(line.find(text) != std::string::npos) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void clearSerial() {
+  lines.clear();
+}
+
+void attachI2C(uint8_t address, I2CDevice *device) {
+  i2cDevices[address & 0x7F] = device;
+}
+
+void attachSpi(int interface, pin_t select, SpiDevice *device) {
+  spiDevices.push_back({interface, select, device});
+}
+
+unsigned getSpiClock(int interface) {
+  return spiClock[interface];
+}
+
+void attachSoftSpi(pin_t clock, pin_t select, pin_t miso, SpiDevice *device) {
+  softSpiDevices.push_back({clock, select, miso, device, {}, 0});
+}
+
+void setGpioCost(unsigned ns) {
+  gpioCost = ns;
+}
+
+void attachSerial(int index, SerialDevice *device) {
+  serialDevices[index] = device;
+}
+
+void attachTcp(TcpPeer *peer) {
+  tcpPeer = peer;
+}
+
+void setNetwork(bool ready, IPAddress resolved) {
+  wifiReady = ready;
+  resolvedAddress = resolved;
+}
+
+void setNetworkDelays(unsigned resolveMs, unsigned connectMs) {
+  resolveDelay = resolveMs;
+  connectDelay = connectMs;
+}
+
+void onSleep(std::function<SystemSleepWakeupReason(const SystemSleepConfiguration &)> fn) {
+  sleepHook = fn;
+}
+
+unsigned sleepCount() {
+  return sleeps;
+}
+
+void reset() {
+  clockUs = 0;
+  readCost = 1;
+  deadline = UINT64_MAX;
+  events.clear();
+  nextEvent = UINT64_MAX;
+  for(int i = 0; i < TOTAL_PINS; i++) {
+    pins[i] = {INPUT, LOW, false, NULL, CHANGE};
+  }
+  lines.clear();
+  verbose = getenv("V") != NULL && atoi(getenv("V")) != 0;
+  if(verbose) {
+    setvbuf(stdout, NULL, _IOLBF, 0);
+  }
+  memset(i2cDevices, 0, sizeof(i2cDevices));
+  spiDevices.clear();
+  softSpiDevices.clear();
+  gpioCost = 0;
+  gpioNs = 0;
+  for(int i = 0; i < HAL_PLATFORM_SPI_NUM; i++) {
+    spiClock[i] = 4000000;
+    dmaBusy[i] = false;
+  }
+  serialDevices[0] = serialDevices[1] = NULL;
+  tcpPeer = NULL;
+  wifiReady = true;
+  resolvedAddress = IPAddress(10, 0, 0, 1);
+  resolveDelay = 0;
+  connectDelay = 0;
+  sleepHook = NULL;
+  sleeps = 0;
+  timeValid = true;
+  randomSource.seed(1);
+}
+
+// Static initialisation leaves everything at power on before any firmware constructor runs
+struct powerOn {
+  powerOn() { reset(); }
+} powerOnState __attribute__((init_priority(101)));
+
+}
+
+/**************************** Time ****************************/
+
+system_tick_t millis() {
+  host::advance(readCost);
+  return clockUs / 1000;
+}
+
+system_tick_t micros() {
+  host::advance(readCost);
+  return clockUs;
+}
+
+void delay(unsigned long ms) {
+  if(currentThread != NULL) {
+    currentThread->sleep((uint64_t)ms * 1000);
+    return;
+  }
+  host::advance((uint64_t)ms * 1000 + readCost);
+}
+
+void delayMicroseconds(unsigned int us) {
+  host::advance(us);
+}
+
+bool waitCondition(std::function<bool()> condition, unsigned long timeout) {
+  system_tick_t start = millis();
+  while(!condition()) {
+    if(millis() - start >= timeout) {
+      return false;
+    }
+    delay(1);
+  }
+  return true;
+}
+
+uint64_t SystemClass::millis() {
+  host::advance(readCost);
+  return clockUs / 1000;
+}
+
+SystemSleepResult SystemClass::sleep(const SystemSleepConfiguration &config) {
+  sleeps++;
+  if(sleepHook) {
+    return SystemSleepResult(sleepHook(config));
+  }
+  return SystemSleepResult(SystemSleepWakeupReason::BY_GPIO);
+}
+
+void SystemClass::reset() {
+  fprintf(stderr, "System.reset() at %.3f s\n", clockUs / 1e6);
+  exit(3);
+}
+
+// Until the clock is set it counts from 1970, like the RTC after a cold boot
+time32_t TimeClass::now() {
+  return (timeValid ? EPOCH : 0) + clockUs / 1000000;
+}
+
+bool TimeClass::isValid() {
+  return timeValid;
+}
+
+String TimeClass::timeStr(time32_t t) {
+  return format(t, TIME_FORMAT_DEFAULT);
+}
+
+String TimeClass::format(time32_t t, const char *format) {
+  char buffer[64];
+  time_t local;
+  struct tm parts;
+
+  local = (t ? t : now()) + (time_t)(_zone * 3600);
+  gmtime_r(&local, &parts);
+  if(strcmp(format, TIME_FORMAT_DEFAULT) == 0) {
+    format = "%a %b %e %H:%M:%S %Y";
+  }
+  strftime(buffer, sizeof(buffer), format, &parts);
+  return String(buffer);
+}
+
+/**************************** Threads ****************************/
+
+void hostThread::resume() {
+  std::unique_lock<std::mutex> guard(lock);
+  running = true;
+  turn.notify_all();
+  turn.wait(guard, [this]() { return !running; });
+}
+
+void hostThread::sleep(uint64_t us) {
+  host::schedule(clockUs + us, [this]() { resume(); });
+  std::unique_lock<std::mutex> guard(lock);
+  running = false;
+  turn.notify_all();
+  turn.wait(guard, [this]() { return running; });
+}
+
+Thread::Thread(const char *name, std::function<void()> function, os_thread_prio_t priority, size_t stack_size) {
+  (void)name;
+  (void)priority;
+  (void)stack_size;
+  _thread = new hostThread;
+  hostThread *thread = _thread;
+  thread->worker = std::thread([thread, function]() {
+    {
+      std::unique_lock<std::mutex> guard(thread->lock);
+      thread->turn.wait(guard, [thread]() { return thread->running; });
+    }
+    currentThread = thread;
+    function();
+    std::unique_lock<std::mutex> guard(thread->lock);
+    thread->done = true;
+    thread->running = false;
+    thread->turn.notify_all();
+  });
+  // A new thread gets to run straight away, up to its first delay
+  thread->resume();
+}
+
+Thread::~Thread() {
+  join();
+  _thread->worker.join();
+  delete _thread;
+}
+
+bool Thread::join() {
+  while(!_thread->done) {
+    delay(1);
+  }
+  return true;
+}
+
+/**************************** GPIO ****************************/
+
+// Out of range pins, like an unwired reset at -1, are ignored as on the device
+void pinMode(pin_t pin, PinMode mode) {
+  if(pin >= TOTAL_PINS) {
+    return;
+  }
+  pins[pin].mode = mode;
+  if(!pins[pin].driven && mode == INPUT_PULLUP) {
+    pins[pin].level = HIGH;
+  }
+  if(!pins[pin].driven && mode == INPUT_PULLDOWN) {
+    pins[pin].level = LOW;
+  }
+}
+
+PinMode getPinMode(pin_t pin) {
+  return pin < TOTAL_PINS ? pins[pin].mode : PIN_MODE_NONE;
+}
+
+void digitalWrite(pin_t pin, uint8_t value) {
+  gpioCall();
+  if(pin < TOTAL_PINS) {
+    int from = pins[pin].level;
+    pins[pin].level = value ? HIGH : LOW;
+    softSpiEdge(pin, from, pins[pin].level);
+  }
+}
+
+int32_t digitalRead(pin_t pin) {
+  gpioCall();
+  return pin < TOTAL_PINS ? pins[pin].level : LOW;
+}
+
+void shiftOut(pin_t dataPin, pin_t clockPin, uint8_t bitOrder, uint8_t value) {
+  for(int i = 0; i < 8; i++) {
+    digitalWrite(dataPin, bitOrder == LSBFIRST ? (value >> i) & 1 : (value >> (7 - i)) & 1);
+    digitalWrite(clockPin, HIGH);
+    digitalWrite(clockPin, LOW);
+  }
+}
+
+bool attachInterrupt(pin_t pin, void (*handler)(), InterruptMode mode) {
+  if(pin >= TOTAL_PINS) {
+    return false;
+  }
+  pins[pin].handler = handler;
+  pins[pin].edge = mode;
+  return true;
+}
+
+void detachInterrupt(pin_t pin) {
+  if(pin >= TOTAL_PINS) {
+    return;
+  }
+  pins[pin].handler = NULL;
+}
+
+long random(long howBig) {
+  return howBig > 0 ? randomSource() % howBig : 0;
+}
+
+long random(long howSmall, long howBig) {
+  return howBig > howSmall ? howSmall + random(howBig - howSmall) : howSmall;
+}
+
+void randomSeed(unsigned int seed) {
+  randomSource.seed(seed);
+}
+
+char *ultoa(unsigned long value, char *buffer, int base) {
+  char digits[sizeof(long) * 8 + 1];
+  int n = 0;
+
+  do {
+    digits[n++] = "0123456789abcdefghijklmnopqrstuvwxyz"[value % base];
+    value /= base;
+  } while(value > 0);
+  for(int i = 0; i < n; i++) {
+    buffer[i] = digits[n - 1 - i];
+  }
+  buffer[n] = 0;
+  return buffer;
+}
+
+char *ltoa(long value, char *buffer, int base) {
+  if(value < 0 && base == 10) {
+    buffer[0] = '-';
+    ultoa(-(unsigned long)value, buffer + 1, base);
+    return buffer;
+  }
+  return ultoa(value, buffer, base);
+}
+
+char *itoa(int value, char *buffer, int base) {
+  return ltoa(value, buffer, base);
+}
+
+/**************************** String ****************************/
+
+String::String(int value, int base) {
+  char buffer[40];
+  _s = ltoa(value, buffer, base);
+}
+
+String::String(unsigned int value, int base) {
+  char buffer[40];
+  _s = ultoa(value, buffer, base);
+}
+
+String::String(long value, int base) {
+  char buffer[72];
+  _s = ltoa(value, buffer, base);
+}
+
+String::String(unsigned long value, int base) {
+  char buffer[72];
+  _s = ultoa(value, buffer, base);
+}
+
+String::String(unsigned char value, int base) {
+  char buffer[16];
+  _s = ultoa(value, buffer, base);
+}
+
+String::String(float value, int decimals) : String((double)value, decimals) {
+}
+
+String::String(double value, int decimals) {
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+  _s = buffer;
+}
+
+String String::substring(unsigned int from) const {
+  return substring(from, _s.length());
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+  if(from > to) {
+    std::swap(from, to);
+  }
+  if(from >= _s.length()) {
+    return String();
+  }
+  return String(_s.substr(from, min((size_t)to, _s.length()) - from));
+}
+
+int String::indexOf(char c, unsigned int from) const {
+  size_t at = _s.find(c, from);
+  return at == std::string::npos ? -1 : (int)at;
+}
+
+int String::indexOf(const String &s, unsigned int from) const {
+  size_t at = _s.find(s._s, from);
+  return at == std::string::npos ? -1 : (int)at;
+}
+
+void String::toCharArray(char *buffer, unsigned int size) const {
+  getBytes((unsigned char *)buffer, size);
+}
+
+void String::getBytes(unsigned char *buffer, unsigned int size) const {
+  if(size == 0) {
+    return;
+  }
+  size_t n = min((size_t)size - 1, _s.length());
+  memcpy(buffer, _s.data(), n);
+  buffer[n] = 0;
+}
+
+void String::trim() {
+  size_t first = _s.find_first_not_of(" \t\r\n");
+  size_t last = _s.find_last_not_of(" \t\r\n");
+  _s = (first == std::string::npos) ? std::string() : _s.substr(first, last - first + 1);
+}
+
+String String::format(const char *fmt, ...) {
+  char buffer[512];
+  va_list args;
+
+  va_start(args, fmt);
+  vsnprintf(buffer, sizeof(buffer), fmt, args);
+  va_end(args);
+  return String(buffer);
+}
+
+/**************************** Print and Stream ****************************/
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  for(size_t i = 0; i < size; i++) {
+    write(buffer[i]);
+  }
+  return size;
+}
+
+size_t Print::printNumber(unsigned long value, int base) {
+  char buffer[72];
+  return write(ultoa(value, buffer, base < 2 ? 10 : base));
+}
+
+size_t Print::print(long value, int base) {
+  char buffer[72];
+  if(base != 10) {
+    return printNumber(value, base);
+  }
+  return write(ltoa(value, buffer, 10));
+}
+
+size_t Print::print(double value, int digits) {
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+  return write(buffer);
+}
+
+size_t Print::printf(const char *fmt, ...) {
+  va_list args;
+  size_t n;
+
+  va_start(args, fmt);
+  n = vprintf(fmt, args);
+  va_end(args);
+  return n;
+}
+
+size_t Print::vprintf(const char *fmt, va_list args) {
+  char buffer[512];
+  int n;
+
+  n = vsnprintf(buffer, sizeof(buffer), fmt, args);
+  if(n < 0) {
+    return 0;
+  }
+  return write((const uint8_t *)buffer, min((size_t)n, sizeof(buffer) - 1));
+}
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+  size_t count = 0;
+  system_tick_t start = millis();
+
+  while(count < length) {
+    int c = read();
+    if(c >= 0) {
+      buffer[count++] = c;
+    }
+    else if(millis() - start >= _timeout) {
+      break;
+    }
+  }
+  return count;
+}
+
+size_t USBSerial::write(uint8_t c) {
+  if(c == '\n') {
+    addLine(_line);
+    _line.clear();
+  }
+  else if(c != '\r') {
+    _line += (char)c;
+  }
+  return 1;
+}
+
+size_t USARTSerial::write(uint8_t c) {
+  if(serialDevices[_index] != NULL) {
+    serialDevices[_index]->receive(c);
+  }
+  return 1;
+}
+
+int USARTSerial::available() {
+  // Polling the UART takes time too, so a loop waiting on a reply lets the device answer
+  host::advance(readCost);
+  return serialDevices[_index] != NULL ? serialDevices[_index]->available() : 0;
+}
+
+int USARTSerial::read() {
+  return serialDevices[_index] != NULL ? serialDevices[_index]->read() : -1;
+}
+
+int USARTSerial::peek() {
+  return serialDevices[_index] != NULL ? serialDevices[_index]->peek() : -1;
+}
+
+void Logger::error(const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  logLine("[error] ", fmt, args);
+  va_end(args);
+}
+
+void Logger::warn(const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  logLine("[warn] ", fmt, args);
+  va_end(args);
+}
+
+void Logger::info(const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  logLine("[info] ", fmt, args);
+  va_end(args);
+}
+
+void Logger::trace(const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  logLine("[trace] ", fmt, args);
+  va_end(args);
+}
+
+/**************************** I2C ****************************/
+
+TwoWire::TwoWire() {
+  _address = 0;
+  _capacity = 0;
+  _txLength = _rxLength = _rxIndex = 0;
+  _transmitting = false;
+}
+
+// The buffers acquireWireBuffer() hands over are only used for their size
+size_t TwoWire::bufferSize() {
+  hal_i2c_config_t config;
+
+  if(_capacity == 0) {
+    _capacity = 32;
+    if(acquireWireBuffer) {
+      config = acquireWireBuffer();
+      _capacity = min((size_t)min(config.tx_buffer_size, config.rx_buffer_size), sizeof(_tx));
+      delete[] config.tx_buffer;
+      delete[] config.rx_buffer;
+    }
+  }
+  return _capacity;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+  _address = address & 0x7F;
+  _txLength = 0;
+  _transmitting = true;
+}
+
+size_t TwoWire::write(uint8_t c) {
+  if(!_transmitting || _txLength == bufferSize()) {
+    return 0;
+  }
+  _tx[_txLength++] = c;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while(n < size && write(buffer[n])) {
+    n++;
+  }
+  return n;
+}
+
+uint8_t TwoWire::endTransmission(bool stop) {
+  host::I2CDevice *device = i2cDevices[_address];
+  (void)stop;
+
+  _transmitting = false;
+  // Address plus the data bytes, nine bits each
+  host::advance((_txLength + 1) * 9 * I2CBITTIME / 10);
+  if(device == NULL) {
+    return 2;
+  }
+  return device->receive(_tx, _txLength) ? 0 : 3;
+}
+
+size_t TwoWire::requestFrom(uint8_t address, size_t quantity, bool stop) {
+  host::I2CDevice *device = i2cDevices[address & 0x7F];
+  (void)stop;
+
+  _rxIndex = 0;
+  _rxLength = 0;
+  quantity = min(quantity, bufferSize());
+  if(device != NULL) {
+    _rxLength = device->request(_rx, quantity);
+  }
+  host::advance((_rxLength + 1) * 9 * I2CBITTIME / 10);
+  return _rxLength;
+}
+
+/**************************** SPI ****************************/
+
+unsigned SPIClass::setClockSpeed(unsigned value, unsigned scale) {
+  spiClock[_interface] = value * scale;
+  return spiClock[_interface];
+}
+
+uint8_t SPIClass::transfer(uint8_t data) {
+  uint8_t rx = 0;
+  transfer(&data, &rx, 1, NULL);
+  return rx;
+}
+
+void SPIClass::transfer(const void *tx, void *rx, size_t length, wiring_spi_dma_transfercomplete_callback_t callback) {
+  static uint8_t zeros[4096];
+  uint64_t duration;
+  int interface = _interface;
+
+  if(rx != NULL) {
+    memset(rx, 0, length);
+  }
+  for(const spiAttachment &attached : spiDevices) {
+    if(attached.interface == _interface && (attached.select == PIN_INVALID || pins[attached.select].level == LOW)) {
+      attached.device->transfer(tx != NULL ? (const uint8_t *)tx : zeros, (uint8_t *)rx, length);
+    }
+  }
+  duration = (uint64_t)length * 8 * 1000000 / spiClock[_interface];
+  if(callback == NULL) {
+    host::advance(duration);
+    return;
+  }
+  // DMA, the callback runs from "interrupt" once the last bit is out
+  dmaBusy[interface] = true;
+  host::schedule(clockUs + duration, [interface, callback]() {
+    dmaBusy[interface] = false;
+    callback();
+  });
+}
+
+void hal_spi_begin_ext(int interface, int mode, pin_t ss, const hal_spi_config_t *config) {
+  (void)interface;
+  (void)mode;
+  (void)ss;
+  (void)config;
+}
+
+bool hal_spi_is_dma_busy(int interface) {
+  return dmaBusy[interface];
+}
+
+/**************************** Network ****************************/
+
+bool WiFiClass::ready() {
+  return wifiReady;
+}
+
+IPAddress WiFiClass::resolve(const char *name) {
+  (void)name;
+  delay(resolveDelay);
+  return wifiReady ? resolvedAddress : IPAddress();
+}
+
+int TCPClient::connect(const char *host, uint16_t port) {
+  IPAddress ip = WiFi.resolve(host);
+  if(!ip) {
+    return 0;
+  }
+  return connect(ip, port);
+}
+
+int TCPClient::connect(IPAddress ip, uint16_t port) {
+  (void)port;
+  stop();
+  delay(connectDelay);
+  if(!wifiReady || !ip || tcpPeer == NULL || !tcpPeer->accept()) {
+    return 0;
+  }
+  _connected = true;
+  return 1;
+}
+
+uint8_t TCPClient::connected() {
+  if(_connected && (tcpPeer == NULL || !tcpPeer->connected())) {
+    _connected = false;
+  }
+  return _connected;
+}
+
+void TCPClient::stop() {
+  if(_connected && tcpPeer != NULL) {
+    tcpPeer->close();
+  }
+  _connected = false;
+}
+
+size_t TCPClient::write(const uint8_t *buffer, size_t size) {
+  if(!connected()) {
+    return 0;
+  }
+  tcpPeer->receive(buffer, size);
+  return size;
+}
+
+int TCPClient::available() {
+  return connected() ? tcpPeer->available() : 0;
+}
+
+int TCPClient::read() {
+  return available() > 0 ? tcpPeer->read() : -1;
+}
+
+int TCPClient::read(uint8_t *buffer, size_t size) {
+  size_t n = 0, ready = available();
+  while(n < size && n < ready) {
+    buffer[n++] = tcpPeer->read();
+  }
+  return n > 0 ? (int)n : -1;
+}
+
+int TCPClient::peek() {
+  return -1;
+}
@@ -0,0 +1,496 @@
+// Host stand-in for the parts of Device OS the firmware uses, enough to build src/ and lib/ with g++
+// and run them against the fakes in HostDevices.h. Time is virtual, see Host.h.
+#ifndef _HOST_PARTICLE_H_
+#define _HOST_PARTICLE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <ctype.h>
+#include <time.h>
+// Standard headers the host side needs come before the min and max macros below
+#include <new>
+#include <string>
+#include <vector>
+#include <deque>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#ifndef PLATFORM_ID
+#define PLATFORM_ID 32
+#endif
+#define SYSTEM_VERSION 0x05080000
+#define SYSTEM_VERSION_ALPHA(a, b, c, d) (((a) << 24) | ((b) << 16) | ((c) << 8) | (d))
+
+#define TRUE true
+#define FALSE false
+#define HIGH 1
+#define LOW 0
+#define HEX 16
+#define DEC 10
+#define F(x) x
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
+#define SYSTEM_THREAD(x)
+#define SYSTEM_MODE(x)
+#define ATOMIC_BLOCK()
+#define SINGLE_THREADED_BLOCK()
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+template<class T, class L, class H> T constrain(T value, L low, H high) {
+  return value < low ? low : (value > high ? high : value);
+}
+
+typedef uint16_t pin_t;
+typedef bool boolean;
+typedef uint8_t byte;
+typedef uint32_t system_tick_t;
+typedef int32_t time32_t;
+
+enum PinMode { INPUT = 0, OUTPUT, INPUT_PULLUP, INPUT_PULLDOWN, PIN_MODE_NONE = 0xFF };
+enum InterruptMode { CHANGE = 1, RISING, FALLING };
+
+// Photon 2 pin numbers
+enum {
+  D0 = 0, D1, D2, D3, D4, D5, D6, D7, D8, D9, D10, D11, D12, D13, D14, D15, D16, D17, D18, D19,
+  A0 = D11, A1 = D12, A2 = D13, A5 = D14,
+  SCK = D17, MISO = D16, MOSI = D15, SS = D18,
+  SCK1 = D4, MISO1 = D3, MOSI1 = D2
+};
+const int TOTAL_PINS = 32;
+#define PIN_INVALID 0xFF
+
+// Time, virtual on the host
+system_tick_t millis();
+system_tick_t micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+inline void yield() {}
+// Device OS wraps the condition in a lambda, so a member like Serial.isConnected works too
+bool waitCondition(std::function<bool()> condition, unsigned long timeout);
+#define waitFor(condition, timeout) waitCondition([] { return (condition)(); }, (timeout))
+
+// GPIO
+void pinMode(pin_t pin, PinMode mode);
+PinMode getPinMode(pin_t pin);
+void digitalWrite(pin_t pin, uint8_t value);
+int32_t digitalRead(pin_t pin);
+inline int32_t pinReadFast(pin_t pin) { return digitalRead(pin); }
+inline void pinSetFast(pin_t pin) { digitalWrite(pin, HIGH); }
+inline void pinResetFast(pin_t pin) { digitalWrite(pin, LOW); }
+void shiftOut(pin_t dataPin, pin_t clockPin, uint8_t bitOrder, uint8_t value);
+bool attachInterrupt(pin_t pin, void (*handler)(), InterruptMode mode);
+void detachInterrupt(pin_t pin);
+
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned int seed);
+
+char *itoa(int value, char *buffer, int base);
+char *ltoa(long value, char *buffer, int base);
+char *ultoa(unsigned long value, char *buffer, int base);
+
+class String {
+  std::string _s;
+
+  public:
+    String() {}
+    String(const char *s) : _s(s ? s : "") {}
+    String(const std::string &s) : _s(s) {}
+    String(char c) : _s(1, c) {}
+    String(int value, int base = 10);
+    String(unsigned int value, int base = 10);
+    String(long value, int base = 10);
+    String(unsigned long value, int base = 10);
+    String(unsigned char value, int base = 10);
+    String(float value, int decimals = 2);
+    String(double value, int decimals = 2);
+
+    const char *c_str() const { return _s.c_str(); }
+    unsigned int length() const { return _s.length(); }
+    char charAt(unsigned int index) const { return index < _s.length() ? _s[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String &s, unsigned int from = 0) const;
+    bool startsWith(const String &s) const { return _s.compare(0, s._s.length(), s._s) == 0; }
+    bool equals(const String &s) const { return _s == s._s; }
+    long toInt() const { return atol(_s.c_str()); }
+    float toFloat() const { return atof(_s.c_str()); }
+    void toCharArray(char *buffer, unsigned int size) const;
+    void getBytes(unsigned char *buffer, unsigned int size) const;
+    void trim();
+    void reserve(unsigned int size) { _s.reserve(size); }
+
+    bool operator==(const String &s) const { return _s == s._s; }
+    bool operator==(const char *s) const { return _s == (s ? s : ""); }
+    bool operator!=(const String &s) const { return _s != s._s; }
+    bool operator!=(const char *s) const { return !(*this == s); }
+    String &operator+=(const String &s) { _s += s._s; return *this; }
+    String &operator+=(const char *s) { _s += (s ? s : ""); return *this; }
+    String &operator+=(char c) { _s += c; return *this; }
+    String &concat(const String &s) { return *this += s; }
+    friend String operator+(const String &a, const String &b) { return String(a._s + b._s); }
+    friend String operator+(const String &a, const char *b) { return String(a._s + (b ? b : "")); }
+    friend String operator+(const char *a, const String &b) { return String((a ? a : "") + b._s); }
+
+    static String format(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+};
+
+class Print {
+  size_t printNumber(unsigned long value, int base);
+
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+    size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+
+    size_t print(const char *s) { return write(s); }
+    size_t print(const String &s) { return write(s.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC) { return printNumber(value, base); }
+    size_t print(double value, int digits = 2);
+    size_t println() { return write("\r\n"); }
+    template<class T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template<class T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+    size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+    size_t vprintf(const char *fmt, va_list args);
+};
+
+class Stream : public Print {
+  protected:
+    unsigned long _timeout = 1000;
+
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() = 0;
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+    size_t readBytes(char *buffer, size_t length);
+};
+
+// USB serial, the debug log. Output goes to the host log, see Host.h.
+class USBSerial : public Stream {
+  std::string _line;
+
+  public:
+    void begin(long baud = 9600) { (void)baud; }
+    void end() {}
+    bool isConnected() { return true; }
+    size_t write(uint8_t c) override;
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    void flush() override {}
+};
+
+// Hardware UART, connected to whatever host::attachSerial() put on the other end
+class USARTSerial : public Stream {
+  int _index;
+
+  public:
+    USARTSerial(int index) : _index(index) {}
+    void begin(long baud) { (void)baud; }
+    void end() {}
+    size_t write(uint8_t c) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override {}
+};
+typedef USARTSerial HardwareSerial;
+
+extern USBSerial Serial;
+extern USARTSerial Serial1;
+
+class Logger {
+  public:
+    void error(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+    void warn(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+    void info(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+    void trace(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+extern Logger Log;
+
+// I2C master, transactions go to the host::I2CDevice at the address
+typedef struct {
+  uint16_t size;
+  uint16_t version;
+  uint8_t *rx_buffer;
+  uint32_t rx_buffer_size;
+  uint8_t *tx_buffer;
+  uint32_t tx_buffer_size;
+} hal_i2c_config_t;
+#define HAL_I2C_CONFIG_VERSION_1 1
+
+// Defined by the application to give Wire bigger buffers, Wire has 32 bytes without it
+hal_i2c_config_t acquireWireBuffer() __attribute__((weak));
+
+class TwoWire : public Stream {
+  uint8_t _address;
+  uint8_t _tx[256], _rx[256];
+  size_t _capacity;            // Bytes Wire takes per transaction, 0 until the first one
+  size_t _txLength, _rxLength, _rxIndex;
+  bool _transmitting;
+
+  public:
+    TwoWire();
+    void begin() {}
+    void end() {}
+    bool isEnabled() { return true; }
+    void setSpeed(uint32_t speed) { (void)speed; }
+    void setClock(uint32_t speed) { (void)speed; }
+    size_t bufferSize();
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+    uint8_t endTransmission(bool stop = true);
+    size_t requestFrom(uint8_t address, size_t quantity, bool stop = true);
+    size_t requestFrom(int address, int quantity, int stop = true) { return requestFrom((uint8_t)address, (size_t)quantity, (bool)stop); }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    size_t write(int c) { return write((uint8_t)c); }
+    using Print::write;
+    int available() override { return _rxLength - _rxIndex; }
+    int read() override { return _rxIndex < _rxLength ? _rx[_rxIndex++] : -1; }
+    int peek() override { return _rxIndex < _rxLength ? _rx[_rxIndex] : -1; }
+    void flush() override {}
+};
+extern TwoWire Wire;
+
+// SPI master, transfers go to the host::SpiDevice on the interface, DMA transfers complete later
+#define MSBFIRST 1
+#define LSBFIRST 0
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x01
+#define SPI_MODE2 0x02
+#define SPI_MODE3 0x03
+#define SPI_CLOCK_DIV2 0
+#define SPI_CLOCK_DIV4 1
+#define SPI_CLOCK_DIV8 2
+#define SPI_CLOCK_DIV16 3
+#define SPI_CLOCK_DIV32 4
+#define SPI_CLOCK_DIV64 5
+#define SPI_CLOCK_DIV128 6
+#define SPI_CLOCK_DIV256 7
+#define SPI_DEFAULT_SS 0xFF
+#define HAL_PLATFORM_SPI_NUM 2
+#define HAL_SPI_INTERFACE1 0
+#define HAL_SPI_INTERFACE2 1
+#define SPI_MODE_MASTER 0
+#define HAL_SPI_CONFIG_VERSION 1
+#define HAL_SPI_CONFIG_FLAG_MOSI_ONLY 0x01
+
+typedef void (*wiring_spi_dma_transfercomplete_callback_t)(void);
+typedef void (*hal_spi_dma_user_callback)(void);
+
+typedef struct {
+  uint16_t size;
+  uint16_t version;
+  uint32_t flags;
+} hal_spi_config_t;
+
+class SPISettings {
+  public:
+    uint32_t clock = 0;
+
+    SPISettings() {}
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) : clock(clock) { (void)bitOrder; (void)dataMode; }
+};
+
+class SPIClass {
+  int _interface;
+
+  public:
+    SPIClass(int interface) : _interface(interface) {}
+    int interface() { return _interface; }
+    void begin() {}
+    void begin(uint16_t ss) { (void)ss; }
+    void end() {}
+    bool isEnabled() { return true; }
+    void beginTransaction() {}
+    void beginTransaction(const SPISettings &settings) { if(settings.clock) setClockSpeed(settings.clock); }
+    void endTransaction() {}
+    void setBitOrder(uint8_t order) { (void)order; }
+    void setDataMode(uint8_t mode) { (void)mode; }
+    void setClockDivider(uint8_t divider) { (void)divider; }
+    unsigned setClockSpeed(unsigned value, unsigned scale = 1);
+    uint8_t transfer(uint8_t data);
+    void transfer(const void *tx, void *rx, size_t length, wiring_spi_dma_transfercomplete_callback_t callback);
+    void transferCancel() {}
+};
+extern SPIClass SPI;
+extern SPIClass SPI1;
+
+void hal_spi_begin_ext(int interface, int mode, pin_t ss, const hal_spi_config_t *config);
+bool hal_spi_is_dma_busy(int interface);
+
+class IPAddress {
+  uint8_t _address[4];
+
+  public:
+    // constexpr so a global one is set before any constructor runs and power on can't be undone
+    constexpr IPAddress() : _address{0, 0, 0, 0} {}
+    constexpr IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _address{a, b, c, d} {}
+    operator bool() const { return _address[0] | _address[1] | _address[2] | _address[3]; }
+    uint8_t operator[](int index) const { return _address[index]; }
+    bool operator==(const IPAddress &other) const { return memcmp(_address, other._address, sizeof(_address)) == 0; }
+};
+
+typedef uint8_t os_thread_prio_t;
+#define OS_THREAD_PRIORITY_DEFAULT 2
+#define OS_THREAD_STACK_SIZE_DEFAULT 3072
+
+// Device OS thread. It takes turns with the main thread instead of running alongside it, so runs stay
+// repeatable: the thread runs until it calls delay() or returns, and is picked up again once the
+// virtual clock has passed the delay. A blocking call on the thread costs the main thread nothing.
+struct hostThread;
+class Thread {
+  hostThread *_thread;
+
+  public:
+    Thread(const char *name, std::function<void()> function, os_thread_prio_t priority = OS_THREAD_PRIORITY_DEFAULT,
+           size_t stack_size = OS_THREAD_STACK_SIZE_DEFAULT);
+    ~Thread();
+    bool join();
+};
+
+// TCP connection to the host::TcpPeer on the other end, see Host.h
+class TCPClient : public Stream {
+  bool _connected;
+
+  public:
+    TCPClient() : _connected(false) {}
+    int connect(const char *host, uint16_t port);
+    int connect(IPAddress ip, uint16_t port);
+    uint8_t connected();
+    int status() { return connected(); }
+    void stop();
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int read(uint8_t *buffer, size_t size);
+    int peek() override;
+    void flush() override {}
+};
+
+#define TIME_FORMAT_DEFAULT "asctime"
+#define TIME_FORMAT_ISO8601_FULL "%Y-%m-%dT%H:%M:%S%z"
+
+class TimeClass {
+  float _zone = 0;
+
+  public:
+    void zone(float offset) { _zone = offset; }
+    time32_t now();
+    String timeStr(time32_t t = 0);
+    String format(time32_t t, const char *format);
+    bool isValid();
+};
+extern TimeClass Time;
+
+class CloudClass {
+  public:
+    template<class F> bool function(const char *name, F function) { (void)name; (void)function; return true; }
+    template<class T> bool variable(const char *name, const T &value) { (void)name; (void)value; return true; }
+    bool publish(const char *name, const char *data = NULL) { (void)name; (void)data; return false; }
+    bool syncTime() { return true; }
+    bool connected() { return false; }
+    void connect() {}
+    void disconnect() {}
+    void process() {}
+};
+extern CloudClass Particle;
+
+class WiFiClass {
+  public:
+    void on() {}
+    void off() {}
+    void connect() {}
+    void disconnect() {}
+    bool connecting() { return false; }
+    bool ready();
+    IPAddress resolve(const char *name);
+};
+extern WiFiClass WiFi;
+
+enum class SystemSleepMode { STOP, ULTRA_LOW_POWER, HIBERNATE };
+enum class SystemSleepWakeupReason { UNKNOWN, BY_GPIO, BY_RTC };
+
+class SystemSleepConfiguration {
+  public:
+    SystemSleepMode sleepMode = SystemSleepMode::STOP;
+    pin_t wakePin = PIN_INVALID;
+    unsigned long sleepDuration = 0;
+
+    SystemSleepConfiguration &mode(SystemSleepMode mode) { sleepMode = mode; return *this; }
+    SystemSleepConfiguration &gpio(pin_t pin, InterruptMode mode) { (void)mode; wakePin = pin; return *this; }
+    SystemSleepConfiguration &duration(unsigned long ms) { sleepDuration = ms; return *this; }
+};
+
+class SystemSleepResult {
+  SystemSleepWakeupReason _reason;
+
+  public:
+    SystemSleepResult(SystemSleepWakeupReason reason = SystemSleepWakeupReason::UNKNOWN) : _reason(reason) {}
+    SystemSleepWakeupReason wakeupReason() const { return _reason; }
+};
+
+class SystemClass {
+  public:
+    uint64_t millis();
+    SystemSleepResult sleep(const SystemSleepConfiguration &config);
+    uint32_t freeMemory() { return 256 * 1024; }
+    void reset();
+};
+extern SystemClass System;
+
+class ApplicationWatchdog {
+  public:
+    ApplicationWatchdog(unsigned timeout, void (*handler)(), unsigned stackSize = 512) { (void)timeout; (void)handler; (void)stackSize; }
+    static void checkin() {}
+};
+
+class Timer {
+  public:
+    Timer(unsigned period, void (*handler)(), bool oneShot = false) { (void)period; (void)handler; (void)oneShot; }
+    void start() {}
+    void stop() {}
+};
+
+class EEPROMClass {
+  uint8_t _data[4096];
+
+  public:
+    EEPROMClass() { memset(_data, 0xFF, sizeof(_data)); }
+    size_t length() { return sizeof(_data); }
+    uint8_t read(int address) { return _data[address]; }
+    void write(int address, uint8_t value) { _data[address] = value; }
+    template<class T> T &get(int address, T &value) { memcpy(&value, _data + address, sizeof(T)); return value; }
+    template<class T> const T &put(int address, const T &value) { memcpy(_data + address, &value, sizeof(T)); return value; }
+    void clear() { memset(_data, 0xFF, sizeof(_data)); }
+};
+extern EEPROMClass EEPROM;
+
+#endif // _HOST_PARTICLE_H_
@@ -0,0 +1,5 @@
+// Placeholder broker login for the host build, the device build uses the real src/credentials.h
+#define AIO_SERVER "io.adafruit.com"
+#define AIO_SERVERPORT 1883
+#define AIO_USERNAME "user"
+#define AIO_KEY "key"
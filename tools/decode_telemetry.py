@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+"""Decodes smartcookertelemetry frames back into a cook curve.
+
+Reads base64 frames, one per line (an Adafruit IO feed export or a copy of the
+MQTT payloads), and prints CSV. See src/Telemetry.h for the frame layout.
+controlIntervalMs is the time between the heater control task's last two runs
+before the sample, so it shows the jitter the control loop actually saw.
+
+    python3 tools/decode_telemetry.py frames.txt > cook.csv
+"""
+import base64
+import csv
+import sys
+from datetime import datetime, timezone
+
+FIELDS = ["time", "tempF", "setpointF", "relay", "dutySeconds", "controlIntervalMs", "nfcErrors", "mqttFailures"]
+SIGNED = {"tempF", "setpointF", "controlIntervalMs"}
+
+
+def varints(data, pos):
+    while pos < len(data):
+        value = shift = 0
+        while True:
+            byte = data[pos]
+            pos += 1
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                break
+        yield value
+
+
+def decode_frame(data):
+    if data[0] != 1:
+        raise ValueError("unsupported telemetry version %d" % data[0])
+    count = data[1]
+    values = varints(data, 2)
+    last = dict.fromkeys(FIELDS, 0)
+    for _ in range(count):
+        sample = {}
+        for field in FIELDS:
+            value = next(values)
+            if field in SIGNED:
+                value = (value >> 1) ^ -(value & 1)
+            sample[field] = value if field == "relay" else last[field] + value
+        last = sample
+        row = dict(sample)
+        row["time"] = datetime.fromtimestamp(sample["time"], timezone.utc).isoformat()
+        row["tempF"] = sample["tempF"] / 10.0
+        yield row
+
+
+def main():
+    source = open(sys.argv[1]) if len(sys.argv) > 1 else sys.stdin
+    out = csv.DictWriter(sys.stdout, FIELDS)
+    out.writeheader()
+    for line in source:
+        line = line.strip()
+        if line:
+            out.writerows(decode_frame(base64.b64decode(line)))
+
+
+if __name__ == "__main__":
+    main()